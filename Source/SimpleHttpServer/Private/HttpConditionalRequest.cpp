@@ -0,0 +1,125 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpConditionalRequest.h"
+#include "Hash/CityHash.h"
+
+const TCHAR* FHttpConditionalRequest::ETagHeader = TEXT("etag");
+const TCHAR* FHttpConditionalRequest::LastModifiedHeader = TEXT("last-modified");
+
+namespace
+{
+	// Weak comparison, W/ prefix is ignored
+	FStringView StripWeakPrefix(FStringView ETag)
+	{
+		ETag.TrimStartAndEndInline();
+		if (ETag.StartsWith(TEXT("W/")))
+		{
+			ETag.RightChopInline(2);
+		}
+
+		return ETag;
+	}
+}
+
+FHttpConditionalRequest::FHttpConditionalRequest(const FHttpServerRequest& Request)
+{
+	// Header values can be split by comma into several entries
+	if (const TArray<FString>* Values = Request.Headers.Find(TEXT("if-none-match")))
+	{
+		IfNoneMatch = FString::Join(*Values, TEXT(","));
+	}
+
+	IfModifiedSince = FindHeader(Request.Headers, TEXT("if-modified-since"));
+}
+
+bool FHttpConditionalRequest::IsNotModified(const TMap<FString, TArray<FString>>& ResponseHeaders) const
+{
+	if (!IfNoneMatch.IsEmpty())
+	{
+		const FStringView ETag = FindHeader(ResponseHeaders, ETagHeader);
+		if (ETag.IsEmpty())
+		{
+			return false;
+		}
+
+		const FStringView ResponseETag = StripWeakPrefix(ETag);
+
+		FStringView Remaining = IfNoneMatch;
+		while (!Remaining.IsEmpty())
+		{
+			int32 Comma = INDEX_NONE;
+			if (!Remaining.FindChar(TEXT(','), Comma))
+			{
+				Comma = Remaining.Len();
+			}
+
+			const FStringView Candidate = StripWeakPrefix(Remaining.Left(Comma));
+			if (Candidate == TEXT("*") || Candidate.Equals(ResponseETag, ESearchCase::CaseSensitive))
+			{
+				return true;
+			}
+
+			Remaining.RightChopInline(Comma + 1);
+		}
+
+		return false;
+	}
+
+	if (!IfModifiedSince.IsEmpty())
+	{
+		const FStringView LastModified = FindHeader(ResponseHeaders, LastModifiedHeader);
+
+		FDateTime LastModifiedTime;
+		FDateTime IfModifiedSinceTime;
+		if (!LastModified.IsEmpty()
+			&& FDateTime::ParseHttpDate(FString(LastModified), LastModifiedTime)
+			&& FDateTime::ParseHttpDate(IfModifiedSince, IfModifiedSinceTime))
+		{
+			return LastModifiedTime <= IfModifiedSinceTime;
+		}
+	}
+
+	return false;
+}
+
+TUniquePtr<FHttpServerResponse> FHttpConditionalRequest::MakeNotModified(const TMap<FString, TArray<FString>>& ResponseHeaders)
+{
+	TUniquePtr<FHttpServerResponse> Response = MakeUnique<FHttpServerResponse>();
+	Response->Code = EHttpServerResponseCodes::NotModified;
+
+	static const TCHAR* KeptHeaders[] = { ETagHeader, LastModifiedHeader, TEXT("cache-control"), TEXT("expires"), TEXT("vary") };
+	for (const TCHAR* HeaderName : KeptHeaders)
+	{
+		if (const TArray<FString>* Values = ResponseHeaders.Find(HeaderName))
+		{
+			Response->Headers.Add(HeaderName, *Values);
+		}
+	}
+
+	return Response;
+}
+
+FString FHttpConditionalRequest::ComputeETag(TArrayView<const uint8> Body)
+{
+	const uint64 Hash = CityHash64(reinterpret_cast<const char*>(Body.GetData()), Body.Num());
+	return FString::Printf(TEXT("\"%016llx\""), Hash);
+}
+
+FString FHttpConditionalRequest::MakeVersionETag(uint64 Version)
+{
+	return FString::Printf(TEXT("\"v%llu\""), Version);
+}
+
+void FHttpConditionalRequest::AddETagIfMissing(FHttpServerResponse& Response)
+{
+	if (!Response.Headers.Contains(ETagHeader))
+	{
+		Response.Headers.Add(ETagHeader, TArray<FString>{ ComputeETag(Response.Body) });
+	}
+}
+
+FStringView FHttpConditionalRequest::FindHeader(const TMap<FString, TArray<FString>>& Headers, const TCHAR* Name)
+{
+	const TArray<FString>* Values = Headers.Find(Name);
+	return Values && Values->Num() > 0 ? FStringView((*Values)[0]) : FStringView();
+}
@@ -0,0 +1,115 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpEventStream.h"
+#include "SimpleHttpServer.h"
+#include "HttpStreamServer.h"
+#include "HttpResponseBuilder.h"
+
+void FHttpEventStream::Publish(FStringView EventName, FStringView Data)
+{
+	Publish(FormatEvent(EventName, Data));
+}
+
+void FHttpEventStream::Publish(const TSharedRef<const TArray<uint8>>& Event)
+{
+	FScopeLock ScopeLock(&SubscribersLock);
+
+	for (const TSharedRef<FHttpStreamConnection>& Subscriber : Subscribers)
+	{
+		if (Subscriber->GetQueuedBytes() > MaxQueuedBytes)
+		{
+			UE_LOG(LogSimpleHttpServer, Warning, TEXT("Event stream subscriber %u is too slow, disconnecting it."), Subscriber->GetId());
+			Subscriber->Abort();
+			continue;
+		}
+
+		Subscriber->Send(Event);
+	}
+}
+
+void FHttpEventStream::SendKeepAlive()
+{
+	static const TSharedRef<const TArray<uint8>> KeepAlive = MakeShared<const TArray<uint8>>(TArray<uint8>({ ':', '\n', '\n' }));
+	Publish(KeepAlive);
+}
+
+TSharedRef<const TArray<uint8>> FHttpEventStream::FormatEvent(FStringView EventName, FStringView Data)
+{
+	TStringBuilder<256> Event;
+	Event << TEXT("id: ") << NextEventId++ << TEXT("\n");
+
+	if (!EventName.IsEmpty())
+	{
+		// Line breaks would start new fields of the event, name is written without them
+		Event << TEXT("event: ");
+		for (const TCHAR Char : EventName)
+		{
+			if (Char != TEXT('\r') && Char != TEXT('\n'))
+			{
+				Event.AppendChar(Char);
+			}
+		}
+		Event << TEXT("\n");
+	}
+
+	// Each line of data needs its own field. CR, LF and CRLF all end a line for EventSource.
+	do
+	{
+		int32 LineEnd = 0;
+		while (LineEnd < Data.Len() && Data[LineEnd] != TEXT('\r') && Data[LineEnd] != TEXT('\n'))
+		{
+			++LineEnd;
+		}
+
+		Event << TEXT("data: ") << Data.Left(LineEnd) << TEXT("\n");
+
+		const int32 BreakLen = LineEnd + 1 < Data.Len() && Data[LineEnd] == TEXT('\r') && Data[LineEnd + 1] == TEXT('\n') ? 2 : 1;
+		Data.RightChopInline(LineEnd + BreakLen);
+	}
+	while (!Data.IsEmpty());
+
+	Event << TEXT("\n");
+
+	TArray<uint8> Bytes;
+	FHttpResponseBuilder::AppendUtf8(Bytes, Event.ToView());
+	return MakeShared<const TArray<uint8>>(MoveTemp(Bytes));
+}
+
+int32 FHttpEventStream::GetNumSubscribers() const
+{
+	FScopeLock ScopeLock(&SubscribersLock);
+	return Subscribers.Num();
+}
+
+void FHttpEventStream::Subscribe(const TSharedRef<FHttpStreamConnection>& Connection)
+{
+	// Body runs until the connection is closed, no length and no chunking, so every subscriber gets the same bytes
+	TMap<FString, TArray<FString>> Headers;
+	Headers.Add(TEXT("content-type"), { TEXT("text/event-stream") });
+	Headers.Add(TEXT("cache-control"), { TEXT("no-cache") });
+	Headers.Add(TEXT("connection"), { TEXT("close") });
+
+	TWeakPtr<FHttpEventStream> WeakThis = AsShared();
+	const uint32 ConnectionId = Connection->GetId();
+	Connection->OnClosed = [WeakThis, ConnectionId]()
+	{
+		if (TSharedPtr<FHttpEventStream> This = WeakThis.Pin())
+		{
+			This->Unsubscribe(ConnectionId);
+		}
+	};
+
+	// Head is queued under the lock, so no event gets in front of it
+	FScopeLock ScopeLock(&SubscribersLock);
+	Connection->Send(FHttpStreamServer::MakeResponseHead(200, Headers));
+	Subscribers.Add(Connection);
+}
+
+void FHttpEventStream::Unsubscribe(uint32 ConnectionId)
+{
+	FScopeLock ScopeLock(&SubscribersLock);
+	Subscribers.RemoveAllSwap([ConnectionId](const TSharedRef<FHttpStreamConnection>& Subscriber)
+	{
+		return Subscriber->GetId() == ConnectionId;
+	}, false);
+}
@@ -0,0 +1,1075 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpJsonSerializer.h"
+#include "SimpleHttpServer.h"
+#include "HttpResponseBuilder.h"
+#include "HttpSerializationPlan.h"
+#include "UObject/TextProperty.h"
+#include "UObject/EnumProperty.h"
+#include "UObject/SoftObjectPtr.h"
+
+namespace
+{
+	void AppendAnsi(TArray<uint8>& Out, const ANSICHAR* Text, int32 Len)
+	{
+		Out.Append(reinterpret_cast<const uint8*>(Text), Len);
+	}
+
+	template<int32 N>
+	void AppendLiteral(TArray<uint8>& Out, const ANSICHAR(&Text)[N])
+	{
+		AppendAnsi(Out, Text, N - 1);
+	}
+
+	void AppendInt(TArray<uint8>& Out, int64 Value)
+	{
+		ANSICHAR Buffer[24];
+		AppendAnsi(Out, Buffer, FCStringAnsi::Snprintf(Buffer, UE_ARRAY_COUNT(Buffer), "%lld", (long long)Value));
+	}
+
+	void AppendUInt(TArray<uint8>& Out, uint64 Value)
+	{
+		ANSICHAR Buffer[24];
+		AppendAnsi(Out, Buffer, FCStringAnsi::Snprintf(Buffer, UE_ARRAY_COUNT(Buffer), "%llu", (unsigned long long)Value));
+	}
+
+	// Shortest form that reads back to the same value
+	void AppendNumber(TArray<uint8>& Out, double Value, bool bSinglePrecision)
+	{
+		if (!FMath::IsFinite(Value))
+		{
+			AppendLiteral(Out, "null");
+			return;
+		}
+
+		ANSICHAR Buffer[40];
+		int32 Len = 0;
+		if (bSinglePrecision)
+		{
+			Len = FCStringAnsi::Snprintf(Buffer, UE_ARRAY_COUNT(Buffer), "%.7g", Value);
+			if ((float)FCStringAnsi::Atod(Buffer) != (float)Value)
+			{
+				Len = FCStringAnsi::Snprintf(Buffer, UE_ARRAY_COUNT(Buffer), "%.9g", Value);
+			}
+		}
+		else
+		{
+			Len = FCStringAnsi::Snprintf(Buffer, UE_ARRAY_COUNT(Buffer), "%.15g", Value);
+			if (FCStringAnsi::Atod(Buffer) != Value)
+			{
+				Len = FCStringAnsi::Snprintf(Buffer, UE_ARRAY_COUNT(Buffer), "%.17g", Value);
+			}
+		}
+
+		AppendAnsi(Out, Buffer, Len);
+	}
+
+	void WriteValue(TArray<uint8>& Out, const FHttpValuePlan& Plan, const void* Value);
+
+	void WriteStruct(TArray<uint8>& Out, const FHttpStructPlan& Plan, const void* Data)
+	{
+		Out.Add('{');
+
+		bool bFirst = true;
+		for (const FHttpFieldPlan& Field : Plan.Fields)
+		{
+			const FProperty* Property = Field.Value.Property;
+
+			if (!bFirst)
+			{
+				Out.Add(',');
+			}
+			bFirst = false;
+
+			Out.Append(Field.JsonName);
+
+			// Static arrays are written as JSON arrays
+			if (Property->ArrayDim > 1)
+			{
+				Out.Add('[');
+				for (int32 Index = 0; Index < Property->ArrayDim; ++Index)
+				{
+					if (Index > 0)
+					{
+						Out.Add(',');
+					}
+					WriteValue(Out, Field.Value, Property->ContainerPtrToValuePtr<void>(Data, Index));
+				}
+				Out.Add(']');
+			}
+			else
+			{
+				WriteValue(Out, Field.Value, Property->ContainerPtrToValuePtr<void>(Data));
+			}
+		}
+
+		Out.Add('}');
+	}
+
+	void WriteExportedText(TArray<uint8>& Out, const FProperty* Property, const void* Value)
+	{
+		FString Text;
+		Property->ExportText_Direct(Text, Value, nullptr, nullptr, PPF_None);
+		FHttpJsonSerializer::AppendString(Out, Text);
+	}
+
+	void WriteValue(TArray<uint8>& Out, const FHttpValuePlan& Plan, const void* Value)
+	{
+		switch (Plan.Kind)
+		{
+		case EHttpValueKind::Bool:
+			if (static_cast<const FBoolProperty*>(Plan.Property)->GetPropertyValue(Value))
+			{
+				AppendLiteral(Out, "true");
+			}
+			else
+			{
+				AppendLiteral(Out, "false");
+			}
+			break;
+
+		case EHttpValueKind::SignedInt:
+			AppendInt(Out, static_cast<const FNumericProperty*>(Plan.Property)->GetSignedIntPropertyValue(Value));
+			break;
+
+		case EHttpValueKind::UnsignedInt:
+			AppendUInt(Out, static_cast<const FNumericProperty*>(Plan.Property)->GetUnsignedIntPropertyValue(Value));
+			break;
+
+		case EHttpValueKind::Float:
+			AppendNumber(Out, *static_cast<const float*>(Value), true);
+			break;
+
+		case EHttpValueKind::Double:
+			AppendNumber(Out, *static_cast<const double*>(Value), false);
+			break;
+
+		case EHttpValueKind::Enum:
+		{
+			const FEnumProperty* EnumProperty = static_cast<const FEnumProperty*>(Plan.Property);
+			const int64 EnumValue = EnumProperty->GetUnderlyingProperty()->GetSignedIntPropertyValue(Value);
+			FHttpJsonSerializer::AppendString(Out, EnumProperty->GetEnum()->GetNameStringByValue(EnumValue));
+			break;
+		}
+
+		case EHttpValueKind::ByteEnum:
+		{
+			const FByteProperty* ByteProperty = static_cast<const FByteProperty*>(Plan.Property);
+			FHttpJsonSerializer::AppendString(Out, ByteProperty->GetIntPropertyEnum()->GetNameStringByValue(*static_cast<const uint8*>(Value)));
+			break;
+		}
+
+		case EHttpValueKind::String:
+			FHttpJsonSerializer::AppendString(Out, *static_cast<const FString*>(Value));
+			break;
+
+		case EHttpValueKind::Name:
+			FHttpJsonSerializer::AppendString(Out, static_cast<const FName*>(Value)->ToString());
+			break;
+
+		case EHttpValueKind::Text:
+			FHttpJsonSerializer::AppendString(Out, static_cast<const FText*>(Value)->ToString());
+			break;
+
+		case EHttpValueKind::Struct:
+			WriteStruct(Out, *Plan.StructPlan, Value);
+			break;
+
+		case EHttpValueKind::Array:
+		{
+			FScriptArrayHelper Helper(static_cast<const FArrayProperty*>(Plan.Property), Value);
+			Out.Add('[');
+			for (int32 Index = 0; Index < Helper.Num(); ++Index)
+			{
+				if (Index > 0)
+				{
+					Out.Add(',');
+				}
+				WriteValue(Out, *Plan.Inner, Helper.GetRawPtr(Index));
+			}
+			Out.Add(']');
+			break;
+		}
+
+		case EHttpValueKind::Set:
+		{
+			FScriptSetHelper Helper(static_cast<const FSetProperty*>(Plan.Property), Value);
+			Out.Add('[');
+			bool bFirst = true;
+			for (int32 Index = 0; Index < Helper.GetMaxIndex(); ++Index)
+			{
+				if (!Helper.IsValidIndex(Index))
+				{
+					continue;
+				}
+
+				if (!bFirst)
+				{
+					Out.Add(',');
+				}
+				bFirst = false;
+
+				WriteValue(Out, *Plan.Inner, Helper.GetElementPtr(Index));
+			}
+			Out.Add(']');
+			break;
+		}
+
+		case EHttpValueKind::Map:
+		{
+			FScriptMapHelper Helper(static_cast<const FMapProperty*>(Plan.Property), Value);
+			Out.Add('{');
+			bool bFirst = true;
+			for (int32 Index = 0; Index < Helper.GetMaxIndex(); ++Index)
+			{
+				if (!Helper.IsValidIndex(Index))
+				{
+					continue;
+				}
+
+				if (!bFirst)
+				{
+					Out.Add(',');
+				}
+				bFirst = false;
+
+				// JSON keys are strings, text-like keys are written as is, others as exported text
+				const void* KeyValue = Helper.GetKeyPtr(Index);
+				switch (Plan.Key->Kind)
+				{
+				case EHttpValueKind::String:
+				case EHttpValueKind::Name:
+				case EHttpValueKind::Text:
+				case EHttpValueKind::Enum:
+				case EHttpValueKind::ByteEnum:
+					WriteValue(Out, *Plan.Key, KeyValue);
+					break;
+
+				default:
+					WriteExportedText(Out, Plan.Key->Property, KeyValue);
+					break;
+				}
+
+				Out.Add(':');
+				WriteValue(Out, *Plan.Inner, Helper.GetValuePtr(Index));
+			}
+			Out.Add('}');
+			break;
+		}
+
+		case EHttpValueKind::Object:
+		{
+			// Referenced objects are written as paths, not expanded
+			const UObject* Object = static_cast<const FObjectPropertyBase*>(Plan.Property)->GetObjectPropertyValue(Value);
+			if (Object)
+			{
+				FHttpJsonSerializer::AppendString(Out, Object->GetPathName());
+			}
+			else
+			{
+				AppendLiteral(Out, "null");
+			}
+			break;
+		}
+
+		case EHttpValueKind::SoftObject:
+			FHttpJsonSerializer::AppendString(Out, static_cast<const FSoftObjectPtr*>(Value)->ToSoftObjectPath().ToString());
+			break;
+
+		default:
+			WriteExportedText(Out, Plan.Property, Value);
+			break;
+		}
+	}
+
+	/**
+	 * Parses UTF-8 JSON straight into struct memory following a plan.
+	 * Strings are decoded once into their final FString, nothing else is allocated.
+	 */
+	class FJsonPlanReader
+	{
+	public:
+		explicit FJsonPlanReader(TArrayView<const uint8> Json)
+			: Begin(Json.GetData())
+			, Cur(Json.GetData())
+			, End(Json.GetData() + Json.Num())
+		{
+		}
+
+		bool ReadDocument(const FHttpStructPlan& Plan, void* Data)
+		{
+			// Byte order mark
+			if (End - Cur >= 3 && Cur[0] == 0xEF && Cur[1] == 0xBB && Cur[2] == 0xBF)
+			{
+				Cur += 3;
+			}
+
+			SkipWhitespace();
+			if (!ReadObject(Plan, Data))
+			{
+				return false;
+			}
+
+			SkipWhitespace();
+			return Cur == End || Fail(TEXT("Unexpected data after JSON object"));
+		}
+
+		FString Error;
+
+	private:
+		// Deeper documents are rejected instead of overflowing the stack
+		static constexpr int32 MaxDepth = 64;
+
+		bool Fail(const TCHAR* Message)
+		{
+			if (Error.IsEmpty())
+			{
+				Error = FString::Printf(TEXT("%s at offset %d"), Message, (int32)(Cur - Begin));
+			}
+			return false;
+		}
+
+		void SkipWhitespace()
+		{
+			while (Cur < End && (*Cur == ' ' || *Cur == '\t' || *Cur == '\n' || *Cur == '\r'))
+			{
+				++Cur;
+			}
+		}
+
+		bool Peek(uint8 Char)
+		{
+			SkipWhitespace();
+			return Cur < End && *Cur == Char;
+		}
+
+		bool TryConsume(uint8 Char)
+		{
+			if (!Peek(Char))
+			{
+				return false;
+			}
+
+			++Cur;
+			return true;
+		}
+
+		bool Expect(uint8 Char, const TCHAR* Message)
+		{
+			return TryConsume(Char) || Fail(Message);
+		}
+
+		bool ReadLiteral(const ANSICHAR* Literal, int32 Len)
+		{
+			if (End - Cur < Len || FMemory::Memcmp(Cur, Literal, Len) != 0)
+			{
+				return Fail(TEXT("Invalid literal"));
+			}
+
+			Cur += Len;
+			return true;
+		}
+
+		// Consumes null. Null values keep what the struct already has.
+		bool TryReadNull()
+		{
+			if (Peek('n'))
+			{
+				return ReadLiteral("null", 4);
+			}
+			return false;
+		}
+
+		bool ReadNumberToken(ANSICHAR (&Buffer)[64], bool& bOutInteger)
+		{
+			SkipWhitespace();
+
+			const uint8* Start = Cur;
+			bOutInteger = true;
+			while (Cur < End && ((*Cur >= '0' && *Cur <= '9') || *Cur == '-' || *Cur == '+' || *Cur == '.' || *Cur == 'e' || *Cur == 'E'))
+			{
+				bOutInteger &= *Cur != '.' && *Cur != 'e' && *Cur != 'E';
+				++Cur;
+			}
+
+			const int32 Len = (int32)(Cur - Start);
+			if (Len == 0 || Len >= UE_ARRAY_COUNT(Buffer))
+			{
+				return Fail(TEXT("Expected number"));
+			}
+
+			FMemory::Memcpy(Buffer, Start, Len);
+			Buffer[Len] = '\0';
+			return true;
+		}
+
+		bool ReadDouble(double& OutValue)
+		{
+			ANSICHAR Buffer[64];
+			bool bInteger = false;
+			if (!ReadNumberToken(Buffer, bInteger))
+			{
+				return false;
+			}
+
+			OutValue = FCStringAnsi::Atod(Buffer);
+			return true;
+		}
+
+		bool ReadInt(int64& OutValue)
+		{
+			ANSICHAR Buffer[64];
+			bool bInteger = false;
+			if (!ReadNumberToken(Buffer, bInteger))
+			{
+				return false;
+			}
+
+			OutValue = bInteger ? FCStringAnsi::Atoi64(Buffer) : (int64)FCStringAnsi::Atod(Buffer);
+			return true;
+		}
+
+		bool ReadUInt(uint64& OutValue)
+		{
+			ANSICHAR Buffer[64];
+			bool bInteger = false;
+			if (!ReadNumberToken(Buffer, bInteger))
+			{
+				return false;
+			}
+
+			OutValue = bInteger ? FCStringAnsi::Strtoui64(Buffer, nullptr, 10) : (uint64)FCStringAnsi::Atod(Buffer);
+			return true;
+		}
+
+		static int32 HexValue(uint8 Char)
+		{
+			if (Char >= '0' && Char <= '9') return Char - '0';
+			if (Char >= 'a' && Char <= 'f') return Char - 'a' + 10;
+			if (Char >= 'A' && Char <= 'F') return Char - 'A' + 10;
+			return -1;
+		}
+
+		bool ReadString(FString& Out)
+		{
+			if (!Expect('"', TEXT("Expected string")))
+			{
+				return false;
+			}
+
+			Out.Reset();
+
+			// Convert runs of plain characters at once, unescape the rest
+			const uint8* RunStart = Cur;
+			auto FlushRun = [&Out, &RunStart](const uint8* RunEnd)
+			{
+				if (RunEnd > RunStart)
+				{
+					FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(RunStart), (int32)(RunEnd - RunStart));
+					Out.AppendChars(Converted.Get(), Converted.Length());
+				}
+			};
+
+			while (Cur < End)
+			{
+				const uint8 Char = *Cur;
+				if (Char == '"')
+				{
+					FlushRun(Cur);
+					++Cur;
+					return true;
+				}
+
+				if (Char < 0x20)
+				{
+					return Fail(TEXT("Control character in string"));
+				}
+
+				if (Char != '\\')
+				{
+					++Cur;
+					continue;
+				}
+
+				FlushRun(Cur);
+				if (End - Cur < 2)
+				{
+					break;
+				}
+
+				const uint8 Escaped = Cur[1];
+				Cur += 2;
+
+				switch (Escaped)
+				{
+				case '"': Out.AppendChar(TEXT('"')); break;
+				case '\\': Out.AppendChar(TEXT('\\')); break;
+				case '/': Out.AppendChar(TEXT('/')); break;
+				case 'b': Out.AppendChar(TEXT('\b')); break;
+				case 'f': Out.AppendChar(TEXT('\f')); break;
+				case 'n': Out.AppendChar(TEXT('\n')); break;
+				case 'r': Out.AppendChar(TEXT('\r')); break;
+				case 't': Out.AppendChar(TEXT('\t')); break;
+				case 'u':
+				{
+					uint32 CodeUnit = 0;
+					for (int32 Index = 0; Index < 4; ++Index)
+					{
+						const int32 Digit = Cur < End ? HexValue(*Cur++) : -1;
+						if (Digit < 0)
+						{
+							return Fail(TEXT("Invalid unicode escape"));
+						}
+						CodeUnit = (CodeUnit << 4) | Digit;
+					}
+
+					// Surrogate pairs arrive as two escapes and are kept as two UTF-16 code units
+					Out.AppendChar((TCHAR)CodeUnit);
+					break;
+				}
+				default:
+					return Fail(TEXT("Invalid escape"));
+				}
+
+				RunStart = Cur;
+			}
+
+			return Fail(TEXT("Unterminated string"));
+		}
+
+		// Key of object member. Points into the document unless the key has escapes.
+		bool ReadKey(FAnsiStringView& OutKey)
+		{
+			if (!Peek('"'))
+			{
+				return Fail(TEXT("Expected member name"));
+			}
+
+			const uint8* Start = Cur + 1;
+			const uint8* KeyEnd = Start;
+			while (KeyEnd < End && *KeyEnd != '"' && *KeyEnd != '\\')
+			{
+				++KeyEnd;
+			}
+
+			if (KeyEnd < End && *KeyEnd == '"')
+			{
+				OutKey = FAnsiStringView(reinterpret_cast<const ANSICHAR*>(Start), (int32)(KeyEnd - Start));
+				Cur = KeyEnd + 1;
+				return true;
+			}
+
+			FString Key;
+			if (!ReadString(Key))
+			{
+				return false;
+			}
+
+			KeyScratch.Reset();
+			FHttpResponseBuilder::AppendUtf8(KeyScratch, Key);
+			OutKey = FAnsiStringView(reinterpret_cast<const ANSICHAR*>(KeyScratch.GetData()), KeyScratch.Num());
+			return true;
+		}
+
+		bool ReadObject(const FHttpStructPlan& Plan, void* Data)
+		{
+			if (!Expect('{', TEXT("Expected object")))
+			{
+				return false;
+			}
+
+			if (++Depth > MaxDepth)
+			{
+				return Fail(TEXT("Nesting is too deep"));
+			}
+
+			int32 Hint = 0;
+			if (!Peek('}'))
+			{
+				do
+				{
+					FAnsiStringView Key;
+					if (!ReadKey(Key) || !Expect(':', TEXT("Expected ':'")))
+					{
+						return false;
+					}
+
+					const FHttpFieldPlan* Field = Plan.Fields.Num() > 0 ? Plan.FindField(Key, Hint) : nullptr;
+					if (!Field)
+					{
+						// Unknown members are ignored like FJsonObjectConverter does
+						if (!SkipValue())
+						{
+							return false;
+						}
+						continue;
+					}
+
+					if (!ReadField(*Field, Data))
+					{
+						return false;
+					}
+				}
+				while (TryConsume(','));
+			}
+
+			--Depth;
+			return Expect('}', TEXT("Expected ',' or '}'"));
+		}
+
+		bool ReadField(const FHttpFieldPlan& Field, void* Data)
+		{
+			const FProperty* Property = Field.Value.Property;
+			if (Property->ArrayDim == 1)
+			{
+				return ReadValue(Field.Value, Property->ContainerPtrToValuePtr<void>(Data));
+			}
+
+			// Static arrays are read from JSON arrays, extra elements are an error
+			if (TryReadNull())
+			{
+				return true;
+			}
+
+			int32 Index = 0;
+			return ReadArrayElements([this, &Field, Property, Data, &Index]()
+			{
+				if (Index >= Property->ArrayDim)
+				{
+					return Fail(TEXT("Too many elements for static array"));
+				}
+				return ReadValue(Field.Value, Property->ContainerPtrToValuePtr<void>(Data, Index++));
+			});
+		}
+
+		template<typename ReadElementType>
+		bool ReadArrayElements(ReadElementType&& ReadElement)
+		{
+			if (!Expect('[', TEXT("Expected array")))
+			{
+				return false;
+			}
+
+			if (++Depth > MaxDepth)
+			{
+				return Fail(TEXT("Nesting is too deep"));
+			}
+
+			if (!Peek(']'))
+			{
+				do
+				{
+					if (!ReadElement())
+					{
+						return false;
+					}
+				}
+				while (TryConsume(','));
+			}
+
+			--Depth;
+			return Expect(']', TEXT("Expected ',' or ']'"));
+		}
+
+		bool ReadEnumValue(const UEnum* Enum, int64& OutValue)
+		{
+			if (!Peek('"'))
+			{
+				return ReadInt(OutValue);
+			}
+
+			if (!ReadString(Scratch))
+			{
+				return false;
+			}
+
+			OutValue = Enum->GetValueByNameString(Scratch);
+			return OutValue != INDEX_NONE || Fail(TEXT("Unknown enum value"));
+		}
+
+		// Value written from a JSON string by the property's own text import
+		bool ImportText(const FProperty* Property, void* Value)
+		{
+			if (!ReadString(Scratch))
+			{
+				return false;
+			}
+
+			return Property->ImportText_Direct(*Scratch, Value, nullptr, PPF_None) != nullptr || Fail(TEXT("Invalid value"));
+		}
+
+		bool ReadValue(const FHttpValuePlan& Plan, void* Value)
+		{
+			if (TryReadNull())
+			{
+				return true;
+			}
+
+			if (!Error.IsEmpty())
+			{
+				return false;
+			}
+
+			switch (Plan.Kind)
+			{
+			case EHttpValueKind::Bool:
+			{
+				const bool bValue = Peek('t');
+				if (!(bValue ? ReadLiteral("true", 4) : ReadLiteral("false", 5)))
+				{
+					return false;
+				}
+				static_cast<const FBoolProperty*>(Plan.Property)->SetPropertyValue(Value, bValue);
+				return true;
+			}
+
+			case EHttpValueKind::SignedInt:
+			{
+				int64 IntValue = 0;
+				if (!ReadInt(IntValue))
+				{
+					return false;
+				}
+				static_cast<const FNumericProperty*>(Plan.Property)->SetIntPropertyValue(Value, IntValue);
+				return true;
+			}
+
+			case EHttpValueKind::UnsignedInt:
+			{
+				uint64 IntValue = 0;
+				if (!ReadUInt(IntValue))
+				{
+					return false;
+				}
+				static_cast<const FNumericProperty*>(Plan.Property)->SetIntPropertyValue(Value, IntValue);
+				return true;
+			}
+
+			case EHttpValueKind::Float:
+			{
+				double DoubleValue = 0.0;
+				if (!ReadDouble(DoubleValue))
+				{
+					return false;
+				}
+				*static_cast<float*>(Value) = (float)DoubleValue;
+				return true;
+			}
+
+			case EHttpValueKind::Double:
+				return ReadDouble(*static_cast<double*>(Value));
+
+			case EHttpValueKind::Enum:
+			{
+				const FEnumProperty* EnumProperty = static_cast<const FEnumProperty*>(Plan.Property);
+				int64 EnumValue = 0;
+				if (!ReadEnumValue(EnumProperty->GetEnum(), EnumValue))
+				{
+					return false;
+				}
+				EnumProperty->GetUnderlyingProperty()->SetIntPropertyValue(Value, EnumValue);
+				return true;
+			}
+
+			case EHttpValueKind::ByteEnum:
+			{
+				int64 EnumValue = 0;
+				if (!ReadEnumValue(static_cast<const FByteProperty*>(Plan.Property)->GetIntPropertyEnum(), EnumValue))
+				{
+					return false;
+				}
+				*static_cast<uint8*>(Value) = (uint8)EnumValue;
+				return true;
+			}
+
+			case EHttpValueKind::String:
+				return ReadString(*static_cast<FString*>(Value));
+
+			case EHttpValueKind::Name:
+				if (!ReadString(Scratch))
+				{
+					return false;
+				}
+				*static_cast<FName*>(Value) = FName(Scratch);
+				return true;
+
+			case EHttpValueKind::Text:
+				if (!ReadString(Scratch))
+				{
+					return false;
+				}
+				*static_cast<FText*>(Value) = FText::FromString(Scratch);
+				return true;
+
+			case EHttpValueKind::Struct:
+				return ReadObject(*Plan.StructPlan, Value);
+
+			case EHttpValueKind::Array:
+			{
+				FScriptArrayHelper Helper(static_cast<const FArrayProperty*>(Plan.Property), Value);
+				Helper.EmptyValues();
+				return ReadArrayElements([this, &Plan, &Helper]()
+				{
+					const int32 Index = Helper.AddValue();
+					return ReadValue(*Plan.Inner, Helper.GetRawPtr(Index));
+				});
+			}
+
+			case EHttpValueKind::Set:
+			{
+				FScriptSetHelper Helper(static_cast<const FSetProperty*>(Plan.Property), Value);
+				Helper.EmptyElements();
+
+				// Element is hashed once read, a repeated one replaces the earlier
+				FHttpPropertyValue Element(Plan.Inner->Property);
+				return ReadArrayElements([this, &Plan, &Helper, &Element]()
+				{
+					Element.Reset();
+					if (!ReadValue(*Plan.Inner, Element.Get()))
+					{
+						return false;
+					}
+					Helper.AddElement(Element.Get());
+					return true;
+				});
+			}
+
+			case EHttpValueKind::Map:
+				return ReadMap(Plan, Value);
+
+			case EHttpValueKind::Object:
+				// Object references aren't resolved off the game thread, they keep their defaults
+				return SkipValue();
+
+			case EHttpValueKind::SoftObject:
+				if (!ReadString(Scratch))
+				{
+					return false;
+				}
+				*static_cast<FSoftObjectPtr*>(Value) = FSoftObjectPath(Scratch);
+				return true;
+
+			default:
+				return ImportText(Plan.Property, Value);
+			}
+		}
+
+		bool ReadMap(const FHttpValuePlan& Plan, void* Value)
+		{
+			if (!Expect('{', TEXT("Expected object")))
+			{
+				return false;
+			}
+
+			if (++Depth > MaxDepth)
+			{
+				return Fail(TEXT("Nesting is too deep"));
+			}
+
+			FScriptMapHelper Helper(static_cast<const FMapProperty*>(Plan.Property), Value);
+			Helper.EmptyValues();
+
+			// Key is hashed once read, a repeated one overwrites the earlier value
+			FHttpPropertyValue Key(Plan.Key->Property);
+			void* KeyValue = Key.Get();
+
+			bool bRead = true;
+			if (!Peek('}'))
+			{
+				do
+				{
+					Key.Reset();
+
+					// Keys are JSON strings, read them the way the key type was written
+					switch (Plan.Key->Kind)
+					{
+					case EHttpValueKind::String:
+					case EHttpValueKind::Name:
+					case EHttpValueKind::Text:
+					case EHttpValueKind::Enum:
+					case EHttpValueKind::ByteEnum:
+						bRead = ReadValue(*Plan.Key, KeyValue);
+						break;
+
+					default:
+						bRead = ImportText(Plan.Key->Property, KeyValue);
+						break;
+					}
+
+					bRead = bRead && Expect(':', TEXT("Expected ':'")) && ReadValue(*Plan.Inner, FHttpPropertyValue::FindOrResetMapValue(Helper, Plan.Inner->Property, KeyValue));
+				}
+				while (bRead && TryConsume(','));
+			}
+
+			--Depth;
+			return bRead && Expect('}', TEXT("Expected ',' or '}'"));
+		}
+
+		bool SkipValue()
+		{
+			if (!Peek('{') && !Peek('[') && !Peek('"'))
+			{
+				if (Peek('t'))
+				{
+					return ReadLiteral("true", 4);
+				}
+				if (Peek('f'))
+				{
+					return ReadLiteral("false", 5);
+				}
+				if (Peek('n'))
+				{
+					return ReadLiteral("null", 4);
+				}
+
+				ANSICHAR Buffer[64];
+				bool bInteger = false;
+				return ReadNumberToken(Buffer, bInteger);
+			}
+
+			if (*Cur == '"')
+			{
+				return ReadString(Scratch);
+			}
+
+			if (*Cur == '[')
+			{
+				return ReadArrayElements([this]()
+				{
+					return SkipValue();
+				});
+			}
+
+			++Cur;
+			if (++Depth > MaxDepth)
+			{
+				return Fail(TEXT("Nesting is too deep"));
+			}
+
+			if (!Peek('}'))
+			{
+				do
+				{
+					FAnsiStringView Key;
+					if (!ReadKey(Key) || !Expect(':', TEXT("Expected ':'")) || !SkipValue())
+					{
+						return false;
+					}
+				}
+				while (TryConsume(','));
+			}
+
+			--Depth;
+			return Expect('}', TEXT("Expected ',' or '}'"));
+		}
+
+		const uint8* Begin;
+		const uint8* Cur;
+		const uint8* End;
+
+		int32 Depth = 0;
+
+		// Reused for values that are converted after decoding
+		FString Scratch;
+
+		// UTF-8 of keys with escapes
+		TArray<uint8> KeyScratch;
+	};
+}
+
+void FHttpJsonSerializer::AppendStruct(TArray<uint8>& Out, const UStruct* Struct, const void* Data)
+{
+	if (!Struct || !Data)
+	{
+		AppendLiteral(Out, "null");
+		return;
+	}
+
+	WriteStruct(Out, FHttpPlanCache::Get().FindOrBuild(Struct), Data);
+}
+
+void FHttpJsonSerializer::AppendObject(TArray<uint8>& Out, const UObject* Object)
+{
+	if (!Object)
+	{
+		AppendLiteral(Out, "null");
+		return;
+	}
+
+	AppendStruct(Out, Object->GetClass(), Object);
+}
+
+void FHttpJsonSerializer::AppendProperty(TArray<uint8>& Out, const FProperty* Property, const void* Value)
+{
+	if (!Property || !Value)
+	{
+		AppendLiteral(Out, "null");
+		return;
+	}
+
+	// Only the top level is planned per call, nested structs use cached plans
+	FHttpValuePlan Plan;
+	FHttpPlanCache::BuildValuePlan(Plan, Property, [](const UStruct* Struct) -> const FHttpStructPlan&
+	{
+		return FHttpPlanCache::Get().FindOrBuild(Struct);
+	});
+
+	WriteValue(Out, Plan, Value);
+}
+
+void FHttpJsonSerializer::AppendString(TArray<uint8>& Out, FStringView Value)
+{
+	Out.Add('"');
+
+	// Copy runs of plain characters at once, escape the rest
+	int32 RunStart = 0;
+	for (int32 Index = 0; Index < Value.Len(); ++Index)
+	{
+		const TCHAR Char = Value[Index];
+		if (Char >= 0x20 && Char != TEXT('"') && Char != TEXT('\\'))
+		{
+			continue;
+		}
+
+		FHttpResponseBuilder::AppendUtf8(Out, Value.Mid(RunStart, Index - RunStart));
+		RunStart = Index + 1;
+
+		switch (Char)
+		{
+		case TEXT('"'): AppendLiteral(Out, "\\\""); break;
+		case TEXT('\\'): AppendLiteral(Out, "\\\\"); break;
+		case TEXT('\n'): AppendLiteral(Out, "\\n"); break;
+		case TEXT('\r'): AppendLiteral(Out, "\\r"); break;
+		case TEXT('\t'): AppendLiteral(Out, "\\t"); break;
+		default:
+		{
+			ANSICHAR Escaped[8];
+			AppendAnsi(Out, Escaped, FCStringAnsi::Snprintf(Escaped, UE_ARRAY_COUNT(Escaped), "\\u%04x", (uint32)Char));
+			break;
+		}
+		}
+	}
+
+	FHttpResponseBuilder::AppendUtf8(Out, Value.Mid(RunStart));
+	Out.Add('"');
+}
+
+bool FHttpJsonSerializer::ReadStruct(TArrayView<const uint8> Json, const UScriptStruct* Struct, void* Data, FString* OutError)
+{
+	if (!Struct || !Data)
+	{
+		return false;
+	}
+
+	FJsonPlanReader Reader(Json);
+	if (!Reader.ReadDocument(FHttpPlanCache::Get().FindOrBuild(Struct), Data))
+	{
+		if (OutError)
+		{
+			*OutError = MoveTemp(Reader.Error);
+		}
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,121 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpLongPoll.h"
+#include "SimpleHttpServer.h"
+#include "HttpResponseBuilder.h"
+#include "NativeHttpServerRequestView.h"
+
+const TCHAR* FHttpLongPollTopic::VersionHeader = TEXT("x-poll-version");
+
+void FHttpLongPollTopic::Publish(TArray<uint8>&& InPayload, const FString& InContentType)
+{
+	TArray<TPair<FHttpRouteCompletion, TUniquePtr<FHttpServerResponse>>> Ready;
+
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		++Version;
+		Payload = MakeShared<const TArray<uint8>>(MoveTemp(InPayload));
+		ContentType = InContentType;
+
+		// Every parked request waits for a version older than this one
+		Ready.Reserve(Waiters.Num());
+		for (FWaiter& Waiter : Waiters)
+		{
+			Ready.Emplace(MoveTemp(Waiter.Completion), MakeStateResponse());
+		}
+		Waiters.Reset();
+	}
+
+	// Completions can run route callbacks right away, keep them out of the lock
+	for (TPair<FHttpRouteCompletion, TUniquePtr<FHttpServerResponse>>& Waiter : Ready)
+	{
+		Waiter.Key.Complete(MoveTemp(Waiter.Value));
+	}
+}
+
+void FHttpLongPollTopic::Publish(FStringView Text, const FString& InContentType)
+{
+	TArray<uint8> Bytes;
+	FHttpResponseBuilder::AppendUtf8(Bytes, Text);
+	Publish(MoveTemp(Bytes), InContentType);
+}
+
+uint64 FHttpLongPollTopic::GetVersion() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Version;
+}
+
+int32 FHttpLongPollTopic::GetNumWaiting() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Waiters.Num();
+}
+
+void FHttpLongPollTopic::HandleRequest(const FNativeHttpServerRequestView& Request, FHttpRouteCompletion Completion)
+{
+	uint64 Since = 0;
+	LexFromString(Since, *FString(Request.GetQueryParam(TEXT("since"))));
+
+	TUniquePtr<FHttpServerResponse> Response;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		// Any other version is answered now, a client ahead of us (e.g. after a restart) takes the current state
+		if (Version == Since)
+		{
+			// Only the completion is kept, no thread waits for the state
+			Waiters.Add(FWaiter{ FPlatformTime::Seconds() + TimeoutSeconds, MoveTemp(Completion) });
+			return;
+		}
+
+		Response = MakeStateResponse();
+	}
+
+	Completion.Complete(MoveTemp(Response));
+}
+
+void FHttpLongPollTopic::ExpireWaiters(double Now)
+{
+	TArray<FHttpRouteCompletion> Expired;
+	uint64 CurrentVersion = 0;
+
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		CurrentVersion = Version;
+		for (int32 Index = Waiters.Num() - 1; Index >= 0; --Index)
+		{
+			if (Waiters[Index].Deadline <= Now)
+			{
+				Expired.Add(MoveTemp(Waiters[Index].Completion));
+				Waiters.RemoveAtSwap(Index, 1, false);
+			}
+		}
+	}
+
+	// Nothing new, client asks again with the same version
+	for (const FHttpRouteCompletion& Completion : Expired)
+	{
+		FHttpResponseBuilder Builder(EHttpServerResponseCodes::NoContent);
+		Builder.SetHeader(VersionHeader, LexToString(CurrentVersion));
+		Completion.Complete(MoveTemp(Builder));
+	}
+}
+
+TUniquePtr<FHttpServerResponse> FHttpLongPollTopic::MakeStateResponse() const
+{
+	FHttpResponseBuilder Builder;
+	Builder.SetHeader(TEXT("content-type"), ContentType);
+	Builder.SetHeader(TEXT("cache-control"), TEXT("no-store"));
+	Builder.SetHeader(VersionHeader, LexToString(Version));
+
+	// Each response owns its body, HTTPServer module takes it over
+	if (Payload.IsValid())
+	{
+		Builder.Append(*Payload);
+	}
+
+	return Builder.Build();
+}
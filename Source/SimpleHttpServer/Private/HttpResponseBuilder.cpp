@@ -0,0 +1,107 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpResponseBuilder.h"
+#include "HttpConditionalRequest.h"
+
+FHttpResponseBuilder::FHttpResponseBuilder(EHttpServerResponseCodes Code)
+	: Response(MakeUnique<FHttpServerResponse>())
+{
+	Response->Code = Code;
+}
+
+FHttpResponseBuilder& FHttpResponseBuilder::SetCode(EHttpServerResponseCodes Code)
+{
+	Response->Code = Code;
+	return *this;
+}
+
+FHttpResponseBuilder& FHttpResponseBuilder::SetTextContentType(FStringView ContentType)
+{
+	return SetHeader(TEXT("content-type"), FString::Printf(TEXT("%.*s;charset=utf-8"), ContentType.Len(), ContentType.GetData()));
+}
+
+FHttpResponseBuilder& FHttpResponseBuilder::SetHeader(FString Name, FString Value)
+{
+	TArray<FString> Values = { MoveTemp(Value) };
+	Response->Headers.Add(MoveTemp(Name), MoveTemp(Values));
+	return *this;
+}
+
+FHttpResponseBuilder& FHttpResponseBuilder::AddHeader(FString Name, FString Value)
+{
+	Response->Headers.FindOrAdd(MoveTemp(Name)).Add(MoveTemp(Value));
+	return *this;
+}
+
+FHttpResponseBuilder& FHttpResponseBuilder::Reserve(int32 NumBytes)
+{
+	Response->Body.Reserve(NumBytes);
+	return *this;
+}
+
+FHttpResponseBuilder& FHttpResponseBuilder::Append(TArrayView<const uint8> Bytes)
+{
+	Response->Body.Append(Bytes.GetData(), Bytes.Num());
+	return *this;
+}
+
+FHttpResponseBuilder& FHttpResponseBuilder::Append(FUtf8StringView Text)
+{
+	Response->Body.Append(reinterpret_cast<const uint8*>(Text.GetData()), Text.Len());
+	return *this;
+}
+
+FHttpResponseBuilder& FHttpResponseBuilder::Append(FStringView Text)
+{
+	AppendUtf8(Response->Body, Text);
+	return *this;
+}
+
+FHttpResponseBuilder& FHttpResponseBuilder::SetBody(TArray<uint8>&& Bytes)
+{
+	Response->Body = MoveTemp(Bytes);
+	return *this;
+}
+
+FHttpResponseBuilder& FHttpResponseBuilder::SetETag(FString ETag)
+{
+	// ETag must be quoted
+	if (!ETag.EndsWith(TEXT("\"")))
+	{
+		ETag = FString::Printf(TEXT("\"%s\""), *ETag);
+	}
+
+	return SetHeader(FHttpConditionalRequest::ETagHeader, MoveTemp(ETag));
+}
+
+FHttpResponseBuilder& FHttpResponseBuilder::SetVersionETag(uint64 Version)
+{
+	return SetHeader(FHttpConditionalRequest::ETagHeader, FHttpConditionalRequest::MakeVersionETag(Version));
+}
+
+FHttpResponseBuilder& FHttpResponseBuilder::ComputeETag()
+{
+	return SetHeader(FHttpConditionalRequest::ETagHeader, FHttpConditionalRequest::ComputeETag(Response->Body));
+}
+
+FHttpResponseBuilder& FHttpResponseBuilder::SetLastModified(const FDateTime& Time)
+{
+	return SetHeader(FHttpConditionalRequest::LastModifiedHeader, Time.ToHttpDate());
+}
+
+TUniquePtr<FHttpServerResponse> FHttpResponseBuilder::Build()
+{
+	return MoveTemp(Response);
+}
+
+void FHttpResponseBuilder::AppendUtf8(TArray<uint8>& Buffer, FStringView Text)
+{
+	if (Text.IsEmpty())
+	{
+		return;
+	}
+
+	const int32 Utf8Len = FPlatformString::ConvertedLength<UTF8CHAR>(Text.GetData(), Text.Len());
+	const int32 Offset = Buffer.AddUninitialized(Utf8Len);
+	FPlatformString::Convert(reinterpret_cast<UTF8CHAR*>(Buffer.GetData() + Offset), Utf8Len, Text.GetData(), Text.Len());
+}
@@ -0,0 +1,189 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpResponseCache.h"
+#include "HttpStructSerializer.h"
+#include "Misc/ScopeRWLock.h"
+#include "Hash/CityHash.h"
+
+namespace
+{
+	// Values are length-prefixed, so separators inside them can't make two requests share a key
+	void AppendKeyValue(FStringBuilderBase& Key, const FString* Value)
+	{
+		if (!Value)
+		{
+			Key << TEXT('-');
+			return;
+		}
+
+		Key << Value->Len() << TEXT(':') << *Value;
+	}
+}
+
+TUniquePtr<FHttpServerResponse> FHttpCachedResponse::MakeResponse(const TArray<uint8>* BodyOverride) const
+{
+	TUniquePtr<FHttpServerResponse> Response = MakeUnique<FHttpServerResponse>();
+	Response->Code = Code;
+	Response->Headers = Headers;
+	Response->Body = BodyOverride ? *BodyOverride : Body;
+	return Response;
+}
+
+FString FHttpResponseCache::MakeKey(const FHttpServerRequest& Request, FStringView RequestPath, const FHttpRouteCachePolicy& Policy)
+{
+	TStringBuilder<256> Key;
+	Key << (int32)Request.Verb << TEXT(' ') << RequestPath;
+
+	// Struct responses vary by Accept, only the negotiated format matters so raw header values don't split entries
+	Key << TEXT('#') << (int32)FHttpStructSerializer::NegotiateFormat(Request);
+
+	for (const FString& QueryParam : Policy.QueryParams)
+	{
+		Key << TEXT('&') << QueryParam << TEXT('=');
+		AppendKeyValue(Key, Request.QueryParams.Find(QueryParam));
+	}
+
+	for (const FString& Header : Policy.Headers)
+	{
+		Key << TEXT('\n') << Header << TEXT(':');
+		if (const TArray<FString>* Values = Request.Headers.Find(Header))
+		{
+			Key << Values->Num();
+			for (const FString& Value : *Values)
+			{
+				Key << TEXT(',');
+				AppendKeyValue(Key, &Value);
+			}
+		}
+		else
+		{
+			Key << TEXT('-');
+		}
+	}
+
+	return FString(Key.ToView());
+}
+
+TSharedPtr<const FHttpCachedResponse> FHttpResponseCache::Find(const FString& Key)
+{
+	FReadScopeLock ReadLock(Lock);
+
+	const TSharedRef<const FHttpCachedResponse>* Entry = Entries.Find(Key);
+	if (!Entry || (*Entry)->ExpireTime < FPlatformTime::Seconds())
+	{
+		return nullptr;
+	}
+
+	return *Entry;
+}
+
+TSharedPtr<const FHttpCachedResponse> FHttpResponseCache::Store(const FString& Key, FStringView RequestPath, const FHttpServerResponse& Response, float TtlSeconds)
+{
+	if (TtlSeconds <= 0.0f)
+	{
+		return nullptr;
+	}
+
+	TSharedRef<FHttpCachedResponse> Entry = MakeShared<FHttpCachedResponse>();
+	Entry->Code = Response.Code;
+	Entry->Headers = Response.Headers;
+	Entry->Body = Response.Body;
+	Entry->ContentVersion = CityHash64(reinterpret_cast<const char*>(Entry->Body.GetData()), Entry->Body.Num());
+	Entry->RequestPath = FString(RequestPath);
+
+	const double Now = FPlatformTime::Seconds();
+	Entry->ExpireTime = Now + TtlSeconds;
+
+	FWriteScopeLock WriteLock(Lock);
+
+	if (Entries.Num() >= MaxEntries && !Entries.Contains(Key))
+	{
+		PurgeExpired(Now);
+		if (Entries.Num() >= MaxEntries)
+		{
+			return nullptr;
+		}
+	}
+
+	Entries.Add(Key, Entry);
+	return Entry;
+}
+
+void FHttpResponseCache::Invalidate(FStringView RequestPath)
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (RequestPath.Equals(It.Value()->RequestPath, ESearchCase::IgnoreCase))
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FHttpResponseCache::InvalidatePrefix(FStringView Prefix)
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (FStringView(It.Value()->RequestPath).StartsWith(Prefix, ESearchCase::IgnoreCase))
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FHttpResponseCache::Clear()
+{
+	FWriteScopeLock WriteLock(Lock);
+	Entries.Reset();
+	EncodedBodies.Reset();
+	EncodedBodiesOrder.Reset();
+}
+
+TSharedPtr<const TArray<uint8>> FHttpResponseCache::FindEncodedBody(uint64 ContentVersion, FName Encoding) const
+{
+	FReadScopeLock ReadLock(Lock);
+
+	const TSharedRef<const TArray<uint8>>* EncodedBody = EncodedBodies.Find(FEncodedBodyKey(ContentVersion, Encoding));
+	return EncodedBody ? TSharedPtr<const TArray<uint8>>(*EncodedBody) : nullptr;
+}
+
+void FHttpResponseCache::StoreEncodedBody(uint64 ContentVersion, FName Encoding, TSharedRef<const TArray<uint8>> EncodedBody)
+{
+	FWriteScopeLock WriteLock(Lock);
+
+	const FEncodedBodyKey Key(ContentVersion, Encoding);
+	if (EncodedBodies.Contains(Key))
+	{
+		return;
+	}
+
+	while (EncodedBodiesOrder.Num() >= FMath::Max(MaxEncodedBodies, 1))
+	{
+		EncodedBodies.Remove(EncodedBodiesOrder[0]);
+		EncodedBodiesOrder.RemoveAt(0, 1, false);
+	}
+
+	EncodedBodies.Add(Key, MoveTemp(EncodedBody));
+	EncodedBodiesOrder.Add(Key);
+}
+
+int32 FHttpResponseCache::Num() const
+{
+	FReadScopeLock ReadLock(Lock);
+	return Entries.Num();
+}
+
+void FHttpResponseCache::PurgeExpired(double Now)
+{
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (It.Value()->ExpireTime < Now)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
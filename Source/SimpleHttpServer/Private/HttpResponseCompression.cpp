@@ -0,0 +1,218 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpResponseCompression.h"
+#include "HttpRouteCompletion.h"
+#include "HttpConditionalRequest.h"
+#include "HttpResponseCache.h"
+#include "HttpServerTrace.h"
+#include "Misc/Compression.h"
+#include "Async/Async.h"
+#include "String/Find.h"
+
+namespace
+{
+	float ParseQuality(FStringView Params)
+	{
+		// "q=0.5", quality is 1 when not set
+		const int32 QPos = UE::String::FindFirst(Params, TEXT("q="), ESearchCase::IgnoreCase);
+		if (QPos == INDEX_NONE)
+		{
+			return 1.0f;
+		}
+
+		return FCString::Atof(*FString(Params.RightChop(QPos + 2)));
+	}
+
+	TUniquePtr<FHttpServerResponse> MakeEncodedResponse(const FHttpCachedResponse& CachedResponse, const TArray<uint8>& EncodedBody, FName Encoding)
+	{
+		// Empty encoded body means compression didn't help, send identity
+		if (EncodedBody.Num() == 0)
+		{
+			return CachedResponse.MakeResponse();
+		}
+
+		TUniquePtr<FHttpServerResponse> Response = CachedResponse.MakeResponse(&EncodedBody);
+		FHttpResponseCompression::SetEncodingHeaders(*Response, Encoding);
+		return Response;
+	}
+
+	bool IsCompressibleContentType(FStringView ContentType)
+	{
+		static const TCHAR* CompressibleTypes[] = { TEXT("text/"), TEXT("json"), TEXT("javascript"), TEXT("xml"), TEXT("svg"), TEXT("csv") };
+		for (const TCHAR* CompressibleType : CompressibleTypes)
+		{
+			if (UE::String::FindFirst(ContentType, CompressibleType, ESearchCase::IgnoreCase) != INDEX_NONE)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
+
+FName FHttpResponseCompression::NegotiateEncoding(const FHttpServerRequest& Request)
+{
+	const TArray<FString>* Values = Request.Headers.Find(TEXT("accept-encoding"));
+	if (!Values)
+	{
+		return NAME_None;
+	}
+
+	float GzipQuality = 0.0f;
+	float DeflateQuality = 0.0f;
+
+	for (const FString& Value : *Values)
+	{
+		FStringView Remaining = Value;
+		while (!Remaining.IsEmpty())
+		{
+			int32 Comma = INDEX_NONE;
+			if (!Remaining.FindChar(TEXT(','), Comma))
+			{
+				Comma = Remaining.Len();
+			}
+
+			FStringView Token = Remaining.Left(Comma).TrimStartAndEnd();
+			Remaining.RightChopInline(Comma + 1);
+
+			FStringView Params;
+			int32 Semicolon = INDEX_NONE;
+			if (Token.FindChar(TEXT(';'), Semicolon))
+			{
+				Params = Token.RightChop(Semicolon + 1);
+				Token = Token.Left(Semicolon).TrimEnd();
+			}
+
+			if (Token.Equals(TEXT("gzip"), ESearchCase::IgnoreCase))
+			{
+				GzipQuality = ParseQuality(Params);
+			}
+			else if (Token.Equals(TEXT("deflate"), ESearchCase::IgnoreCase))
+			{
+				DeflateQuality = ParseQuality(Params);
+			}
+		}
+	}
+
+	if (GzipQuality > 0.0f && GzipQuality >= DeflateQuality)
+	{
+		return NAME_Gzip;
+	}
+
+	return DeflateQuality > 0.0f ? NAME_Zlib : NAME_None;
+}
+
+bool FHttpResponseCompression::ShouldCompress(const FHttpServerResponse& Response, int32 MinSize)
+{
+	return ShouldCompress(Response.Headers, Response.Body.Num(), MinSize);
+}
+
+bool FHttpResponseCompression::ShouldCompress(const TMap<FString, TArray<FString>>& Headers, int32 BodySize, int32 MinSize)
+{
+	if (BodySize < FMath::Max(MinSize, 1) || Headers.Contains(TEXT("content-encoding")))
+	{
+		return false;
+	}
+
+	const TArray<FString>* ContentType = Headers.Find(TEXT("content-type"));
+	return ContentType && ContentType->Num() > 0 && IsCompressibleContentType((*ContentType)[0]);
+}
+
+bool FHttpResponseCompression::Compress(FHttpServerResponse& Response, FName Encoding)
+{
+	TArray<uint8> CompressedBody;
+	if (!CompressBody(Response.Body, Encoding, CompressedBody))
+	{
+		return false;
+	}
+
+	Response.Body = MoveTemp(CompressedBody);
+	SetEncodingHeaders(Response, Encoding);
+	return true;
+}
+
+bool FHttpResponseCompression::CompressBody(TArrayView<const uint8> Body, FName Encoding, TArray<uint8>& OutBytes)
+{
+	if (Encoding.IsNone() || Body.Num() == 0)
+	{
+		return false;
+	}
+
+	int32 CompressedSize = FCompression::CompressMemoryBound(Encoding, Body.Num());
+	OutBytes.SetNumUninitialized(CompressedSize);
+
+	if (!FCompression::CompressMemory(Encoding, OutBytes.GetData(), CompressedSize, Body.GetData(), Body.Num()) || CompressedSize >= Body.Num())
+	{
+		OutBytes.Reset();
+		return false;
+	}
+
+	OutBytes.SetNum(CompressedSize, false);
+	return true;
+}
+
+void FHttpResponseCompression::SetEncodingHeaders(FHttpServerResponse& Response, FName Encoding)
+{
+	Response.Headers.Add(TEXT("content-encoding"), TArray<FString>{ GetEncodingHeaderValue(Encoding) });
+	Response.Headers.FindOrAdd(TEXT("vary")).AddUnique(TEXT("accept-encoding"));
+
+	if (TArray<FString>* ETag = Response.Headers.Find(FHttpConditionalRequest::ETagHeader))
+	{
+		for (FString& Value : *ETag)
+		{
+			if (!Value.StartsWith(TEXT("W/")))
+			{
+				Value.InsertAt(0, TEXT("W/"));
+			}
+		}
+	}
+}
+
+FHttpResultCallback FHttpResponseCompression::MakeCompressingCallback(FName Encoding, int32 MinSize, FHttpResultCallback OnComplete)
+{
+	return [Encoding, MinSize, OnComplete = MoveTemp(OnComplete)](TUniquePtr<FHttpServerResponse>&& Response)
+	{
+		if (!Response.IsValid() || !ShouldCompress(*Response, MinSize))
+		{
+			OnComplete(MoveTemp(Response));
+			return;
+		}
+
+		// Keep compression off the game thread
+		AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Encoding, OnComplete, Response = MoveTemp(Response)]() mutable
+		{
+			SIMPLEHTTPSERVER_TRACE_SCOPE(Compress);
+			Compress(*Response, Encoding);
+			FHttpRouteCompletion::CompleteOnGameThread(OnComplete, MoveTemp(Response));
+		});
+	};
+}
+
+void FHttpResponseCompression::CompleteFromCache(const TSharedRef<FHttpResponseCache>& Cache, const TSharedRef<const FHttpCachedResponse>& CachedResponse, FName Encoding, const FHttpResultCallback& OnComplete)
+{
+	if (TSharedPtr<const TArray<uint8>> EncodedBody = Cache->FindEncodedBody(CachedResponse->ContentVersion, Encoding))
+	{
+		OnComplete(MakeEncodedResponse(*CachedResponse, *EncodedBody, Encoding));
+		return;
+	}
+
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakCache = TWeakPtr<FHttpResponseCache>(Cache), CachedResponse, Encoding, OnComplete]()
+	{
+		SIMPLEHTTPSERVER_TRACE_SCOPE(Compress);
+		TSharedRef<TArray<uint8>> EncodedBody = MakeShared<TArray<uint8>>();
+		CompressBody(CachedResponse->Body, Encoding, *EncodedBody);
+
+		if (TSharedPtr<FHttpResponseCache> PinnedCache = WeakCache.Pin())
+		{
+			PinnedCache->StoreEncodedBody(CachedResponse->ContentVersion, Encoding, EncodedBody);
+		}
+
+		FHttpRouteCompletion::CompleteOnGameThread(OnComplete, MakeEncodedResponse(*CachedResponse, *EncodedBody, Encoding));
+	});
+}
+
+const TCHAR* FHttpResponseCompression::GetEncodingHeaderValue(FName Encoding)
+{
+	return Encoding == NAME_Gzip ? TEXT("gzip") : TEXT("deflate");
+}
@@ -0,0 +1,80 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpRouteCompletion.h"
+#include "SimpleHttpServer.h"
+#include "HttpResponseBuilder.h"
+#include "Async/Async.h"
+
+FHttpRouteCompletion::FHttpRouteCompletion(const FHttpResultCallback& OnComplete)
+	: State(MakeShared<FState, ESPMode::ThreadSafe>())
+{
+	State->OnComplete = OnComplete;
+}
+
+FHttpRouteCompletion::FState::~FState()
+{
+	// Nobody answered this request. Don't let the connection hang until the client timeout.
+	if (!bCompleted.exchange(true) && OnComplete)
+	{
+		UE_LOG(LogSimpleHttpServer, Warning, TEXT("Native route handler released request without completing it. Sending 500."));
+		CompleteOnGameThread(OnComplete, FHttpServerResponse::Error(EHttpServerResponseCodes::ServerError));
+	}
+}
+
+void FHttpRouteCompletion::Complete(TUniquePtr<FHttpServerResponse>&& Response) const
+{
+	if (!State.IsValid())
+	{
+		return;
+	}
+
+	if (State->bCompleted.exchange(true))
+	{
+		UE_LOG(LogSimpleHttpServer, Warning, TEXT("Request was already completed. Response ignored."));
+		return;
+	}
+
+	CompleteOnGameThread(State->OnComplete, MoveTemp(Response));
+}
+
+void FHttpRouteCompletion::Complete(FNativeHttpServerResponse&& Response) const
+{
+	Complete(MakeUnique<FHttpServerResponse>(MoveTemp(Response.HttpServerResponse)));
+}
+
+void FHttpRouteCompletion::Complete(FHttpResponseBuilder&& Builder) const
+{
+	Complete(Builder.Build());
+}
+
+void FHttpRouteCompletion::CompleteWithCode(EHttpServerResponseCodes Code) const
+{
+	TUniquePtr<FHttpServerResponse> Response = MakeUnique<FHttpServerResponse>();
+	Response->Code = Code;
+	Complete(MoveTemp(Response));
+}
+
+bool FHttpRouteCompletion::IsCompleted() const
+{
+	return State.IsValid() && State->bCompleted.load();
+}
+
+void FHttpRouteCompletion::CompleteOnGameThread(const FHttpResultCallback& OnComplete, TUniquePtr<FHttpServerResponse>&& Response)
+{
+	if (!OnComplete)
+	{
+		return;
+	}
+
+	// HTTPServer connections are ticked on the game thread and are not safe to touch from other threads
+	if (IsInGameThread())
+	{
+		OnComplete(MoveTemp(Response));
+		return;
+	}
+
+	AsyncTask(ENamedThreads::GameThread, [OnComplete, Response = MoveTemp(Response)]() mutable
+	{
+		OnComplete(MoveTemp(Response));
+	});
+}
@@ -0,0 +1,403 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpSerializationPlan.h"
+#include "HttpJsonSerializer.h"
+#include "HttpResponseBuilder.h"
+#include "JsonObjectConverter.h"
+#include "JsonObjectWrapper.h"
+#include "UObject/TextProperty.h"
+#include "UObject/EnumProperty.h"
+
+const FHttpFieldPlan* FHttpStructPlan::FindField(FAnsiStringView Key, int32& InOutHint) const
+{
+	for (int32 Offset = 0; Offset < Fields.Num(); ++Offset)
+	{
+		const int32 Index = (InOutHint + Offset) % Fields.Num();
+		const FAnsiStringView FieldKey = Fields[Index].GetKey();
+		if (FieldKey.Len() == Key.Len() && FCStringAnsi::Strnicmp(FieldKey.GetData(), Key.GetData(), Key.Len()) == 0)
+		{
+			InOutHint = Index + 1;
+			return &Fields[Index];
+		}
+	}
+
+	return nullptr;
+}
+
+FHttpPropertyValue::FHttpPropertyValue(const FProperty* InProperty)
+	: Property(InProperty)
+	, Memory(FMemory::Malloc(InProperty->GetSize(), InProperty->GetMinAlignment()))
+{
+	Property->InitializeValue(Memory);
+}
+
+FHttpPropertyValue::~FHttpPropertyValue()
+{
+	Property->DestroyValue(Memory);
+	FMemory::Free(Memory);
+}
+
+void FHttpPropertyValue::Reset()
+{
+	Property->ClearValue(Memory);
+}
+
+void* FHttpPropertyValue::FindOrResetMapValue(FScriptMapHelper& Helper, const FProperty* ValueProperty, const void* Key)
+{
+	if (uint8* Existing = Helper.FindValueFromHash(Key))
+	{
+		ValueProperty->ClearValue(Existing);
+		return Existing;
+	}
+
+	return Helper.FindOrAdd(Key);
+}
+
+FHttpPlanCache& FHttpPlanCache::Get()
+{
+	static FHttpPlanCache Instance;
+	return Instance;
+}
+
+const FHttpStructPlan& FHttpPlanCache::FindOrBuild(const UStruct* Struct)
+{
+	{
+		FReadScopeLock ReadLock(Lock);
+		if (const TSharedRef<FHttpStructPlan>* Plan = Plans.Find(Struct))
+		{
+			return **Plan;
+		}
+	}
+
+	// Readers can't see a plan while it is being filled, they wait for the lock
+	FWriteScopeLock WriteLock(Lock);
+	return BuildLocked(Struct);
+}
+
+void FHttpPlanCache::BuildValuePlan(FHttpValuePlan& Plan, const FProperty* Property, TFunctionRef<const FHttpStructPlan&(const UStruct*)> GetStructPlan)
+{
+	Plan.Property = Property;
+
+	if (CastField<FBoolProperty>(Property))
+	{
+		Plan.Kind = EHttpValueKind::Bool;
+	}
+	else if (CastField<FEnumProperty>(Property))
+	{
+		Plan.Kind = EHttpValueKind::Enum;
+	}
+	else if (const FByteProperty* ByteProperty = CastField<FByteProperty>(Property); ByteProperty && ByteProperty->GetIntPropertyEnum())
+	{
+		Plan.Kind = EHttpValueKind::ByteEnum;
+	}
+	else if (CastField<FFloatProperty>(Property))
+	{
+		Plan.Kind = EHttpValueKind::Float;
+	}
+	else if (CastField<FDoubleProperty>(Property))
+	{
+		Plan.Kind = EHttpValueKind::Double;
+	}
+	else if (CastField<FUInt64Property>(Property))
+	{
+		Plan.Kind = EHttpValueKind::UnsignedInt;
+	}
+	else if (const FNumericProperty* NumericProperty = CastField<FNumericProperty>(Property); NumericProperty && NumericProperty->IsInteger())
+	{
+		Plan.Kind = EHttpValueKind::SignedInt;
+	}
+	else if (CastField<FStrProperty>(Property))
+	{
+		Plan.Kind = EHttpValueKind::String;
+	}
+	else if (CastField<FNameProperty>(Property))
+	{
+		Plan.Kind = EHttpValueKind::Name;
+	}
+	else if (CastField<FTextProperty>(Property))
+	{
+		Plan.Kind = EHttpValueKind::Text;
+	}
+	else if (const FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+	{
+		// Structs with own text form (FDateTime, FGuid...) are strings like in FJsonObjectConverter,
+		// which skips the JSON object wrapper the same way
+		const UScriptStruct::ICppStructOps* CppStructOps = StructProperty->Struct->GetCppStructOps();
+		if (StructProperty->Struct != FJsonObjectWrapper::StaticStruct() && CppStructOps && CppStructOps->HasExportTextItem())
+		{
+			Plan.Kind = EHttpValueKind::Other;
+		}
+		else
+		{
+			Plan.Kind = EHttpValueKind::Struct;
+			Plan.StructPlan = &GetStructPlan(StructProperty->Struct);
+		}
+	}
+	else if (const FArrayProperty* ArrayProperty = CastField<FArrayProperty>(Property))
+	{
+		Plan.Kind = EHttpValueKind::Array;
+		Plan.Inner = MakeUnique<FHttpValuePlan>();
+		BuildValuePlan(*Plan.Inner, ArrayProperty->Inner, GetStructPlan);
+
+		// Plain bytes, not enums
+		Plan.bBytes = Plan.Inner->Kind == EHttpValueKind::SignedInt && ArrayProperty->Inner->IsA<FByteProperty>();
+	}
+	else if (const FSetProperty* SetProperty = CastField<FSetProperty>(Property))
+	{
+		Plan.Kind = EHttpValueKind::Set;
+		Plan.Inner = MakeUnique<FHttpValuePlan>();
+		BuildValuePlan(*Plan.Inner, SetProperty->ElementProp, GetStructPlan);
+	}
+	else if (const FMapProperty* MapProperty = CastField<FMapProperty>(Property))
+	{
+		Plan.Kind = EHttpValueKind::Map;
+		Plan.Key = MakeUnique<FHttpValuePlan>();
+		BuildValuePlan(*Plan.Key, MapProperty->KeyProp, GetStructPlan);
+		Plan.Inner = MakeUnique<FHttpValuePlan>();
+		BuildValuePlan(*Plan.Inner, MapProperty->ValueProp, GetStructPlan);
+	}
+	// Soft object property is an object property too, check it first
+	else if (CastField<FSoftObjectProperty>(Property))
+	{
+		Plan.Kind = EHttpValueKind::SoftObject;
+	}
+	else if (CastField<FObjectPropertyBase>(Property))
+	{
+		Plan.Kind = EHttpValueKind::Object;
+	}
+	else
+	{
+		Plan.Kind = EHttpValueKind::Other;
+	}
+}
+
+const FHttpStructPlan& FHttpPlanCache::BuildLocked(const UStruct* Struct)
+{
+	if (const TSharedRef<FHttpStructPlan>* Existing = Plans.Find(Struct))
+	{
+		return **Existing;
+	}
+
+	// Added before fields are filled, so structs containing arrays of themselves resolve to it
+	TSharedRef<FHttpStructPlan> Plan = MakeShared<FHttpStructPlan>();
+	Plans.Add(Struct, Plan);
+
+	// Objects expose only what their authors made visible
+	const bool bIsClass = Struct->IsA<UClass>();
+
+	for (TFieldIterator<FProperty> It(Struct); It; ++It)
+	{
+		const FProperty* Property = *It;
+		if (Property->HasAnyPropertyFlags(CPF_Deprecated))
+		{
+			continue;
+		}
+
+		if (bIsClass && (Property->HasAnyPropertyFlags(CPF_Transient) || !Property->HasAnyPropertyFlags(CPF_Edit | CPF_BlueprintVisible)))
+		{
+			continue;
+		}
+
+		const FString Name = FJsonObjectConverter::StandardizeCase(Property->GetAuthoredName());
+
+		FHttpFieldPlan& Field = Plan->Fields.AddDefaulted_GetRef();
+		FHttpJsonSerializer::AppendString(Field.JsonName, Name);
+		Field.JsonName.Add(':');
+
+		TArray<uint8> NameUtf8;
+		FHttpResponseBuilder::AppendUtf8(NameUtf8, Name);
+
+		FHttpMessagePack::WriteStringHead(Field.MessagePackName, NameUtf8.Num());
+		Field.MessagePackName.Append(NameUtf8);
+
+		FHttpCbor::WriteHead(Field.CborName, FHttpCbor::MajorText, NameUtf8.Num());
+		Field.CborName.Append(NameUtf8);
+
+		BuildValuePlan(Field.Value, Property, [this](const UStruct* InnerStruct) -> const FHttpStructPlan&
+		{
+			return BuildLocked(InnerStruct);
+		});
+	}
+
+	return *Plan;
+}
+
+void FHttpMessagePack::WriteUInt(TArray<uint8>& Out, uint64 Value)
+{
+	if (Value < 0x80)
+	{
+		Out.Add((uint8)Value);
+	}
+	else if (Value <= MAX_uint8)
+	{
+		Out.Add(0xcc);
+		AppendBigEndian(Out, Value, 1);
+	}
+	else if (Value <= MAX_uint16)
+	{
+		Out.Add(0xcd);
+		AppendBigEndian(Out, Value, 2);
+	}
+	else if (Value <= MAX_uint32)
+	{
+		Out.Add(0xce);
+		AppendBigEndian(Out, Value, 4);
+	}
+	else
+	{
+		Out.Add(0xcf);
+		AppendBigEndian(Out, Value, 8);
+	}
+}
+
+void FHttpMessagePack::WriteInt(TArray<uint8>& Out, int64 Value)
+{
+	if (Value >= 0)
+	{
+		WriteUInt(Out, (uint64)Value);
+	}
+	else if (Value >= -32)
+	{
+		Out.Add((uint8)(int8)Value);
+	}
+	else if (Value >= MIN_int8)
+	{
+		Out.Add(0xd0);
+		AppendBigEndian(Out, (uint64)Value, 1);
+	}
+	else if (Value >= MIN_int16)
+	{
+		Out.Add(0xd1);
+		AppendBigEndian(Out, (uint64)Value, 2);
+	}
+	else if (Value >= MIN_int32)
+	{
+		Out.Add(0xd2);
+		AppendBigEndian(Out, (uint64)Value, 4);
+	}
+	else
+	{
+		Out.Add(0xd3);
+		AppendBigEndian(Out, (uint64)Value, 8);
+	}
+}
+
+void FHttpMessagePack::WriteStringHead(TArray<uint8>& Out, uint32 Len)
+{
+	if (Len < 32)
+	{
+		Out.Add(0xa0 | (uint8)Len);
+	}
+	else if (Len <= MAX_uint8)
+	{
+		Out.Add(0xd9);
+		AppendBigEndian(Out, Len, 1);
+	}
+	else if (Len <= MAX_uint16)
+	{
+		Out.Add(0xda);
+		AppendBigEndian(Out, Len, 2);
+	}
+	else
+	{
+		Out.Add(0xdb);
+		AppendBigEndian(Out, Len, 4);
+	}
+}
+
+void FHttpMessagePack::WriteBinaryHead(TArray<uint8>& Out, uint32 Len)
+{
+	if (Len <= MAX_uint8)
+	{
+		Out.Add(0xc4);
+		AppendBigEndian(Out, Len, 1);
+	}
+	else if (Len <= MAX_uint16)
+	{
+		Out.Add(0xc5);
+		AppendBigEndian(Out, Len, 2);
+	}
+	else
+	{
+		Out.Add(0xc6);
+		AppendBigEndian(Out, Len, 4);
+	}
+}
+
+void FHttpMessagePack::WriteArrayHead(TArray<uint8>& Out, uint32 Num)
+{
+	if (Num < 16)
+	{
+		Out.Add(0x90 | (uint8)Num);
+	}
+	else if (Num <= MAX_uint16)
+	{
+		Out.Add(0xdc);
+		AppendBigEndian(Out, Num, 2);
+	}
+	else
+	{
+		Out.Add(0xdd);
+		AppendBigEndian(Out, Num, 4);
+	}
+}
+
+void FHttpMessagePack::WriteMapHead(TArray<uint8>& Out, uint32 Num)
+{
+	if (Num < 16)
+	{
+		Out.Add(0x80 | (uint8)Num);
+	}
+	else if (Num <= MAX_uint16)
+	{
+		Out.Add(0xde);
+		AppendBigEndian(Out, Num, 2);
+	}
+	else
+	{
+		Out.Add(0xdf);
+		AppendBigEndian(Out, Num, 4);
+	}
+}
+
+void FHttpCbor::WriteHead(TArray<uint8>& Out, uint8 Major, uint64 Value)
+{
+	const uint8 MajorBits = (uint8)(Major << 5);
+	if (Value < 24)
+	{
+		Out.Add(MajorBits | (uint8)Value);
+	}
+	else if (Value <= MAX_uint8)
+	{
+		Out.Add(MajorBits | 24);
+		AppendBigEndian(Out, Value, 1);
+	}
+	else if (Value <= MAX_uint16)
+	{
+		Out.Add(MajorBits | 25);
+		AppendBigEndian(Out, Value, 2);
+	}
+	else if (Value <= MAX_uint32)
+	{
+		Out.Add(MajorBits | 26);
+		AppendBigEndian(Out, Value, 4);
+	}
+	else
+	{
+		Out.Add(MajorBits | 27);
+		AppendBigEndian(Out, Value, 8);
+	}
+}
+
+void FHttpCbor::WriteInt(TArray<uint8>& Out, int64 Value)
+{
+	// Negative N is stored as -1 - N
+	if (Value >= 0)
+	{
+		WriteHead(Out, MajorUInt, (uint64)Value);
+	}
+	else
+	{
+		WriteHead(Out, MajorNegativeInt, (uint64)(-1 - Value));
+	}
+}
@@ -0,0 +1,166 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+
+class FScriptMapHelper;
+
+// How a value is read and written, decided once per property
+enum class EHttpValueKind : uint8
+{
+	Bool,
+	SignedInt,
+	UnsignedInt,
+	Float,
+	Double,
+	Enum,
+	ByteEnum,
+	String,
+	Name,
+	Text,
+	Struct,
+	Array,
+	Set,
+	Map,
+	Object,
+	SoftObject,
+	// Written as exported text
+	Other
+};
+
+struct FHttpStructPlan;
+
+struct FHttpValuePlan
+{
+	const FProperty* Property = nullptr;
+	EHttpValueKind Kind = EHttpValueKind::Other;
+
+	// TArray<uint8>, sent as byte string by binary formats
+	bool bBytes = false;
+
+	// Struct values
+	const FHttpStructPlan* StructPlan = nullptr;
+
+	// Array and set elements, map values
+	TUniquePtr<FHttpValuePlan> Inner;
+
+	// Map keys
+	TUniquePtr<FHttpValuePlan> Key;
+};
+
+struct FHttpFieldPlan
+{
+	// "name": already escaped and in UTF-8
+	TArray<uint8> JsonName;
+
+	// Name as string of MessagePack and CBOR
+	TArray<uint8> MessagePackName;
+	TArray<uint8> CborName;
+
+	FHttpValuePlan Value;
+
+	// Name without quotes and colon, as it appears in parsed documents
+	FAnsiStringView GetKey() const
+	{
+		return FAnsiStringView(reinterpret_cast<const ANSICHAR*>(JsonName.GetData()) + 1, JsonName.Num() - 3);
+	}
+};
+
+struct FHttpStructPlan
+{
+	TArray<FHttpFieldPlan> Fields;
+
+	// Case-insensitive like FJsonObjectConverter. Hint is the field after the previous match,
+	// members usually come in declaration order, so it is tried first.
+	const FHttpFieldPlan* FindField(FAnsiStringView Key, int32& InOutHint) const;
+};
+
+/**
+ * Plans of struct types shared by all wire formats. Built on first use and never freed, serializers on other threads
+ * may be walking them. A reloaded struct is a new object and gets its own plan.
+ * Field names follow FJsonObjectConverter.
+ */
+class FHttpPlanCache
+{
+public:
+	static FHttpPlanCache& Get();
+
+	const FHttpStructPlan& FindOrBuild(const UStruct* Struct);
+
+	// Plan of a single property, with nested structs taken from the cache
+	static void BuildValuePlan(FHttpValuePlan& Plan, const FProperty* Property, TFunctionRef<const FHttpStructPlan&(const UStruct*)> GetStructPlan);
+
+private:
+	const FHttpStructPlan& BuildLocked(const UStruct* Struct);
+
+	FRWLock Lock;
+
+	// Object key isn't reused by a new struct at the same address
+	TMap<FObjectKey, TSharedRef<FHttpStructPlan>> Plans;
+};
+
+// Initialized value of a property kept outside any container, e.g. a set element or map key read before it is looked up
+class FHttpPropertyValue
+{
+public:
+	explicit FHttpPropertyValue(const FProperty* InProperty);
+	~FHttpPropertyValue();
+
+	FHttpPropertyValue(const FHttpPropertyValue&) = delete;
+	FHttpPropertyValue& operator=(const FHttpPropertyValue&) = delete;
+
+	void* Get() const { return Memory; }
+
+	// Back to default before the next value is read into it
+	void Reset();
+
+	// Value of Key in the map, added or cleared so a repeated key replaces the earlier value instead of merging with it
+	static void* FindOrResetMapValue(FScriptMapHelper& Helper, const FProperty* ValueProperty, const void* Key);
+
+private:
+	const FProperty* Property;
+	void* Memory;
+};
+
+// Heads of MessagePack values
+struct FHttpMessagePack
+{
+	static void WriteUInt(TArray<uint8>& Out, uint64 Value);
+	static void WriteInt(TArray<uint8>& Out, int64 Value);
+
+	// 0xa0 string, 0xc4 binary, 0x90 array or 0x80 map head for Len items
+	static void WriteStringHead(TArray<uint8>& Out, uint32 Len);
+	static void WriteBinaryHead(TArray<uint8>& Out, uint32 Len);
+	static void WriteArrayHead(TArray<uint8>& Out, uint32 Num);
+	static void WriteMapHead(TArray<uint8>& Out, uint32 Num);
+};
+
+// Heads of CBOR data items
+struct FHttpCbor
+{
+	enum EMajorType : uint8
+	{
+		MajorUInt = 0,
+		MajorNegativeInt = 1,
+		MajorBytes = 2,
+		MajorText = 3,
+		MajorArray = 4,
+		MajorMap = 5,
+		MajorTag = 6,
+		MajorSimple = 7
+	};
+
+	static void WriteHead(TArray<uint8>& Out, uint8 Major, uint64 Value);
+	static void WriteInt(TArray<uint8>& Out, int64 Value);
+};
+
+// Big-endian writes shared by binary formats
+inline void AppendBigEndian(TArray<uint8>& Out, uint64 Value, int32 NumBytes)
+{
+	for (int32 Shift = (NumBytes - 1) * 8; Shift >= 0; Shift -= 8)
+	{
+		Out.Add((uint8)(Value >> Shift));
+	}
+}
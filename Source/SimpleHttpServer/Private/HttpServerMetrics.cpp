@@ -0,0 +1,381 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpServerMetrics.h"
+#include "SimpleHttpServer.h"
+#include "HttpResponseBuilder.h"
+#include "HttpServerResponse.h"
+
+namespace
+{
+	// Upper bounds of latency buckets in seconds, the last bucket is +Inf
+	constexpr double BucketBounds[] = { 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0 };
+	const TCHAR* const BucketLabels[] = { TEXT("0.0005"), TEXT("0.001"), TEXT("0.0025"), TEXT("0.005"), TEXT("0.01"), TEXT("0.025"), TEXT("0.05"),
+		TEXT("0.1"), TEXT("0.25"), TEXT("0.5"), TEXT("1"), TEXT("2.5"), TEXT("5"), TEXT("10"), TEXT("+Inf") };
+
+	constexpr int32 NumBounds = UE_ARRAY_COUNT(BucketBounds);
+	constexpr int32 NumBuckets = NumBounds + 1;
+
+	// Status classes 1xx to 5xx
+	constexpr int32 NumStatusClasses = 5;
+
+	std::atomic<uint64> NextInstanceId{ 1 };
+
+	// Counters have a single writer, the owning thread, so there is no need for read-modify-write
+	void Add(std::atomic<uint64>& Counter, uint64 Value)
+	{
+		Counter.store(Counter.load(std::memory_order_relaxed) + Value, std::memory_order_relaxed);
+	}
+
+	uint64 Read(const std::atomic<uint64>& Counter)
+	{
+		return Counter.load(std::memory_order_relaxed);
+	}
+
+	void AppendLabelValue(FStringBuilderBase& Text, FStringView Value)
+	{
+		for (const TCHAR Char : Value)
+		{
+			if (Char == TEXT('\\') || Char == TEXT('"'))
+			{
+				Text.AppendChar(TEXT('\\'));
+				Text.AppendChar(Char);
+			}
+			else if (Char == TEXT('\n'))
+			{
+				Text.Append(TEXT("\\n"));
+			}
+			else
+			{
+				Text.AppendChar(Char);
+			}
+		}
+	}
+
+	struct FHistogramTotals
+	{
+		uint64 Buckets[NumBuckets] = {};
+		uint64 Count = 0;
+		uint64 SumMicros = 0;
+	};
+
+	struct FRouteTotals
+	{
+		uint64 Requests = 0;
+		uint64 Statuses[NumStatusClasses] = {};
+		uint64 BytesIn = 0;
+		uint64 BytesOut = 0;
+		FHistogramTotals QueueWait;
+		FHistogramTotals Handler;
+	};
+}
+
+struct FHttpServerMetrics::FHistogram
+{
+	// Not cumulative, summed up on export
+	std::atomic<uint64> Buckets[NumBuckets] = {};
+	std::atomic<uint64> Count{ 0 };
+	std::atomic<uint64> SumMicros{ 0 };
+
+	void Record(uint64 Cycles)
+	{
+		const double Seconds = FPlatformTime::ToSeconds64(Cycles);
+
+		int32 Bucket = 0;
+		while (Bucket < NumBounds && Seconds > BucketBounds[Bucket])
+		{
+			++Bucket;
+		}
+
+		Add(Buckets[Bucket], 1);
+		Add(Count, 1);
+		Add(SumMicros, (uint64)(Seconds * 1000000.0));
+	}
+
+	void AddTo(FHistogramTotals& Totals) const
+	{
+		for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+		{
+			Totals.Buckets[Bucket] += Read(Buckets[Bucket]);
+		}
+
+		Totals.Count += Read(Count);
+		Totals.SumMicros += Read(SumMicros);
+	}
+};
+
+struct FHttpServerMetrics::FRouteCounters
+{
+	std::atomic<uint64> Requests{ 0 };
+	std::atomic<uint64> Statuses[NumStatusClasses] = {};
+	std::atomic<uint64> BytesIn{ 0 };
+	std::atomic<uint64> BytesOut{ 0 };
+	FHistogram QueueWait;
+	FHistogram Handler;
+};
+
+struct FHttpServerMetrics::FShard
+{
+	static constexpr int32 ChunkSize = 64;
+
+	// Allocated by the owning thread on first use of a route and never moved, so export reads them without locking
+	std::atomic<FRouteCounters*> Chunks[MaxRoutes / ChunkSize] = {};
+
+	~FShard()
+	{
+		for (std::atomic<FRouteCounters*>& Chunk : Chunks)
+		{
+			delete[] Chunk.load(std::memory_order_acquire);
+		}
+	}
+};
+
+FHttpServerMetrics::FHttpServerMetrics()
+	: InstanceId(NextInstanceId.fetch_add(1, std::memory_order_relaxed))
+{
+}
+
+FHttpServerMetrics::~FHttpServerMetrics() = default;
+
+int32 FHttpServerMetrics::RegisterRoute(const FString& RoutePattern)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (const int32* Existing = RouteIds.Find(RoutePattern))
+	{
+		return *Existing;
+	}
+
+	if (RoutePatterns.Num() >= MaxRoutes)
+	{
+		UE_LOG(LogSimpleHttpServer, Warning, TEXT("Too many routes for metrics, '%s' will not be recorded"), *RoutePattern);
+		return INDEX_NONE;
+	}
+
+	const int32 RouteId = RoutePatterns.Add(RoutePattern);
+	RouteIds.Add(RoutePattern, RouteId);
+	return RouteId;
+}
+
+FHttpServerMetrics::FShard& FHttpServerMetrics::GetThreadShard()
+{
+	// Usually a single server per process, so the scan is short. Entries of destroyed instances are never matched again.
+	static thread_local TArray<TPair<uint64, FShard*>, TInlineAllocator<2>> ThreadShards;
+
+	for (const TPair<uint64, FShard*>& Entry : ThreadShards)
+	{
+		if (Entry.Key == InstanceId)
+		{
+			return *Entry.Value;
+		}
+	}
+
+	// Lock is taken once per thread
+	FShard* Shard = nullptr;
+	{
+		FScopeLock ScopeLock(&Lock);
+		Shard = Shards.Add_GetRef(MakeUnique<FShard>()).Get();
+	}
+
+	ThreadShards.Emplace(InstanceId, Shard);
+	return *Shard;
+}
+
+FHttpServerMetrics::FRouteCounters* FHttpServerMetrics::FindCounters(int32 RouteId)
+{
+	if (RouteId < 0 || RouteId >= MaxRoutes)
+	{
+		return nullptr;
+	}
+
+	std::atomic<FRouteCounters*>& Chunk = GetThreadShard().Chunks[RouteId / FShard::ChunkSize];
+
+	FRouteCounters* Counters = Chunk.load(std::memory_order_relaxed);
+	if (!Counters)
+	{
+		Counters = new FRouteCounters[FShard::ChunkSize];
+		Chunk.store(Counters, std::memory_order_release);
+	}
+
+	return &Counters[RouteId % FShard::ChunkSize];
+}
+
+void FHttpServerMetrics::RecordResponse(int32 RouteId, int32 StatusCode, int64 BytesIn, int64 BytesOut)
+{
+	FRouteCounters* Counters = FindCounters(RouteId);
+	if (!Counters)
+	{
+		return;
+	}
+
+	Add(Counters->Requests, 1);
+	Add(Counters->Statuses[FMath::Clamp(StatusCode / 100, 1, NumStatusClasses) - 1], 1);
+	Add(Counters->BytesIn, (uint64)FMath::Max<int64>(BytesIn, 0));
+	Add(Counters->BytesOut, (uint64)FMath::Max<int64>(BytesOut, 0));
+}
+
+void FHttpServerMetrics::RecordHandler(int32 RouteId, uint64 QueueWaitCycles, uint64 HandlerCycles)
+{
+	if (FRouteCounters* Counters = FindCounters(RouteId))
+	{
+		Counters->QueueWait.Record(QueueWaitCycles);
+		Counters->Handler.Record(HandlerCycles);
+	}
+}
+
+FHttpResultCallback FHttpServerMetrics::MakeRecordingCallback(const TSharedRef<FHttpServerMetrics>& Metrics, int32 RouteId, int64 BytesIn, FHttpResultCallback&& OnComplete)
+{
+	return [Metrics, RouteId, BytesIn, OnComplete = MoveTemp(OnComplete)](TUniquePtr<FHttpServerResponse>&& Response)
+	{
+		if (Response.IsValid())
+		{
+			Metrics->RecordResponse(RouteId, (int32)Response->Code, BytesIn, Response->Body.Num());
+		}
+
+		OnComplete(MoveTemp(Response));
+	};
+}
+
+void FHttpServerMetrics::GetTotalBytes(uint64& OutBytesIn, uint64& OutBytesOut) const
+{
+	OutBytesIn = 0;
+	OutBytesOut = 0;
+
+	FScopeLock ScopeLock(&Lock);
+
+	for (const TUniquePtr<FShard>& Shard : Shards)
+	{
+		for (int32 RouteId = 0; RouteId < RoutePatterns.Num(); RouteId += FShard::ChunkSize)
+		{
+			const FRouteCounters* Chunk = Shard->Chunks[RouteId / FShard::ChunkSize].load(std::memory_order_acquire);
+			if (!Chunk)
+			{
+				continue;
+			}
+
+			const int32 ChunkEnd = FMath::Min(RouteId + FShard::ChunkSize, RoutePatterns.Num());
+			for (int32 Index = RouteId; Index < ChunkEnd; ++Index)
+			{
+				OutBytesIn += Read(Chunk[Index - RouteId].BytesIn);
+				OutBytesOut += Read(Chunk[Index - RouteId].BytesOut);
+			}
+		}
+	}
+}
+
+void FHttpServerMetrics::Export(TArray<uint8>& Out) const
+{
+	TArray<FRouteTotals> Totals;
+	TArray<FString> Patterns;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		Patterns = RoutePatterns;
+		Totals.SetNum(Patterns.Num());
+
+		for (const TUniquePtr<FShard>& Shard : Shards)
+		{
+			for (int32 RouteId = 0; RouteId < Totals.Num(); RouteId += FShard::ChunkSize)
+			{
+				const FRouteCounters* Chunk = Shard->Chunks[RouteId / FShard::ChunkSize].load(std::memory_order_acquire);
+				if (!Chunk)
+				{
+					continue;
+				}
+
+				const int32 ChunkEnd = FMath::Min(RouteId + FShard::ChunkSize, Totals.Num());
+				for (int32 Index = RouteId; Index < ChunkEnd; ++Index)
+				{
+					const FRouteCounters& Counters = Chunk[Index - RouteId];
+					FRouteTotals& Route = Totals[Index];
+
+					Route.Requests += Read(Counters.Requests);
+					for (int32 Status = 0; Status < NumStatusClasses; ++Status)
+					{
+						Route.Statuses[Status] += Read(Counters.Statuses[Status]);
+					}
+					Route.BytesIn += Read(Counters.BytesIn);
+					Route.BytesOut += Read(Counters.BytesOut);
+					Counters.QueueWait.AddTo(Route.QueueWait);
+					Counters.Handler.AddTo(Route.Handler);
+				}
+			}
+		}
+	}
+
+	TStringBuilder<4096> Text;
+
+	auto AppendRoute = [&Text, &Patterns](int32 RouteId)
+	{
+		Text.Append(TEXT("route=\""));
+		AppendLabelValue(Text, Patterns[RouteId]);
+		Text.AppendChar(TEXT('"'));
+	};
+
+	auto AppendCounter = [&](const TCHAR* Name, const TCHAR* Help, TFunctionRef<uint64(const FRouteTotals&)> GetValue)
+	{
+		Text.Appendf(TEXT("# HELP %s %s\n# TYPE %s counter\n"), Name, Help, Name);
+		for (int32 RouteId = 0; RouteId < Totals.Num(); ++RouteId)
+		{
+			if (Totals[RouteId].Requests > 0)
+			{
+				Text.Appendf(TEXT("%s{"), Name);
+				AppendRoute(RouteId);
+				Text.Appendf(TEXT("} %llu\n"), GetValue(Totals[RouteId]));
+			}
+		}
+	};
+
+	auto AppendHistogram = [&](const TCHAR* Name, const TCHAR* Help, FHistogramTotals FRouteTotals::*Histogram)
+	{
+		Text.Appendf(TEXT("# HELP %s %s\n# TYPE %s histogram\n"), Name, Help, Name);
+		for (int32 RouteId = 0; RouteId < Totals.Num(); ++RouteId)
+		{
+			const FHistogramTotals& Values = Totals[RouteId].*Histogram;
+			if (Values.Count == 0)
+			{
+				continue;
+			}
+
+			uint64 Cumulative = 0;
+			for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+			{
+				Cumulative += Values.Buckets[Bucket];
+				Text.Appendf(TEXT("%s_bucket{"), Name);
+				AppendRoute(RouteId);
+				Text.Appendf(TEXT(",le=\"%s\"} %llu\n"), BucketLabels[Bucket], Cumulative);
+			}
+
+			Text.Appendf(TEXT("%s_sum{"), Name);
+			AppendRoute(RouteId);
+			Text.Appendf(TEXT("} %.6f\n"), Values.SumMicros / 1000000.0);
+
+			Text.Appendf(TEXT("%s_count{"), Name);
+			AppendRoute(RouteId);
+			Text.Appendf(TEXT("} %llu\n"), Values.Count);
+		}
+	};
+
+	AppendCounter(TEXT("simplehttpserver_requests_total"), TEXT("Responses sent by route."), [](const FRouteTotals& Route) { return Route.Requests; });
+
+	Text.Append(TEXT("# HELP simplehttpserver_responses_total Responses sent by route and status class.\n# TYPE simplehttpserver_responses_total counter\n"));
+	for (int32 RouteId = 0; RouteId < Totals.Num(); ++RouteId)
+	{
+		for (int32 Status = 0; Status < NumStatusClasses; ++Status)
+		{
+			if (Totals[RouteId].Statuses[Status] > 0)
+			{
+				Text.Append(TEXT("simplehttpserver_responses_total{"));
+				AppendRoute(RouteId);
+				Text.Appendf(TEXT(",code=\"%dxx\"} %llu\n"), Status + 1, Totals[RouteId].Statuses[Status]);
+			}
+		}
+	}
+
+	AppendCounter(TEXT("simplehttpserver_request_bytes_total"), TEXT("Request body bytes received by route."), [](const FRouteTotals& Route) { return Route.BytesIn; });
+	AppendCounter(TEXT("simplehttpserver_response_bytes_total"), TEXT("Response body bytes sent by route, after compression."), [](const FRouteTotals& Route) { return Route.BytesOut; });
+
+	AppendHistogram(TEXT("simplehttpserver_queue_wait_seconds"), TEXT("Time from dispatch until the route handler started."), &FRouteTotals::QueueWait);
+	AppendHistogram(TEXT("simplehttpserver_handler_seconds"), TEXT("Time spent running the route handler."), &FRouteTotals::Handler);
+
+	FHttpResponseBuilder::AppendUtf8(Out, Text.ToView());
+}
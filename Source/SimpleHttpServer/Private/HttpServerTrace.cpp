@@ -0,0 +1,48 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpServerTrace.h"
+
+#if SIMPLEHTTPSERVER_TRACE_ENABLED
+
+#include "HttpServerResponse.h"
+
+UE_TRACE_CHANNEL_DEFINE(SimpleHttpServerChannel);
+
+UE_TRACE_EVENT_BEGIN(SimpleHttpServer, RequestStage)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint64, RequestId)
+	UE_TRACE_EVENT_FIELD(uint8, Stage)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(SimpleHttpServer, RouteMatch)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint64, RequestId)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, Route)
+UE_TRACE_EVENT_END()
+
+void FHttpServerTrace::ReportStage(uint64 RequestId, EHttpTraceStage Stage)
+{
+	UE_TRACE_LOG(SimpleHttpServer, RequestStage, SimpleHttpServerChannel)
+		<< RequestStage.Cycle(FPlatformTime::Cycles64())
+		<< RequestStage.RequestId(RequestId)
+		<< RequestStage.Stage((uint8)Stage);
+}
+
+void FHttpServerTrace::ReportRoute(uint64 RequestId, FStringView Route)
+{
+	UE_TRACE_LOG(SimpleHttpServer, RouteMatch, SimpleHttpServerChannel)
+		<< RouteMatch.Cycle(FPlatformTime::Cycles64())
+		<< RouteMatch.RequestId(RequestId)
+		<< RouteMatch.Route(Route.GetData(), Route.Len());
+}
+
+FHttpResultCallback FHttpServerTrace::MakeStageCallback(uint64 RequestId, EHttpTraceStage Stage, FHttpResultCallback&& OnComplete)
+{
+	return [RequestId, Stage, OnComplete = MoveTemp(OnComplete)](TUniquePtr<FHttpServerResponse>&& Response)
+	{
+		ReportStage(RequestId, Stage);
+		OnComplete(MoveTemp(Response));
+	};
+}
+
+#endif
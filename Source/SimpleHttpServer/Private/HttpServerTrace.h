@@ -0,0 +1,75 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpResultCallback.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+// Stages of a request reported to Unreal Insights
+enum class EHttpTraceStage : uint8
+{
+	Receive,
+	RouteMatch,
+	FillRequest,
+	Execute,
+	Compress,
+	Send
+};
+
+#ifndef SIMPLEHTTPSERVER_TRACE_ENABLED
+#define SIMPLEHTTPSERVER_TRACE_ENABLED (UE_TRACE_ENABLED && CPUPROFILERTRACE_ENABLED && !UE_BUILD_SHIPPING)
+#endif
+
+#if SIMPLEHTTPSERVER_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_EXTERN(SimpleHttpServerChannel);
+
+/**
+ * Request lifecycle events of "SimpleHttpServer" trace channel. Enable it with -trace=cpu,SimpleHttpServer.
+ * Every stage is a CPU scope and a RequestStage event with request id, RouteMatch event also carries the route pattern.
+ */
+struct FHttpServerTrace
+{
+	static void ReportStage(uint64 RequestId, EHttpTraceStage Stage);
+	static void ReportRoute(uint64 RequestId, FStringView Route);
+
+	// Report Stage when OnComplete gets the response
+	static FHttpResultCallback MakeStageCallback(uint64 RequestId, EHttpTraceStage Stage, FHttpResultCallback&& OnComplete);
+};
+
+#define SIMPLEHTTPSERVER_TRACE_IS_ENABLED() UE_TRACE_CHANNELEXPR_IS_ENABLED(SimpleHttpServerChannel)
+
+// CPU scope of stage without a request at hand, e.g. response builders nested in Execute
+#define SIMPLEHTTPSERVER_TRACE_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("SimpleHttpServer::" #Name, SimpleHttpServerChannel)
+
+// CPU scope of stage tagged with request id
+#define SIMPLEHTTPSERVER_TRACE_STAGE_SCOPE(RequestId, Name) \
+	SIMPLEHTTPSERVER_TRACE_SCOPE(Name); \
+	if (SIMPLEHTTPSERVER_TRACE_IS_ENABLED()) \
+	{ \
+		FHttpServerTrace::ReportStage(RequestId, EHttpTraceStage::Name); \
+	}
+
+#define SIMPLEHTTPSERVER_TRACE_ROUTE(RequestId, Route) \
+	if (SIMPLEHTTPSERVER_TRACE_IS_ENABLED()) \
+	{ \
+		FHttpServerTrace::ReportRoute(RequestId, Route); \
+	}
+
+// Wrap completion callback only while the channel is on, so there is no extra allocation otherwise
+#define SIMPLEHTTPSERVER_TRACE_CALLBACK(RequestId, Name, Callback) \
+	if (SIMPLEHTTPSERVER_TRACE_IS_ENABLED()) \
+	{ \
+		Callback = FHttpServerTrace::MakeStageCallback(RequestId, EHttpTraceStage::Name, MoveTemp(Callback)); \
+	}
+
+#else
+
+#define SIMPLEHTTPSERVER_TRACE_SCOPE(Name)
+#define SIMPLEHTTPSERVER_TRACE_STAGE_SCOPE(RequestId, Name)
+#define SIMPLEHTTPSERVER_TRACE_ROUTE(RequestId, Route)
+#define SIMPLEHTTPSERVER_TRACE_CALLBACK(RequestId, Name, Callback)
+
+#endif
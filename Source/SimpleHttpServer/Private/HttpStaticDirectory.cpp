@@ -0,0 +1,470 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpStaticDirectory.h"
+#include "SimpleHttpServer.h"
+#include "HttpResponseBuilder.h"
+#include "HttpResponseCache.h"
+#include "HttpResponseCompression.h"
+#include "HttpConditionalRequest.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Async/Async.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "Hash/CityHash.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	constexpr int32 StreamChunkSize = 1024 * 1024;
+
+	// Producer waits while more is queued, so a slow client doesn't pull the whole file into memory
+	constexpr int64 StreamMaxQueuedBytes = 4 * StreamChunkSize;
+
+	bool WaitForStreamQueue(const FHttpStreamWriter& Writer)
+	{
+		while (Writer.IsOpen() && Writer.GetQueuedBytes() > StreamMaxQueuedBytes)
+		{
+			FPlatformProcess::Sleep(0.001f);
+		}
+
+		return Writer.IsOpen();
+	}
+
+	bool ParseRangeNumber(FStringView Text, int64& OutValue)
+	{
+		// Longer numbers could overflow int64, no file is that big
+		if (Text.IsEmpty() || Text.Len() > 18)
+		{
+			return false;
+		}
+
+		OutValue = 0;
+		for (const TCHAR Char : Text)
+		{
+			if (!FChar::IsDigit(Char))
+			{
+				return false;
+			}
+
+			OutValue = OutValue * 10 + (Char - TEXT('0'));
+		}
+
+		return true;
+	}
+}
+
+FHttpStaticDirectory::FHttpStaticDirectory(FString InRootDirectory, const TSharedRef<FHttpResponseCache>& InCache)
+	: RootDirectory(FPaths::ConvertRelativePathToFull(MoveTemp(InRootDirectory)))
+	, Cache(InCache)
+{
+}
+
+void FHttpStaticDirectory::HandleRequest(const FNativeHttpServerRequestView& Request, FHttpRouteCompletion Completion) const
+{
+	FString Filename;
+	FFileStatData StatData;
+	if (!FindFile(Request, Filename, StatData))
+	{
+		Completion.CompleteWithCode(EHttpServerResponseCodes::NotFound);
+		return;
+	}
+
+	const int64 FileSize = StatData.FileSize;
+
+	FHttpResponseBuilder Builder;
+	const uint64 ContentVersion = SetFileHeaders(Builder, Filename, StatData);
+
+	const FHttpConditionalRequest ConditionalRequest(Request.GetRequest());
+	if (ConditionalRequest.IsNotModified(Builder.GetResponse().Headers))
+	{
+		Completion.Complete(FHttpConditionalRequest::MakeNotModified(Builder.GetResponse().Headers));
+		return;
+	}
+
+	int64 RangeStart = 0;
+	int64 RangeEnd = FileSize - 1;
+	switch (ParseRange(Request.GetHeader(TEXT("range")), FileSize, RangeStart, RangeEnd))
+	{
+	case ERangeResult::Unsatisfiable:
+		Builder.SetCode((EHttpServerResponseCodes)416);
+		Builder.SetHeader(TEXT("content-range"), FString::Printf(TEXT("bytes */%lld"), FileSize));
+		Completion.Complete(MoveTemp(Builder));
+		return;
+
+	case ERangeResult::Satisfiable:
+		Builder.SetCode(EHttpServerResponseCodes::PartialContent);
+		Builder.SetHeader(TEXT("content-range"), FString::Printf(TEXT("bytes %lld-%lld/%lld"), RangeStart, RangeEnd, FileSize));
+		break;
+
+	default:
+		break;
+	}
+
+	const int64 Size = RangeEnd - RangeStart + 1;
+	if (StreamPort > 0 && Size >= StreamThreshold)
+	{
+		// HTTPServer sends bodies as a whole, the stream server sends the file in chunks
+		FString Location = MakeStreamLocation(Request);
+		if (!Location.IsEmpty())
+		{
+			FHttpResponseBuilder Redirect((EHttpServerResponseCodes)307);
+			Redirect.SetHeader(TEXT("location"), MoveTemp(Location));
+			Completion.Complete(MoveTemp(Redirect));
+			return;
+		}
+
+		UE_LOG(LogSimpleHttpServer, Warning, TEXT("Host '%s' is not in StreamAllowedHosts, file '%s' is sent without streaming."), *FString(Request.GetHeader(TEXT("host"))), *Filename);
+	}
+
+	if (Size > MAX_int32)
+	{
+		// Response body is TArray
+		UE_LOG(LogSimpleHttpServer, Error, TEXT("File '%s' part of %lld bytes is too big for a single response. Serve the directory with bStreamLargeFiles."), *Filename, Size);
+		Completion.CompleteWithCode(EHttpServerResponseCodes::ServerError);
+		return;
+	}
+
+	// Compressed encodings of whole files are made once per file version
+	const FName Encoding = bCompress && Builder.GetResponse().Code == EHttpServerResponseCodes::Ok ? FHttpResponseCompression::NegotiateEncoding(Request.GetRequest()) : NAME_None;
+	const bool bShouldCompress = !Encoding.IsNone() && FHttpResponseCompression::ShouldCompress(Builder.GetResponse().Headers, (int32)Size, CompressionMinSize);
+
+	TSharedPtr<FHttpResponseCache> PinnedCache = Cache.Pin();
+	if (bShouldCompress && PinnedCache.IsValid())
+	{
+		if (TSharedPtr<const TArray<uint8>> EncodedBody = PinnedCache->FindEncodedBody(ContentVersion, Encoding))
+		{
+			if (EncodedBody->Num() > 0)
+			{
+				Builder.SetBody(TArray<uint8>(*EncodedBody));
+				FHttpResponseCompression::SetEncodingHeaders(Builder.GetResponse(), Encoding);
+				Completion.Complete(MoveTemp(Builder));
+				return;
+			}
+		}
+	}
+
+	if (!ReadFileRange(Filename, RangeStart, Size, Builder.GetBody()))
+	{
+		UE_LOG(LogSimpleHttpServer, Error, TEXT("Could not read file '%s'."), *Filename);
+		Completion.CompleteWithCode(EHttpServerResponseCodes::ServerError);
+		return;
+	}
+
+	if (bShouldCompress)
+	{
+		TSharedRef<TArray<uint8>> EncodedBody = MakeShared<TArray<uint8>>();
+		FHttpResponseCompression::CompressBody(Builder.GetBody(), Encoding, *EncodedBody);
+
+		if (PinnedCache.IsValid())
+		{
+			PinnedCache->StoreEncodedBody(ContentVersion, Encoding, EncodedBody);
+		}
+
+		if (EncodedBody->Num() > 0)
+		{
+			// Encoded body is shared with the cache, keep it there
+			Builder.SetBody(TArray<uint8>(*EncodedBody));
+			FHttpResponseCompression::SetEncodingHeaders(Builder.GetResponse(), Encoding);
+		}
+	}
+
+	Completion.Complete(MoveTemp(Builder));
+}
+
+void FHttpStaticDirectory::HandleStreamRequest(const FNativeHttpServerRequestView& Request, FHttpStreamWriter Writer) const
+{
+	FString Filename;
+	FFileStatData StatData;
+	if (!FindFile(Request, Filename, StatData))
+	{
+		Writer.BeginResponse(EHttpServerResponseCodes::NotFound, TEXT("text/plain"));
+		Writer.Finish();
+		return;
+	}
+
+	const int64 FileSize = StatData.FileSize;
+
+	FHttpResponseBuilder Builder;
+	SetFileHeaders(Builder, Filename, StatData);
+
+	// Stream writer adds its own content type
+	TMap<FString, TArray<FString>> Headers = MoveTemp(Builder.GetResponse().Headers);
+	const FString ContentType = Headers.FindAndRemoveChecked(TEXT("content-type"))[0];
+
+	int64 RangeStart = 0;
+	int64 RangeEnd = FileSize - 1;
+	EHttpServerResponseCodes Code = EHttpServerResponseCodes::Ok;
+	switch (ParseRange(Request.GetHeader(TEXT("range")), FileSize, RangeStart, RangeEnd))
+	{
+	case ERangeResult::Unsatisfiable:
+		Headers.Add(TEXT("content-range"), { FString::Printf(TEXT("bytes */%lld"), FileSize) });
+		Writer.BeginResponse((EHttpServerResponseCodes)416, ContentType, MoveTemp(Headers));
+		Writer.Finish();
+		return;
+
+	case ERangeResult::Satisfiable:
+		Code = EHttpServerResponseCodes::PartialContent;
+		Headers.Add(TEXT("content-range"), { FString::Printf(TEXT("bytes %lld-%lld/%lld"), RangeStart, RangeEnd, FileSize) });
+		break;
+
+	default:
+		break;
+	}
+
+	Writer.BeginResponse(Code, ContentType, MoveTemp(Headers));
+
+	// Downloads can take minutes, keep them off the pools
+	Async(EAsyncExecution::Thread, [This = AsShared(), Filename = MoveTemp(Filename), RangeStart, Size = RangeEnd - RangeStart + 1, Writer = MoveTemp(Writer)]() mutable
+	{
+		if (This->StreamFileRange(Filename, RangeStart, Size, Writer))
+		{
+			Writer.Finish();
+		}
+		else
+		{
+			Writer.Abort();
+		}
+	});
+}
+
+FString FHttpStaticDirectory::GetMimeType(const FString& Filename)
+{
+	static const TMap<FString, FString> MimeTypes =
+	{
+		{ TEXT("html"), TEXT("text/html;charset=utf-8") },
+		{ TEXT("htm"), TEXT("text/html;charset=utf-8") },
+		{ TEXT("css"), TEXT("text/css;charset=utf-8") },
+		{ TEXT("js"), TEXT("text/javascript;charset=utf-8") },
+		{ TEXT("mjs"), TEXT("text/javascript;charset=utf-8") },
+		{ TEXT("json"), TEXT("application/json;charset=utf-8") },
+		{ TEXT("map"), TEXT("application/json;charset=utf-8") },
+		{ TEXT("txt"), TEXT("text/plain;charset=utf-8") },
+		{ TEXT("log"), TEXT("text/plain;charset=utf-8") },
+		{ TEXT("csv"), TEXT("text/csv;charset=utf-8") },
+		{ TEXT("xml"), TEXT("application/xml;charset=utf-8") },
+		{ TEXT("svg"), TEXT("image/svg+xml") },
+		{ TEXT("png"), TEXT("image/png") },
+		{ TEXT("jpg"), TEXT("image/jpeg") },
+		{ TEXT("jpeg"), TEXT("image/jpeg") },
+		{ TEXT("gif"), TEXT("image/gif") },
+		{ TEXT("webp"), TEXT("image/webp") },
+		{ TEXT("ico"), TEXT("image/x-icon") },
+		{ TEXT("wasm"), TEXT("application/wasm") },
+		{ TEXT("woff"), TEXT("font/woff") },
+		{ TEXT("woff2"), TEXT("font/woff2") },
+		{ TEXT("ttf"), TEXT("font/ttf") },
+		{ TEXT("mp3"), TEXT("audio/mpeg") },
+		{ TEXT("wav"), TEXT("audio/wav") },
+		{ TEXT("ogg"), TEXT("audio/ogg") },
+		{ TEXT("mp4"), TEXT("video/mp4") },
+		{ TEXT("webm"), TEXT("video/webm") },
+		{ TEXT("pdf"), TEXT("application/pdf") },
+		{ TEXT("zip"), TEXT("application/zip") },
+	};
+
+	const FString* MimeType = MimeTypes.Find(FPaths::GetExtension(Filename));
+	return MimeType ? *MimeType : TEXT("application/octet-stream");
+}
+
+FHttpStaticDirectory::ERangeResult FHttpStaticDirectory::ParseRange(FStringView RangeHeader, int64 FileSize, int64& OutStart, int64& OutEnd)
+{
+	RangeHeader.TrimStartAndEndInline();
+	if (!RangeHeader.StartsWith(TEXT("bytes="), ESearchCase::IgnoreCase))
+	{
+		return ERangeResult::Ignored;
+	}
+
+	RangeHeader.RightChopInline(6);
+
+	int32 Separator = INDEX_NONE;
+	if (RangeHeader.FindChar(TEXT(','), Separator) || !RangeHeader.FindChar(TEXT('-'), Separator))
+	{
+		return ERangeResult::Ignored;
+	}
+
+	const FStringView StartText = RangeHeader.Left(Separator).TrimStartAndEnd();
+	const FStringView EndText = RangeHeader.RightChop(Separator + 1).TrimStartAndEnd();
+
+	int64 Start = 0;
+	int64 End = 0;
+
+	// "bytes=-500" is the last 500 bytes
+	if (StartText.IsEmpty())
+	{
+		if (!ParseRangeNumber(EndText, End))
+		{
+			return ERangeResult::Ignored;
+		}
+
+		if (End <= 0 || FileSize <= 0)
+		{
+			return ERangeResult::Unsatisfiable;
+		}
+
+		OutStart = FMath::Max<int64>(FileSize - End, 0);
+		OutEnd = FileSize - 1;
+		return ERangeResult::Satisfiable;
+	}
+
+	if (!ParseRangeNumber(StartText, Start) || (!EndText.IsEmpty() && !ParseRangeNumber(EndText, End)))
+	{
+		return ERangeResult::Ignored;
+	}
+
+	if (Start >= FileSize)
+	{
+		return ERangeResult::Unsatisfiable;
+	}
+
+	OutStart = Start;
+	OutEnd = EndText.IsEmpty() ? FileSize - 1 : FMath::Min(End, FileSize - 1);
+	return OutEnd >= OutStart ? ERangeResult::Satisfiable : ERangeResult::Ignored;
+}
+
+FString FHttpStaticDirectory::ResolveFilename(FStringView RelativePath) const
+{
+	FString DecodedPath(RelativePath);
+	if (DecodedPath.Contains(TEXT("%")))
+	{
+		DecodedPath = FGenericPlatformHttp::UrlDecode(DecodedPath);
+	}
+
+	// Collapses ".." so the check below catches paths escaping root
+	FString Filename = FPaths::ConvertRelativePathToFull(RootDirectory, DecodedPath);
+	if (Filename != RootDirectory && !FPaths::IsUnderDirectory(Filename, RootDirectory))
+	{
+		return FString();
+	}
+
+	return Filename;
+}
+
+bool FHttpStaticDirectory::FindFile(const FNativeHttpServerRequestView& Request, FString& OutFilename, FFileStatData& OutStatData) const
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	OutFilename = ResolveFilename(Request.GetPathParam(TEXT("path")));
+	if (OutFilename.IsEmpty())
+	{
+		return false;
+	}
+
+	if (PlatformFile.DirectoryExists(*OutFilename))
+	{
+		OutFilename = FPaths::Combine(OutFilename, TEXT("index.html"));
+	}
+
+	OutStatData = PlatformFile.GetStatData(*OutFilename);
+	return OutStatData.bIsValid && !OutStatData.bIsDirectory;
+}
+
+uint64 FHttpStaticDirectory::SetFileHeaders(FHttpResponseBuilder& Builder, const FString& Filename, const FFileStatData& StatData) const
+{
+	// File version changes with size and modification time
+	const uint64 ContentVersion = CityHash64WithSeed(reinterpret_cast<const char*>(*Filename), Filename.Len() * sizeof(TCHAR), (uint64)StatData.ModificationTime.GetTicks() ^ (uint64)StatData.FileSize);
+
+	Builder.SetHeader(TEXT("content-type"), GetMimeType(Filename));
+	Builder.SetHeader(TEXT("accept-ranges"), TEXT("bytes"));
+	Builder.SetHeader(TEXT("cache-control"), FString::Printf(TEXT("max-age=%d"), MaxAgeSeconds));
+	Builder.SetETag(FString::Printf(TEXT("%016llx"), ContentVersion));
+	Builder.SetLastModified(StatData.ModificationTime);
+
+	return ContentVersion;
+}
+
+FString FHttpStaticDirectory::MakeStreamLocation(const FNativeHttpServerRequestView& Request) const
+{
+	// Drop port of "host:port" and "[v6]:port"
+	FStringView Host = Request.GetHeader(TEXT("host"));
+	int32 Colon = INDEX_NONE;
+	int32 Bracket = INDEX_NONE;
+	if (Host.FindLastChar(TEXT(':'), Colon) && (!Host.FindLastChar(TEXT(']'), Bracket) || Colon > Bracket))
+	{
+		Host.LeftInline(Colon);
+	}
+
+	TStringBuilder<256> Location;
+	if (!StreamBaseUrl.IsEmpty())
+	{
+		Location << StreamBaseUrl;
+	}
+	else if (!Host.IsEmpty() && StreamAllowedHosts.ContainsByPredicate([Host](const FString& AllowedHost) { return Host.Equals(AllowedHost, ESearchCase::IgnoreCase); }))
+	{
+		// Host header is up to the client, it may only pick one of the names the server is known by
+		Location << TEXT("http://") << Host << TEXT(':') << StreamPort;
+	}
+	else
+	{
+		return FString();
+	}
+
+	Location << Request.GetRelativePath();
+
+	TCHAR Separator = TEXT('?');
+	for (const TPair<FString, FString>& QueryParam : Request.GetRequest().QueryParams)
+	{
+		Location << Separator << FGenericPlatformHttp::UrlEncode(QueryParam.Key) << TEXT('=') << FGenericPlatformHttp::UrlEncode(QueryParam.Value);
+		Separator = TEXT('&');
+	}
+
+	return FString(Location.ToView());
+}
+
+bool FHttpStaticDirectory::ReadFileRange(const FString& Filename, int64 Offset, int64 Size, TArray<uint8>& OutBytes)
+{
+	// Body must own its bytes, so a mapping would only add a copy. Large parts are streamed instead.
+	TUniquePtr<IFileHandle> FileHandle(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+	if (!FileHandle.IsValid() || !FileHandle->Seek(Offset))
+	{
+		return false;
+	}
+
+	OutBytes.SetNumUninitialized((int32)Size);
+	return FileHandle->Read(OutBytes.GetData(), Size);
+}
+
+bool FHttpStaticDirectory::StreamFileRange(const FString& Filename, int64 Offset, int64 Size, FHttpStreamWriter& Writer) const
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	// Chunks are framed straight from the mapped pages
+	if (Size >= MapThreshold)
+	{
+		TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*Filename));
+		TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile.IsValid() ? MappedFile->MapRegion(Offset, Size) : nullptr);
+		if (MappedRegion.IsValid())
+		{
+			const uint8* Data = MappedRegion->GetMappedPtr();
+			for (int64 Sent = 0; Sent < Size; Sent += StreamChunkSize)
+			{
+				const int32 ChunkSize = (int32)FMath::Min<int64>(StreamChunkSize, Size - Sent);
+				if (!WaitForStreamQueue(Writer) || !Writer.Write(TArrayView<const uint8>(Data + Sent, ChunkSize)))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+	}
+
+	// Pak and IoStore files usually can't be mapped
+	TUniquePtr<IFileHandle> FileHandle(PlatformFile.OpenRead(*Filename));
+	if (!FileHandle.IsValid() || !FileHandle->Seek(Offset))
+	{
+		return false;
+	}
+
+	TArray<uint8> Chunk;
+	for (int64 Sent = 0; Sent < Size; Sent += StreamChunkSize)
+	{
+		const int32 ChunkSize = (int32)FMath::Min<int64>(StreamChunkSize, Size - Sent);
+		Chunk.SetNumUninitialized(ChunkSize, false);
+		if (!FileHandle->Read(Chunk.GetData(), ChunkSize) || !WaitForStreamQueue(Writer) || !Writer.Write(TArrayView<const uint8>(Chunk)))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
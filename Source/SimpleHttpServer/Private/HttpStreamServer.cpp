@@ -0,0 +1,645 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpStreamServer.h"
+#include "HttpStreamSocket.h"
+#include "SimpleHttpServer.h"
+#include "HttpResponseBuilder.h"
+#include "Interfaces/IPv4/IPv4Address.h"
+#include "HAL/RunnableThread.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+
+namespace
+{
+	const TCHAR* GetReasonPhrase(int32 Code)
+	{
+		switch (Code)
+		{
+		case 101: return TEXT("Switching Protocols");
+		case 200: return TEXT("OK");
+		case 204: return TEXT("No Content");
+		case 400: return TEXT("Bad Request");
+		case 403: return TEXT("Forbidden");
+		case 404: return TEXT("Not Found");
+		case 405: return TEXT("Method Not Allowed");
+		case 408: return TEXT("Request Timeout");
+		case 413: return TEXT("Payload Too Large");
+		case 426: return TEXT("Upgrade Required");
+		case 500: return TEXT("Internal Server Error");
+		case 503: return TEXT("Service Unavailable");
+		default: return TEXT("Status");
+		}
+	}
+
+	FString BytesToString(const uint8* Data, int32 Num)
+	{
+		FUTF8ToTCHAR TCHARData(reinterpret_cast<const ANSICHAR*>(Data), Num);
+		return FString(TCHARData.Length(), TCHARData.Get());
+	}
+
+	bool ParseVerb(FStringView Method, EHttpServerRequestVerbs& OutVerb)
+	{
+		static const TPair<const TCHAR*, EHttpServerRequestVerbs> Verbs[] =
+		{
+			{ TEXT("GET"), EHttpServerRequestVerbs::VERB_GET },
+			{ TEXT("POST"), EHttpServerRequestVerbs::VERB_POST },
+			{ TEXT("PUT"), EHttpServerRequestVerbs::VERB_PUT },
+			{ TEXT("PATCH"), EHttpServerRequestVerbs::VERB_PATCH },
+			{ TEXT("DELETE"), EHttpServerRequestVerbs::VERB_DELETE },
+			{ TEXT("OPTIONS"), EHttpServerRequestVerbs::VERB_OPTIONS }
+		};
+
+		for (const TPair<const TCHAR*, EHttpServerRequestVerbs>& Verb : Verbs)
+		{
+			if (Method.Equals(Verb.Key, ESearchCase::CaseSensitive))
+			{
+				OutVerb = Verb.Value;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void ParseQuery(FStringView Query, TMap<FString, FString>& OutQueryParams)
+	{
+		while (!Query.IsEmpty())
+		{
+			int32 End = INDEX_NONE;
+			if (!Query.FindChar(TEXT('&'), End))
+			{
+				End = Query.Len();
+			}
+
+			const FStringView Pair = Query.Left(End);
+			Query.RightChopInline(End + 1);
+
+			if (Pair.IsEmpty())
+			{
+				continue;
+			}
+
+			int32 Equals = INDEX_NONE;
+			if (Pair.FindChar(TEXT('='), Equals))
+			{
+				OutQueryParams.Add(FGenericPlatformHttp::UrlDecode(FString(Pair.Left(Equals))), FGenericPlatformHttp::UrlDecode(FString(Pair.Mid(Equals + 1))));
+			}
+			else
+			{
+				OutQueryParams.Add(FGenericPlatformHttp::UrlDecode(FString(Pair)), FString());
+			}
+		}
+	}
+
+	bool ParseContentLength(FStringView Text, int64& OutValue)
+	{
+		// Longer numbers could overflow int64, requests are far smaller anyway
+		if (Text.IsEmpty() || Text.Len() > 18)
+		{
+			return false;
+		}
+
+		OutValue = 0;
+		for (const TCHAR Char : Text)
+		{
+			if (!FChar::IsDigit(Char))
+			{
+				return false;
+			}
+
+			OutValue = OutValue * 10 + (Char - TEXT('0'));
+		}
+
+		return true;
+	}
+}
+
+FHttpStreamWakeup::FHttpStreamWakeup()
+	: Socket(FHttpStreamSocket::CreateLoopbackDatagram())
+{
+	if (!Socket)
+	{
+		UE_LOG(LogSimpleHttpServer, Warning, TEXT("Could not create stream server wakeup socket, stream server will poll its connections."));
+	}
+}
+
+FHttpStreamWakeup::~FHttpStreamWakeup()
+{
+}
+
+void FHttpStreamWakeup::Trigger()
+{
+	if (Socket && !bPending.exchange(true))
+	{
+		const uint8 Byte = 0;
+		int32 BytesSent = 0;
+		Socket->Send(&Byte, 1, BytesSent);
+	}
+}
+
+void FHttpStreamWakeup::Reset()
+{
+	if (!Socket)
+	{
+		return;
+	}
+
+	uint8 Buffer[64];
+	int32 BytesRead = 0;
+	while (Socket->Recv(Buffer, sizeof(Buffer), BytesRead) && BytesRead > 0)
+	{
+	}
+
+	// Cleared after draining, so a trigger that comes in between is either drained or finds the flag still set while its work is about to be picked up
+	bPending = false;
+}
+
+FHttpStreamConnection::FHttpStreamConnection(TUniquePtr<FHttpStreamSocket>&& InSocket, uint32 InId, const TSharedRef<FHttpStreamWakeup>& InWakeup)
+	: Socket(MoveTemp(InSocket))
+	, Id(InId)
+	, Wakeup(InWakeup)
+	, LastActivityTime(FPlatformTime::Seconds())
+{
+}
+
+FHttpStreamConnection::~FHttpStreamConnection()
+{
+}
+
+bool FHttpStreamConnection::Send(const TSharedRef<const TArray<uint8>>& Buffer)
+{
+	return Send(MakeArrayView(&Buffer, 1));
+}
+
+bool FHttpStreamConnection::Send(TArray<uint8>&& Bytes)
+{
+	return Send(MakeShared<const TArray<uint8>>(MoveTemp(Bytes)));
+}
+
+bool FHttpStreamConnection::Send(TArrayView<const TSharedRef<const TArray<uint8>>> Buffers)
+{
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	{
+		FScopeLock ScopeLock(&SendLock);
+		for (const TSharedRef<const TArray<uint8>>& Buffer : Buffers)
+		{
+			if (Buffer->Num() > 0)
+			{
+				SendQueue.Add(FPendingBuffer{ Buffer, 0 });
+				QueuedBytes += Buffer->Num();
+			}
+		}
+	}
+
+	Wakeup->Trigger();
+	return true;
+}
+
+void FHttpStreamConnection::Close()
+{
+	bCloseRequested = true;
+	Wakeup->Trigger();
+}
+
+void FHttpStreamConnection::Abort()
+{
+	{
+		FScopeLock ScopeLock(&SendLock);
+		SendQueue.Reset();
+		QueuedBytes = 0;
+	}
+
+	Close();
+}
+
+bool FHttpStreamConnection::Receive()
+{
+	uint8 Buffer[4096];
+	int32 BytesRead = 0;
+
+	// Non-blocking socket returns true with zero bytes when there is nothing to read, and false when peer is gone
+	while (Socket->Recv(Buffer, sizeof(Buffer), BytesRead))
+	{
+		if (BytesRead <= 0)
+		{
+			return true;
+		}
+
+		ReceiveBuffer.Append(Buffer, BytesRead);
+		LastActivityTime = FPlatformTime::Seconds();
+	}
+
+	return false;
+}
+
+bool FHttpStreamConnection::Flush()
+{
+	FScopeLock ScopeLock(&SendLock);
+
+	int32 NumSent = 0;
+	bool bSentAnything = false;
+	for (; NumSent < SendQueue.Num(); ++NumSent)
+	{
+		FPendingBuffer& Pending = SendQueue[NumSent];
+		const int32 Remaining = Pending.Buffer->Num() - Pending.Offset;
+
+		int32 BytesSent = 0;
+		if (!Socket->Send(Pending.Buffer->GetData() + Pending.Offset, Remaining, BytesSent))
+		{
+			bSendFailed = true;
+			break;
+		}
+
+		if (BytesSent > 0)
+		{
+			bSentAnything = true;
+			QueuedBytes -= BytesSent;
+		}
+
+		if (BytesSent < Remaining)
+		{
+			// Socket buffer is full, continue on the next pass
+			Pending.Offset += BytesSent;
+			break;
+		}
+	}
+
+	if (NumSent > 0)
+	{
+		SendQueue.RemoveAt(0, NumSent, false);
+	}
+
+	return bSentAnything;
+}
+
+void FHttpStreamConnection::Shutdown()
+{
+	if (bClosed.exchange(true))
+	{
+		return;
+	}
+
+	Socket.Reset();
+
+	{
+		FScopeLock ScopeLock(&SendLock);
+		SendQueue.Reset();
+		QueuedBytes = 0;
+	}
+
+	if (OnClosed)
+	{
+		OnClosed();
+	}
+
+	// Callbacks can hold references back to this connection
+	OnData = nullptr;
+	OnClosed = nullptr;
+}
+
+bool FHttpStreamConnection::HasPendingSend() const
+{
+	FScopeLock ScopeLock(&SendLock);
+	return SendQueue.Num() > 0;
+}
+
+FHttpStreamServer::FHttpStreamServer(FHttpStreamRequestHandler InOnRequest)
+	: OnRequest(MoveTemp(InOnRequest))
+	, WakeupSocket(MakeShared<FHttpStreamWakeup>())
+{
+}
+
+FHttpStreamServer::~FHttpStreamServer()
+{
+	Stop();
+}
+
+bool FHttpStreamServer::Start(const FString& BindAddress, int32 InPort)
+{
+	if (IsRunning())
+	{
+		return true;
+	}
+
+	FIPv4Address Address;
+	if (!FIPv4Address::Parse(BindAddress, Address))
+	{
+		UE_LOG(LogSimpleHttpServer, Error, TEXT("Invalid stream server bind address: '%s'"), *BindAddress);
+		return false;
+	}
+
+	Listener = FHttpStreamSocket::Listen(Address, InPort);
+	if (!Listener)
+	{
+		UE_LOG(LogSimpleHttpServer, Error, TEXT("Could not start stream server on %s:%d"), *BindAddress, InPort);
+		return false;
+	}
+
+	Port = InPort;
+	bStopping = false;
+	Thread = FRunnableThread::Create(this, TEXT("SimpleHttpStreamServer"), 128 * 1024, TPri_Normal);
+
+	UE_LOG(LogSimpleHttpServer, Log, TEXT("Stream server started on %s:%d"), *BindAddress, Port);
+	return true;
+}
+
+void FHttpStreamServer::Stop()
+{
+	if (Thread)
+	{
+		bStopping = true;
+		Wakeup();
+
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	// Server thread is gone, nothing accepts from it anymore
+	Listener.Reset();
+}
+
+void FHttpStreamServer::Wakeup()
+{
+	WakeupSocket->Trigger();
+}
+
+bool FHttpStreamServer::AcceptConnections()
+{
+	bool bAccepted = false;
+	while (TUniquePtr<FHttpStreamSocket> Socket = Listener->Accept())
+	{
+		Connections.Add(MakeShared<FHttpStreamConnection>(MoveTemp(Socket), NextConnectionId++, WakeupSocket));
+		bAccepted = true;
+	}
+
+	return bAccepted;
+}
+
+uint32 FHttpStreamServer::Run()
+{
+	while (!bStopping)
+	{
+		bool bDidWork = AcceptConnections();
+
+		for (int32 Index = Connections.Num() - 1; Index >= 0; --Index)
+		{
+			const TSharedRef<FHttpStreamConnection> Connection = Connections[Index];
+			ProcessConnection(Connection, bDidWork);
+
+			if (Connection->bClosed)
+			{
+				Connections.RemoveAtSwap(Index, 1, false);
+			}
+		}
+
+		NumConnections = Connections.Num();
+
+		if (!bDidWork)
+		{
+			WaitForSockets();
+		}
+	}
+
+	for (const TSharedRef<FHttpStreamConnection>& Connection : Connections)
+	{
+		Connection->Shutdown();
+	}
+	Connections.Reset();
+	NumConnections = 0;
+
+	return 0;
+}
+
+void FHttpStreamServer::WaitForSockets()
+{
+	if (FHttpStreamSocket* Socket = WakeupSocket->GetSocket())
+	{
+		TArray<FHttpStreamSocket::FWaitEntry, TInlineAllocator<64>> Entries;
+		Entries.Add({ Socket, false });
+		Entries.Add({ Listener.Get(), false });
+		for (const TSharedRef<FHttpStreamConnection>& Connection : Connections)
+		{
+			if (Connection->Socket)
+			{
+				Entries.Add({ Connection->Socket.Get(), Connection->HasPendingSend() });
+			}
+		}
+
+		// Timeout only matters for requests that never complete
+		FHttpStreamSocket::Wait(Entries, 1000);
+		WakeupSocket->Reset();
+		return;
+	}
+
+	FPlatformProcess::Sleep(Connections.Num() > 0 ? 0.005f : 0.1f);
+}
+
+void FHttpStreamServer::ProcessConnection(const TSharedRef<FHttpStreamConnection>& Connection, bool& bOutDidWork)
+{
+	if (!Connection->Receive())
+	{
+		Connection->Shutdown();
+		return;
+	}
+
+	if (!Connection->bRequestDispatched && Connection->ReceiveBuffer.Num() > 0)
+	{
+		FHttpServerRequest Request;
+		const int32 Consumed = ParseRequest(Connection->ReceiveBuffer, MaxRequestSize, Request);
+		if (Consumed < 0)
+		{
+			SendErrorAndClose(Connection, 400);
+		}
+		else if (Consumed > 0)
+		{
+			Connection->bRequestDispatched = true;
+			Connection->ReceiveBuffer.RemoveAt(0, Consumed, false);
+
+			if (!OnRequest || !OnRequest(Connection, Request))
+			{
+				SendErrorAndClose(Connection, 404);
+			}
+
+			bOutDidWork = true;
+		}
+	}
+
+	if (!Connection->bRequestDispatched && FPlatformTime::Seconds() - Connection->LastActivityTime > RequestTimeoutSeconds)
+	{
+		SendErrorAndClose(Connection, 408);
+	}
+
+	if (Connection->bRequestDispatched && Connection->ReceiveBuffer.Num() > 0)
+	{
+		if (Connection->OnData)
+		{
+			Connection->OnData(Connection->ReceiveBuffer);
+			bOutDidWork = true;
+		}
+
+		Connection->ReceiveBuffer.Reset();
+	}
+
+	if (Connection->Flush())
+	{
+		bOutDidWork = true;
+	}
+
+	if (Connection->bSendFailed || (Connection->bCloseRequested && !Connection->HasPendingSend()))
+	{
+		Connection->Shutdown();
+	}
+}
+
+void FHttpStreamServer::SendErrorAndClose(const TSharedRef<FHttpStreamConnection>& Connection, int32 Code)
+{
+	if (!Connection->IsOpen())
+	{
+		return;
+	}
+
+	// Don't wait for request that will never be handled
+	Connection->bRequestDispatched = true;
+
+	TMap<FString, TArray<FString>> Headers;
+	Headers.Add(TEXT("content-length"), { TEXT("0") });
+	Headers.Add(TEXT("connection"), { TEXT("close") });
+
+	Connection->Send(MakeResponseHead(Code, Headers));
+	Connection->Close();
+}
+
+int32 FHttpStreamServer::ParseRequest(TArrayView<const uint8> Data, int32 MaxRequestSize, FHttpServerRequest& OutRequest)
+{
+	// Find the end of headers
+	int32 HeaderEnd = INDEX_NONE;
+	for (int32 Index = 0; Index + 3 < Data.Num(); ++Index)
+	{
+		if (Data[Index] == '\r' && Data[Index + 1] == '\n' && Data[Index + 2] == '\r' && Data[Index + 3] == '\n')
+		{
+			HeaderEnd = Index;
+			break;
+		}
+	}
+
+	if (HeaderEnd == INDEX_NONE)
+	{
+		return Data.Num() > MaxRequestSize ? -1 : 0;
+	}
+
+	const FString Head = BytesToString(Data.GetData(), HeaderEnd);
+	FStringView HeadView = Head;
+
+	int32 LineEnd = INDEX_NONE;
+	if (!HeadView.FindChar(TEXT('\r'), LineEnd))
+	{
+		LineEnd = HeadView.Len();
+	}
+
+	// METHOD SP TARGET SP VERSION
+	const FStringView RequestLine = HeadView.Left(LineEnd);
+	HeadView.RightChopInline(LineEnd + 2);
+
+	int32 MethodEnd = INDEX_NONE;
+	int32 TargetEnd = INDEX_NONE;
+	if (!RequestLine.FindChar(TEXT(' '), MethodEnd) || !RequestLine.FindLastChar(TEXT(' '), TargetEnd) || TargetEnd <= MethodEnd)
+	{
+		return -1;
+	}
+
+	if (!ParseVerb(RequestLine.Left(MethodEnd), OutRequest.Verb))
+	{
+		return -1;
+	}
+
+	FStringView Target = RequestLine.Mid(MethodEnd + 1, TargetEnd - MethodEnd - 1);
+	if (Target.IsEmpty() || Target[0] != TEXT('/'))
+	{
+		return -1;
+	}
+
+	int32 QueryStart = INDEX_NONE;
+	if (Target.FindChar(TEXT('?'), QueryStart))
+	{
+		ParseQuery(Target.Mid(QueryStart + 1), OutRequest.QueryParams);
+		Target.LeftInline(QueryStart);
+	}
+
+	OutRequest.RelativePath = FHttpPath(FString(Target));
+
+	int64 ContentLength = 0;
+	while (!HeadView.IsEmpty())
+	{
+		if (!HeadView.FindChar(TEXT('\r'), LineEnd))
+		{
+			LineEnd = HeadView.Len();
+		}
+
+		const FStringView Line = HeadView.Left(LineEnd);
+		HeadView.RightChopInline(LineEnd + 2);
+
+		int32 Colon = INDEX_NONE;
+		if (!Line.FindChar(TEXT(':'), Colon))
+		{
+			return -1;
+		}
+
+		const FString Name = FString(Line.Left(Colon).TrimStartAndEnd()).ToLower();
+		const FString Value = FString(Line.Mid(Colon + 1).TrimStartAndEnd());
+
+		if (Name == TEXT("content-length"))
+		{
+			// Repeated headers must agree, otherwise the body boundary is ambiguous
+			int64 Length = 0;
+			if (!ParseContentLength(Value, Length) || (OutRequest.Headers.Contains(Name) && Length != ContentLength))
+			{
+				return -1;
+			}
+
+			ContentLength = Length;
+		}
+		else if (Name == TEXT("transfer-encoding"))
+		{
+			// Chunked request bodies are not supported here
+			return -1;
+		}
+
+		OutRequest.Headers.FindOrAdd(Name).Add(Value);
+	}
+
+	// Compare before adding so a huge length can not overflow the total
+	if (ContentLength < 0 || ContentLength > MaxRequestSize - (HeaderEnd + 4))
+	{
+		return -1;
+	}
+
+	const int32 RequestSize = HeaderEnd + 4 + (int32)ContentLength;
+
+	if (Data.Num() < RequestSize)
+	{
+		return 0;
+	}
+
+	OutRequest.Body.Append(Data.GetData() + HeaderEnd + 4, (int32)ContentLength);
+	return RequestSize;
+}
+
+TArray<uint8> FHttpStreamServer::MakeResponseHead(int32 Code, const TMap<FString, TArray<FString>>& Headers)
+{
+	TStringBuilder<512> Head;
+	Head.Appendf(TEXT("HTTP/1.1 %d %s\r\n"), Code, GetReasonPhrase(Code));
+
+	for (const TPair<FString, TArray<FString>>& Header : Headers)
+	{
+		Head << Header.Key << TEXT(": ") << FString::Join(Header.Value, TEXT(", ")) << TEXT("\r\n");
+	}
+	Head << TEXT("\r\n");
+
+	TArray<uint8> Bytes;
+	FHttpResponseBuilder::AppendUtf8(Bytes, Head.ToView());
+	return Bytes;
+}
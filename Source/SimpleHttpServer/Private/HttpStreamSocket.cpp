@@ -0,0 +1,290 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpStreamSocket.h"
+#include "SimpleHttpServer.h"
+#include "SocketSubsystem.h"
+#include "Interfaces/IPv4/IPv4Address.h"
+
+#if PLATFORM_HAS_BSD_SOCKETS
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <winsock2.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+#endif
+
+#if PLATFORM_HAS_BSD_SOCKETS
+namespace
+{
+#if PLATFORM_WINDOWS
+	typedef SOCKET FNativeSocket;
+	typedef WSAPOLLFD FPollEntry;
+	typedef int FSocketAddressLength;
+
+	const FNativeSocket InvalidNativeSocket = INVALID_SOCKET;
+	const int SendFlags = 0;
+
+	void CloseNative(FNativeSocket Socket)
+	{
+		closesocket(Socket);
+	}
+
+	bool SetNonBlocking(FNativeSocket Socket)
+	{
+		u_long Value = 1;
+		return ioctlsocket(Socket, FIONBIO, &Value) == 0;
+	}
+
+	int32 GetLastNativeError()
+	{
+		return WSAGetLastError();
+	}
+
+	bool IsWouldBlock()
+	{
+		return WSAGetLastError() == WSAEWOULDBLOCK;
+	}
+
+	int32 PollNative(FPollEntry* Entries, int32 Num, int32 TimeoutMs)
+	{
+		return WSAPoll(Entries, (ULONG)Num, TimeoutMs);
+	}
+#else
+	typedef int FNativeSocket;
+	typedef pollfd FPollEntry;
+	typedef socklen_t FSocketAddressLength;
+
+	const FNativeSocket InvalidNativeSocket = -1;
+
+	// Peer that went away must not raise SIGPIPE
+#if defined(MSG_NOSIGNAL)
+	const int SendFlags = MSG_NOSIGNAL;
+#else
+	const int SendFlags = 0;
+#endif
+
+	void CloseNative(FNativeSocket Socket)
+	{
+		close(Socket);
+	}
+
+	bool SetNonBlocking(FNativeSocket Socket)
+	{
+		const int Flags = fcntl(Socket, F_GETFL, 0);
+		return Flags != -1 && fcntl(Socket, F_SETFL, Flags | O_NONBLOCK) != -1;
+	}
+
+	int32 GetLastNativeError()
+	{
+		return errno;
+	}
+
+	// Interrupted calls are retried on the next pass like blocked ones
+	bool IsWouldBlock()
+	{
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+	}
+
+	int32 PollNative(FPollEntry* Entries, int32 Num, int32 TimeoutMs)
+	{
+		return poll(Entries, (nfds_t)Num, TimeoutMs);
+	}
+#endif
+
+	sockaddr_in MakeAddress(uint32 HostOrderAddress, int32 Port)
+	{
+		sockaddr_in Address;
+		FMemory::Memzero(Address);
+		Address.sin_family = AF_INET;
+		Address.sin_addr.s_addr = htonl(HostOrderAddress);
+		Address.sin_port = htons((uint16)Port);
+		return Address;
+	}
+
+	void SetOption(FNativeSocket Socket, int Level, int Option, int Value)
+	{
+		setsockopt(Socket, Level, Option, reinterpret_cast<const char*>(&Value), sizeof(Value));
+	}
+
+	FNativeSocket CreateNative(int Type, int Protocol)
+	{
+		// Winsock has to be started before any call, the engine socket subsystem starts it when it initializes
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+		return socket(AF_INET, Type, Protocol);
+	}
+}
+
+FHttpStreamSocket::FHttpStreamSocket(UPTRINT InHandle)
+	: Handle(InHandle)
+{
+}
+
+FHttpStreamSocket::~FHttpStreamSocket()
+{
+	CloseNative((FNativeSocket)Handle);
+}
+
+TUniquePtr<FHttpStreamSocket> FHttpStreamSocket::Listen(const FIPv4Address& Address, int32 Port)
+{
+	const FNativeSocket Native = CreateNative(SOCK_STREAM, IPPROTO_TCP);
+	if (Native == InvalidNativeSocket)
+	{
+		UE_LOG(LogSimpleHttpServer, Warning, TEXT("Could not create stream server socket, error %d"), GetLastNativeError());
+		return nullptr;
+	}
+
+	TUniquePtr<FHttpStreamSocket> Socket(new FHttpStreamSocket((UPTRINT)Native));
+
+	const sockaddr_in BindAddress = MakeAddress(Address.Value, Port);
+	if (bind(Native, reinterpret_cast<const sockaddr*>(&BindAddress), sizeof(BindAddress)) != 0
+		|| listen(Native, SOMAXCONN) != 0
+		|| !SetNonBlocking(Native))
+	{
+		UE_LOG(LogSimpleHttpServer, Warning, TEXT("Could not listen on %s:%d, error %d"), *Address.ToString(), Port, GetLastNativeError());
+		return nullptr;
+	}
+
+	return Socket;
+}
+
+TUniquePtr<FHttpStreamSocket> FHttpStreamSocket::CreateLoopbackDatagram()
+{
+	const FNativeSocket Native = CreateNative(SOCK_DGRAM, IPPROTO_UDP);
+	if (Native == InvalidNativeSocket)
+	{
+		return nullptr;
+	}
+
+	TUniquePtr<FHttpStreamSocket> Socket(new FHttpStreamSocket((UPTRINT)Native));
+
+	sockaddr_in Address = MakeAddress(INADDR_LOOPBACK, 0);
+	FSocketAddressLength AddressLength = sizeof(Address);
+	if (bind(Native, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0
+		|| getsockname(Native, reinterpret_cast<sockaddr*>(&Address), &AddressLength) != 0
+		|| connect(Native, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0
+		|| !SetNonBlocking(Native))
+	{
+		return nullptr;
+	}
+
+	return Socket;
+}
+
+TUniquePtr<FHttpStreamSocket> FHttpStreamSocket::Accept()
+{
+	const FNativeSocket Native = accept((FNativeSocket)Handle, nullptr, nullptr);
+	if (Native == InvalidNativeSocket)
+	{
+		return nullptr;
+	}
+
+	TUniquePtr<FHttpStreamSocket> Socket(new FHttpStreamSocket((UPTRINT)Native));
+	if (!SetNonBlocking(Native))
+	{
+		return nullptr;
+	}
+
+	SetOption(Native, IPPROTO_TCP, TCP_NODELAY, 1);
+#if defined(SO_NOSIGPIPE)
+	SetOption(Native, SOL_SOCKET, SO_NOSIGPIPE, 1);
+#endif
+
+	return Socket;
+}
+
+bool FHttpStreamSocket::Recv(uint8* Data, int32 Size, int32& OutBytesRead)
+{
+	const int32 Result = (int32)recv((FNativeSocket)Handle, reinterpret_cast<char*>(Data), Size, 0);
+	if (Result > 0)
+	{
+		OutBytesRead = Result;
+		return true;
+	}
+
+	// Zero is an orderly shutdown by peer
+	OutBytesRead = 0;
+	return Result < 0 && IsWouldBlock();
+}
+
+bool FHttpStreamSocket::Send(const uint8* Data, int32 Size, int32& OutBytesSent)
+{
+	const int32 Result = (int32)send((FNativeSocket)Handle, reinterpret_cast<const char*>(Data), Size, SendFlags);
+	if (Result >= 0)
+	{
+		OutBytesSent = Result;
+		return true;
+	}
+
+	OutBytesSent = 0;
+	return IsWouldBlock();
+}
+
+void FHttpStreamSocket::Wait(TArrayView<const FWaitEntry> Entries, int32 TimeoutMs)
+{
+	TArray<FPollEntry, TInlineAllocator<64>> PollEntries;
+	PollEntries.Reserve(Entries.Num());
+
+	for (const FWaitEntry& Entry : Entries)
+	{
+		FPollEntry& PollEntry = PollEntries.AddZeroed_GetRef();
+		PollEntry.fd = (FNativeSocket)Entry.Socket->Handle;
+		PollEntry.events = Entry.bWantWrite ? (POLLIN | POLLOUT) : POLLIN;
+	}
+
+	PollNative(PollEntries.GetData(), PollEntries.Num(), TimeoutMs);
+}
+
+#else
+
+FHttpStreamSocket::FHttpStreamSocket(UPTRINT InHandle)
+	: Handle(InHandle)
+{
+}
+
+FHttpStreamSocket::~FHttpStreamSocket()
+{
+}
+
+TUniquePtr<FHttpStreamSocket> FHttpStreamSocket::Listen(const FIPv4Address& Address, int32 Port)
+{
+	UE_LOG(LogSimpleHttpServer, Warning, TEXT("Stream server needs BSD sockets, which this platform doesn't have"));
+	return nullptr;
+}
+
+TUniquePtr<FHttpStreamSocket> FHttpStreamSocket::CreateLoopbackDatagram()
+{
+	return nullptr;
+}
+
+TUniquePtr<FHttpStreamSocket> FHttpStreamSocket::Accept()
+{
+	return nullptr;
+}
+
+bool FHttpStreamSocket::Recv(uint8* Data, int32 Size, int32& OutBytesRead)
+{
+	OutBytesRead = 0;
+	return false;
+}
+
+bool FHttpStreamSocket::Send(const uint8* Data, int32 Size, int32& OutBytesSent)
+{
+	OutBytesSent = 0;
+	return false;
+}
+
+void FHttpStreamSocket::Wait(TArrayView<const FWaitEntry> Entries, int32 TimeoutMs)
+{
+	FPlatformProcess::Sleep(TimeoutMs / 1000.0f);
+}
+
+#endif
@@ -0,0 +1,52 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FIPv4Address;
+
+/**
+ * Non-blocking IPv4 socket created and owned by the stream server.
+ * Engine sockets don't expose their native handles, and the stream server thread has to wait for all its sockets at once,
+ * so it keeps its own and waits for them with the platform poll.
+ * Only available on platforms with BSD sockets, elsewhere sockets can't be created and the stream server doesn't start.
+ */
+class FHttpStreamSocket
+{
+public:
+	~FHttpStreamSocket();
+
+	FHttpStreamSocket(const FHttpStreamSocket&) = delete;
+	FHttpStreamSocket& operator=(const FHttpStreamSocket&) = delete;
+
+	// TCP socket listening on the address. Null on failure, with the error logged.
+	static TUniquePtr<FHttpStreamSocket> Listen(const FIPv4Address& Address, int32 Port);
+
+	// Datagram socket on loopback that is connected to itself, so what it sends it receives
+	static TUniquePtr<FHttpStreamSocket> CreateLoopbackDatagram();
+
+	// Next pending connection of a listening socket, null when there is none
+	TUniquePtr<FHttpStreamSocket> Accept();
+
+	// Returns true with zero bytes when nothing is available, false when peer is gone or on error
+	bool Recv(uint8* Data, int32 Size, int32& OutBytesRead);
+
+	// Returns true with zero bytes when socket buffer is full, false on error
+	bool Send(const uint8* Data, int32 Size, int32& OutBytesSent);
+
+	struct FWaitEntry
+	{
+		FHttpStreamSocket* Socket = nullptr;
+		bool bWantWrite = false;
+	};
+
+	// Block until one of the sockets is readable (or writable when asked) or the timeout passes
+	static void Wait(TArrayView<const FWaitEntry> Entries, int32 TimeoutMs);
+
+private:
+	explicit FHttpStreamSocket(UPTRINT InHandle);
+
+	// Native handle, SOCKET on Windows and file descriptor elsewhere
+	UPTRINT Handle;
+};
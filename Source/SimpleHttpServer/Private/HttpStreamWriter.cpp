@@ -0,0 +1,230 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpStreamWriter.h"
+#include "SimpleHttpServer.h"
+#include "HttpStreamServer.h"
+#include "HttpResponseBuilder.h"
+
+namespace
+{
+	const TSharedRef<const TArray<uint8>>& GetChunkTerminator()
+	{
+		static const TSharedRef<const TArray<uint8>> Terminator = MakeShared<const TArray<uint8>>(TArray<uint8>({ '\r', '\n' }));
+		return Terminator;
+	}
+
+	const TSharedRef<const TArray<uint8>>& GetLastChunk()
+	{
+		static const TSharedRef<const TArray<uint8>> LastChunk = MakeShared<const TArray<uint8>>(TArray<uint8>({ '0', '\r', '\n', '\r', '\n' }));
+		return LastChunk;
+	}
+
+	void AppendChunkSize(TArray<uint8>& Buffer, int32 Size)
+	{
+		ANSICHAR SizeLine[16];
+		const int32 Len = FCStringAnsi::Snprintf(SizeLine, UE_ARRAY_COUNT(SizeLine), "%x\r\n", Size);
+		Buffer.Append(reinterpret_cast<const uint8*>(SizeLine), Len);
+	}
+}
+
+FHttpStreamWriter::FHttpStreamWriter(const TSharedRef<FHttpStreamConnection>& Connection)
+	: State(MakeShared<FState, ESPMode::ThreadSafe>())
+{
+	State->Connection = Connection;
+}
+
+FHttpStreamWriter::FState::~FState()
+{
+	TSharedPtr<FHttpStreamConnection> PinnedConnection = Connection.Pin();
+	if (!PinnedConnection.IsValid() || bFinished)
+	{
+		return;
+	}
+
+	if (!bResponseStarted)
+	{
+		// Nobody answered this request. Don't let the connection hang until the client timeout.
+		UE_LOG(LogSimpleHttpServer, Warning, TEXT("Stream route handler released request without writing response. Sending 500."));
+
+		TMap<FString, TArray<FString>> Headers;
+		Headers.Add(TEXT("content-length"), { TEXT("0") });
+		Headers.Add(TEXT("connection"), { TEXT("close") });
+		PinnedConnection->Send(FHttpStreamServer::MakeResponseHead((int32)EHttpServerResponseCodes::ServerError, Headers));
+	}
+	else
+	{
+		PinnedConnection->Send(GetLastChunk());
+	}
+
+	PinnedConnection->Close();
+}
+
+bool FHttpStreamWriter::BeginResponse(EHttpServerResponseCodes Code, const FString& ContentType, TMap<FString, TArray<FString>> Headers)
+{
+	if (!State.IsValid())
+	{
+		return false;
+	}
+
+	TSharedPtr<FHttpStreamConnection> Connection = State->Connection.Pin();
+	if (!Connection.IsValid())
+	{
+		return false;
+	}
+
+	FScopeLock ScopeLock(&State->Lock);
+
+	if (State->bResponseStarted)
+	{
+		UE_LOG(LogSimpleHttpServer, Warning, TEXT("Stream response was already started. Headers ignored."));
+		return false;
+	}
+
+	return BeginResponseLocked(*State, Connection.ToSharedRef(), Code, ContentType, MoveTemp(Headers));
+}
+
+bool FHttpStreamWriter::BeginResponseLocked(FState& InState, const TSharedRef<FHttpStreamConnection>& Connection, EHttpServerResponseCodes Code, const FString& ContentType, TMap<FString, TArray<FString>>&& Headers)
+{
+	InState.bResponseStarted = true;
+
+	Headers.Add(TEXT("content-type"), { ContentType });
+	Headers.Add(TEXT("transfer-encoding"), { TEXT("chunked") });
+	Headers.Add(TEXT("connection"), { TEXT("close") });
+
+	return Connection->Send(FHttpStreamServer::MakeResponseHead((int32)Code, Headers));
+}
+
+bool FHttpStreamWriter::Write(TArrayView<const uint8> Bytes)
+{
+	if (Bytes.Num() == 0)
+	{
+		return IsOpen();
+	}
+
+	// Size line, data and terminator in one buffer, small writes stay one queue entry
+	TArray<uint8> Chunk;
+	Chunk.Reserve(Bytes.Num() + 12);
+	AppendChunkSize(Chunk, Bytes.Num());
+	Chunk.Append(Bytes.GetData(), Bytes.Num());
+	Chunk.Append(GetChunkTerminator().Get());
+
+	const TSharedRef<const TArray<uint8>> Buffers[] = { MakeShared<const TArray<uint8>>(MoveTemp(Chunk)) };
+	return SendChunk(Buffers);
+}
+
+bool FHttpStreamWriter::Write(FUtf8StringView Text)
+{
+	return Write(TArrayView<const uint8>(reinterpret_cast<const uint8*>(Text.GetData()), Text.Len()));
+}
+
+bool FHttpStreamWriter::Write(FStringView Text)
+{
+	TArray<uint8> Bytes;
+	FHttpResponseBuilder::AppendUtf8(Bytes, Text);
+	return Write(TArrayView<const uint8>(Bytes));
+}
+
+bool FHttpStreamWriter::Write(const TSharedRef<const TArray<uint8>>& Buffer)
+{
+	if (Buffer->Num() == 0)
+	{
+		return IsOpen();
+	}
+
+	TArray<uint8> SizeLine;
+	AppendChunkSize(SizeLine, Buffer->Num());
+
+	const TSharedRef<const TArray<uint8>> Buffers[] = { MakeShared<const TArray<uint8>>(MoveTemp(SizeLine)), Buffer, GetChunkTerminator() };
+	return SendChunk(Buffers);
+}
+
+bool FHttpStreamWriter::SendChunk(TArrayView<const TSharedRef<const TArray<uint8>>> Buffers) const
+{
+	if (!State.IsValid())
+	{
+		return false;
+	}
+
+	TSharedPtr<FHttpStreamConnection> Connection = State->Connection.Pin();
+	if (!Connection.IsValid())
+	{
+		return false;
+	}
+
+	FScopeLock ScopeLock(&State->Lock);
+
+	if (State->bFinished)
+	{
+		return false;
+	}
+
+	if (!State->bResponseStarted && !BeginResponseLocked(*State, Connection.ToSharedRef(), EHttpServerResponseCodes::Ok, TEXT("application/octet-stream"), TMap<FString, TArray<FString>>()))
+	{
+		return false;
+	}
+
+	return Connection->Send(Buffers);
+}
+
+void FHttpStreamWriter::Finish()
+{
+	if (!State.IsValid())
+	{
+		return;
+	}
+
+	TSharedPtr<FHttpStreamConnection> Connection = State->Connection.Pin();
+	if (!Connection.IsValid())
+	{
+		return;
+	}
+
+	FScopeLock ScopeLock(&State->Lock);
+
+	if (State->bFinished)
+	{
+		return;
+	}
+
+	if (!State->bResponseStarted)
+	{
+		BeginResponseLocked(*State, Connection.ToSharedRef(), EHttpServerResponseCodes::Ok, TEXT("application/octet-stream"), TMap<FString, TArray<FString>>());
+	}
+
+	State->bFinished = true;
+	Connection->Send(GetLastChunk());
+	Connection->Close();
+}
+
+void FHttpStreamWriter::Abort()
+{
+	if (!State.IsValid())
+	{
+		return;
+	}
+
+	FScopeLock ScopeLock(&State->Lock);
+	State->bFinished = true;
+
+	if (TSharedPtr<FHttpStreamConnection> Connection = State->Connection.Pin())
+	{
+		Connection->Abort();
+	}
+}
+
+bool FHttpStreamWriter::IsOpen() const
+{
+	if (!State.IsValid() || State->bFinished)
+	{
+		return false;
+	}
+
+	TSharedPtr<FHttpStreamConnection> Connection = State->Connection.Pin();
+	return Connection.IsValid() && Connection->IsOpen();
+}
+
+int64 FHttpStreamWriter::GetQueuedBytes() const
+{
+	TSharedPtr<FHttpStreamConnection> Connection = State.IsValid() ? State->Connection.Pin() : nullptr;
+	return Connection.IsValid() ? Connection->GetQueuedBytes() : 0;
+}
@@ -0,0 +1,1293 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpStructSerializer.h"
+#include "HttpJsonSerializer.h"
+#include "HttpSerializationPlan.h"
+#include "UObject/TextProperty.h"
+#include "UObject/EnumProperty.h"
+#include "UObject/SoftObjectPtr.h"
+#include "String/Find.h"
+#include <limits>
+
+namespace
+{
+	float ParseQuality(FStringView Params)
+	{
+		// "q=0.5", quality is 1 when not set
+		const int32 QPos = UE::String::FindFirst(Params, TEXT("q="), ESearchCase::IgnoreCase);
+		if (QPos == INDEX_NONE)
+		{
+			return 1.0f;
+		}
+
+		return FCString::Atof(*FString(Params.RightChop(QPos + 2)));
+	}
+
+	// False for media types of other formats
+	bool ParseMediaType(FStringView MediaType, EHttpWireFormat& OutFormat)
+	{
+		if (MediaType.Equals(TEXT("application/msgpack"), ESearchCase::IgnoreCase)
+			|| MediaType.Equals(TEXT("application/x-msgpack"), ESearchCase::IgnoreCase)
+			|| MediaType.Equals(TEXT("application/vnd.msgpack"), ESearchCase::IgnoreCase))
+		{
+			OutFormat = EHttpWireFormat::MessagePack;
+			return true;
+		}
+
+		if (MediaType.Equals(TEXT("application/cbor"), ESearchCase::IgnoreCase))
+		{
+			OutFormat = EHttpWireFormat::Cbor;
+			return true;
+		}
+
+		if (MediaType.Equals(TEXT("application/json"), ESearchCase::IgnoreCase)
+			|| MediaType.Equals(TEXT("application/*"), ESearchCase::IgnoreCase)
+			|| MediaType.Equals(TEXT("*/*"), ESearchCase::IgnoreCase))
+		{
+			OutFormat = EHttpWireFormat::Json;
+			return true;
+		}
+
+		return false;
+	}
+
+	// Scalars and heads of MessagePack
+	struct FMessagePackEncoder
+	{
+		static void WriteNil(TArray<uint8>& Out) { Out.Add(0xc0); }
+		static void WriteBool(TArray<uint8>& Out, bool bValue) { Out.Add(bValue ? 0xc3 : 0xc2); }
+		static void WriteInt(TArray<uint8>& Out, int64 Value) { FHttpMessagePack::WriteInt(Out, Value); }
+		static void WriteUInt(TArray<uint8>& Out, uint64 Value) { FHttpMessagePack::WriteUInt(Out, Value); }
+
+		static void WriteFloat(TArray<uint8>& Out, float Value)
+		{
+			uint32 Bits = 0;
+			FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+			Out.Add(0xca);
+			AppendBigEndian(Out, Bits, 4);
+		}
+
+		static void WriteDouble(TArray<uint8>& Out, double Value)
+		{
+			uint64 Bits = 0;
+			FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+			Out.Add(0xcb);
+			AppendBigEndian(Out, Bits, 8);
+		}
+
+		static void WriteStringHead(TArray<uint8>& Out, uint32 Len) { FHttpMessagePack::WriteStringHead(Out, Len); }
+		static void WriteBytesHead(TArray<uint8>& Out, uint32 Len) { FHttpMessagePack::WriteBinaryHead(Out, Len); }
+		static void WriteArrayHead(TArray<uint8>& Out, uint32 Num) { FHttpMessagePack::WriteArrayHead(Out, Num); }
+		static void WriteMapHead(TArray<uint8>& Out, uint32 Num) { FHttpMessagePack::WriteMapHead(Out, Num); }
+
+		static const TArray<uint8>& GetFieldName(const FHttpFieldPlan& Field) { return Field.MessagePackName; }
+	};
+
+	// Scalars and heads of CBOR
+	struct FCborEncoder
+	{
+		static void WriteNil(TArray<uint8>& Out) { Out.Add(0xf6); }
+		static void WriteBool(TArray<uint8>& Out, bool bValue) { Out.Add(bValue ? 0xf5 : 0xf4); }
+		static void WriteInt(TArray<uint8>& Out, int64 Value) { FHttpCbor::WriteInt(Out, Value); }
+		static void WriteUInt(TArray<uint8>& Out, uint64 Value) { FHttpCbor::WriteHead(Out, FHttpCbor::MajorUInt, Value); }
+
+		static void WriteFloat(TArray<uint8>& Out, float Value)
+		{
+			uint32 Bits = 0;
+			FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+			Out.Add(0xfa);
+			AppendBigEndian(Out, Bits, 4);
+		}
+
+		static void WriteDouble(TArray<uint8>& Out, double Value)
+		{
+			uint64 Bits = 0;
+			FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+			Out.Add(0xfb);
+			AppendBigEndian(Out, Bits, 8);
+		}
+
+		static void WriteStringHead(TArray<uint8>& Out, uint32 Len) { FHttpCbor::WriteHead(Out, FHttpCbor::MajorText, Len); }
+		static void WriteBytesHead(TArray<uint8>& Out, uint32 Len) { FHttpCbor::WriteHead(Out, FHttpCbor::MajorBytes, Len); }
+		static void WriteArrayHead(TArray<uint8>& Out, uint32 Num) { FHttpCbor::WriteHead(Out, FHttpCbor::MajorArray, Num); }
+		static void WriteMapHead(TArray<uint8>& Out, uint32 Num) { FHttpCbor::WriteHead(Out, FHttpCbor::MajorMap, Num); }
+
+		static const TArray<uint8>& GetFieldName(const FHttpFieldPlan& Field) { return Field.CborName; }
+	};
+
+	// Walk over plans shared by binary formats, which differ only in how items are encoded
+	template<typename EncoderType>
+	class TBinaryPlanWriter
+	{
+	public:
+		explicit TBinaryPlanWriter(TArray<uint8>& InOut)
+			: Out(InOut)
+		{
+		}
+
+		void WriteStruct(const FHttpStructPlan& Plan, const void* Data)
+		{
+			EncoderType::WriteMapHead(Out, Plan.Fields.Num());
+
+			for (const FHttpFieldPlan& Field : Plan.Fields)
+			{
+				const FProperty* Property = Field.Value.Property;
+				Out.Append(EncoderType::GetFieldName(Field));
+
+				// Static arrays are written as arrays
+				if (Property->ArrayDim > 1)
+				{
+					EncoderType::WriteArrayHead(Out, Property->ArrayDim);
+					for (int32 Index = 0; Index < Property->ArrayDim; ++Index)
+					{
+						WriteValue(Field.Value, Property->ContainerPtrToValuePtr<void>(Data, Index));
+					}
+				}
+				else
+				{
+					WriteValue(Field.Value, Property->ContainerPtrToValuePtr<void>(Data));
+				}
+			}
+		}
+
+		void WriteValue(const FHttpValuePlan& Plan, const void* Value)
+		{
+			switch (Plan.Kind)
+			{
+			case EHttpValueKind::Bool:
+				EncoderType::WriteBool(Out, static_cast<const FBoolProperty*>(Plan.Property)->GetPropertyValue(Value));
+				break;
+
+			case EHttpValueKind::SignedInt:
+				EncoderType::WriteInt(Out, static_cast<const FNumericProperty*>(Plan.Property)->GetSignedIntPropertyValue(Value));
+				break;
+
+			case EHttpValueKind::UnsignedInt:
+				EncoderType::WriteUInt(Out, static_cast<const FNumericProperty*>(Plan.Property)->GetUnsignedIntPropertyValue(Value));
+				break;
+
+			case EHttpValueKind::Float:
+				EncoderType::WriteFloat(Out, *static_cast<const float*>(Value));
+				break;
+
+			case EHttpValueKind::Double:
+				EncoderType::WriteDouble(Out, *static_cast<const double*>(Value));
+				break;
+
+			case EHttpValueKind::Enum:
+			{
+				const FEnumProperty* EnumProperty = static_cast<const FEnumProperty*>(Plan.Property);
+				WriteString(EnumProperty->GetEnum()->GetNameStringByValue(EnumProperty->GetUnderlyingProperty()->GetSignedIntPropertyValue(Value)));
+				break;
+			}
+
+			case EHttpValueKind::ByteEnum:
+				WriteString(static_cast<const FByteProperty*>(Plan.Property)->GetIntPropertyEnum()->GetNameStringByValue(*static_cast<const uint8*>(Value)));
+				break;
+
+			case EHttpValueKind::String:
+				WriteString(*static_cast<const FString*>(Value));
+				break;
+
+			case EHttpValueKind::Name:
+				WriteString(static_cast<const FName*>(Value)->ToString());
+				break;
+
+			case EHttpValueKind::Text:
+				WriteString(static_cast<const FText*>(Value)->ToString());
+				break;
+
+			case EHttpValueKind::Struct:
+				WriteStruct(*Plan.StructPlan, Value);
+				break;
+
+			case EHttpValueKind::Array:
+			{
+				FScriptArrayHelper Helper(static_cast<const FArrayProperty*>(Plan.Property), Value);
+				if (Plan.bBytes)
+				{
+					EncoderType::WriteBytesHead(Out, Helper.Num());
+					if (Helper.Num() > 0)
+					{
+						Out.Append(Helper.GetRawPtr(0), Helper.Num());
+					}
+					break;
+				}
+
+				EncoderType::WriteArrayHead(Out, Helper.Num());
+				for (int32 Index = 0; Index < Helper.Num(); ++Index)
+				{
+					WriteValue(*Plan.Inner, Helper.GetRawPtr(Index));
+				}
+				break;
+			}
+
+			case EHttpValueKind::Set:
+			{
+				FScriptSetHelper Helper(static_cast<const FSetProperty*>(Plan.Property), Value);
+				EncoderType::WriteArrayHead(Out, Helper.Num());
+				for (int32 Index = 0; Index < Helper.GetMaxIndex(); ++Index)
+				{
+					if (Helper.IsValidIndex(Index))
+					{
+						WriteValue(*Plan.Inner, Helper.GetElementPtr(Index));
+					}
+				}
+				break;
+			}
+
+			case EHttpValueKind::Map:
+			{
+				FScriptMapHelper Helper(static_cast<const FMapProperty*>(Plan.Property), Value);
+				EncoderType::WriteMapHead(Out, Helper.Num());
+				for (int32 Index = 0; Index < Helper.GetMaxIndex(); ++Index)
+				{
+					if (!Helper.IsValidIndex(Index))
+					{
+						continue;
+					}
+
+					// Keys of any scalar type are native in binary formats, structs and others are exported text
+					if (Plan.Key->Kind == EHttpValueKind::Struct || Plan.Key->Kind == EHttpValueKind::Other)
+					{
+						WriteExportedText(Plan.Key->Property, Helper.GetKeyPtr(Index));
+					}
+					else
+					{
+						WriteValue(*Plan.Key, Helper.GetKeyPtr(Index));
+					}
+
+					WriteValue(*Plan.Inner, Helper.GetValuePtr(Index));
+				}
+				break;
+			}
+
+			case EHttpValueKind::Object:
+			{
+				// Referenced objects are written as paths, not expanded
+				const UObject* Object = static_cast<const FObjectPropertyBase*>(Plan.Property)->GetObjectPropertyValue(Value);
+				if (Object)
+				{
+					WriteString(Object->GetPathName());
+				}
+				else
+				{
+					EncoderType::WriteNil(Out);
+				}
+				break;
+			}
+
+			case EHttpValueKind::SoftObject:
+				WriteString(static_cast<const FSoftObjectPtr*>(Value)->ToSoftObjectPath().ToString());
+				break;
+
+			default:
+				WriteExportedText(Plan.Property, Value);
+				break;
+			}
+		}
+
+	private:
+		void WriteString(FStringView Value)
+		{
+			FTCHARToUTF8 Utf8(Value.GetData(), Value.Len());
+			EncoderType::WriteStringHead(Out, Utf8.Length());
+			Out.Append(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+		}
+
+		void WriteExportedText(const FProperty* Property, const void* Value)
+		{
+			FString Text;
+			Property->ExportText_Direct(Text, Value, nullptr, nullptr, PPF_None);
+			WriteString(Text);
+		}
+
+		TArray<uint8>& Out;
+	};
+
+	// Decoded head of a binary item. Strings and bytes point into the document.
+	struct FBinaryItem
+	{
+		enum EType : uint8
+		{
+			Nil,
+			Bool,
+			Int,
+			UInt,
+			Float,
+			String,
+			Bytes,
+			Array,
+			Map
+		};
+
+		EType Type = Nil;
+		bool bBoolValue = false;
+		int64 IntValue = 0;
+		uint64 UIntValue = 0;
+		double FloatValue = 0.0;
+
+		// Payload of strings and bytes
+		const uint8* Data = nullptr;
+
+		// Bytes of strings, elements of arrays, pairs of maps
+		uint64 Length = 0;
+	};
+
+	// Bounds-checked cursor over a binary document
+	class FBinaryCursor
+	{
+	public:
+		explicit FBinaryCursor(TArrayView<const uint8> Bytes)
+			: Begin(Bytes.GetData())
+			, Cur(Bytes.GetData())
+			, End(Bytes.GetData() + Bytes.Num())
+		{
+		}
+
+		FString Error;
+
+	protected:
+		bool Fail(const TCHAR* Message)
+		{
+			if (Error.IsEmpty())
+			{
+				Error = FString::Printf(TEXT("%s at offset %d"), Message, (int32)(Cur - Begin));
+			}
+			return false;
+		}
+
+		bool ReadBigEndian(int32 NumBytes, uint64& OutValue)
+		{
+			if (End - Cur < NumBytes)
+			{
+				return Fail(TEXT("Unexpected end of data"));
+			}
+
+			OutValue = 0;
+			for (int32 Index = 0; Index < NumBytes; ++Index)
+			{
+				OutValue = (OutValue << 8) | *Cur++;
+			}
+			return true;
+		}
+
+		// Point item at Length bytes of payload and step over them
+		bool ReadPayload(FBinaryItem& Item)
+		{
+			if ((uint64)(End - Cur) < Item.Length)
+			{
+				return Fail(TEXT("Unexpected end of data"));
+			}
+
+			Item.Data = Cur;
+			Cur += Item.Length;
+			return true;
+		}
+
+		static double FloatFromBits(uint32 Bits)
+		{
+			float Value = 0.0f;
+			FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+			return Value;
+		}
+
+		static double DoubleFromBits(uint64 Bits)
+		{
+			double Value = 0.0;
+			FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+			return Value;
+		}
+
+		const uint8* Begin;
+		const uint8* Cur;
+		const uint8* End;
+	};
+
+	class FMessagePackDecoder : public FBinaryCursor
+	{
+	public:
+		using FBinaryCursor::FBinaryCursor;
+
+	protected:
+		bool ReadItem(FBinaryItem& Item)
+		{
+			if (Cur >= End)
+			{
+				return Fail(TEXT("Unexpected end of data"));
+			}
+
+			Item = FBinaryItem();
+			const uint8 Head = *Cur++;
+
+			// Values packed into the head byte
+			if (Head <= 0x7f)
+			{
+				Item.Type = FBinaryItem::UInt;
+				Item.UIntValue = Head;
+				return true;
+			}
+			if (Head >= 0xe0)
+			{
+				Item.Type = FBinaryItem::Int;
+				Item.IntValue = (int8)Head;
+				return true;
+			}
+			if (Head <= 0x8f)
+			{
+				Item.Type = FBinaryItem::Map;
+				Item.Length = Head & 0x0f;
+				return true;
+			}
+			if (Head <= 0x9f)
+			{
+				Item.Type = FBinaryItem::Array;
+				Item.Length = Head & 0x0f;
+				return true;
+			}
+			if (Head <= 0xbf)
+			{
+				Item.Type = FBinaryItem::String;
+				Item.Length = Head & 0x1f;
+				return ReadPayload(Item);
+			}
+
+			uint64 Value = 0;
+			switch (Head)
+			{
+			case 0xc0:
+				Item.Type = FBinaryItem::Nil;
+				return true;
+
+			case 0xc2:
+			case 0xc3:
+				Item.Type = FBinaryItem::Bool;
+				Item.bBoolValue = Head == 0xc3;
+				return true;
+
+			case 0xc4:
+			case 0xc5:
+			case 0xc6:
+				Item.Type = FBinaryItem::Bytes;
+				return ReadBigEndian(1 << (Head - 0xc4), Item.Length) && ReadPayload(Item);
+
+			case 0xca:
+				Item.Type = FBinaryItem::Float;
+				if (!ReadBigEndian(4, Value))
+				{
+					return false;
+				}
+				Item.FloatValue = FloatFromBits((uint32)Value);
+				return true;
+
+			case 0xcb:
+				Item.Type = FBinaryItem::Float;
+				if (!ReadBigEndian(8, Value))
+				{
+					return false;
+				}
+				Item.FloatValue = DoubleFromBits(Value);
+				return true;
+
+			case 0xcc:
+			case 0xcd:
+			case 0xce:
+			case 0xcf:
+				Item.Type = FBinaryItem::UInt;
+				return ReadBigEndian(1 << (Head - 0xcc), Item.UIntValue);
+
+			case 0xd0:
+			case 0xd1:
+			case 0xd2:
+			case 0xd3:
+			{
+				const int32 NumBytes = 1 << (Head - 0xd0);
+				if (!ReadBigEndian(NumBytes, Value))
+				{
+					return false;
+				}
+
+				// Sign-extend from the stored width
+				const int32 Shift = 64 - NumBytes * 8;
+				Item.Type = FBinaryItem::Int;
+				Item.IntValue = (int64)(Value << Shift) >> Shift;
+				return true;
+			}
+
+			case 0xd9:
+			case 0xda:
+			case 0xdb:
+				Item.Type = FBinaryItem::String;
+				return ReadBigEndian(1 << (Head - 0xd9), Item.Length) && ReadPayload(Item);
+
+			case 0xdc:
+			case 0xdd:
+				Item.Type = FBinaryItem::Array;
+				return ReadBigEndian(Head == 0xdc ? 2 : 4, Item.Length);
+
+			case 0xde:
+			case 0xdf:
+				Item.Type = FBinaryItem::Map;
+				return ReadBigEndian(Head == 0xde ? 2 : 4, Item.Length);
+
+			default:
+				// Extension types have no meaning for structs
+				return Fail(TEXT("Unsupported MessagePack type"));
+			}
+		}
+	};
+
+	class FCborDecoder : public FBinaryCursor
+	{
+	public:
+		using FBinaryCursor::FBinaryCursor;
+
+	protected:
+		bool ReadItem(FBinaryItem& Item)
+		{
+			for (;;)
+			{
+				if (Cur >= End)
+				{
+					return Fail(TEXT("Unexpected end of data"));
+				}
+
+				Item = FBinaryItem();
+				const uint8 Head = *Cur++;
+				const uint8 Major = Head >> 5;
+				const uint8 Info = Head & 0x1f;
+
+				uint64 Argument = Info;
+				if (Info >= 24 && Info <= 27)
+				{
+					if (!ReadBigEndian(1 << (Info - 24), Argument))
+					{
+						return false;
+					}
+				}
+				else if (Info > 27)
+				{
+					return Fail(TEXT("Indefinite length CBOR items are not supported"));
+				}
+
+				switch (Major)
+				{
+				case FHttpCbor::MajorUInt:
+					Item.Type = FBinaryItem::UInt;
+					Item.UIntValue = Argument;
+					return true;
+
+				case FHttpCbor::MajorNegativeInt:
+					if (Argument > (uint64)MAX_int64)
+					{
+						return Fail(TEXT("Integer out of range"));
+					}
+					Item.Type = FBinaryItem::Int;
+					Item.IntValue = -1 - (int64)Argument;
+					return true;
+
+				case FHttpCbor::MajorBytes:
+				case FHttpCbor::MajorText:
+					Item.Type = Major == FHttpCbor::MajorText ? FBinaryItem::String : FBinaryItem::Bytes;
+					Item.Length = Argument;
+					return ReadPayload(Item);
+
+				case FHttpCbor::MajorArray:
+				case FHttpCbor::MajorMap:
+					Item.Type = Major == FHttpCbor::MajorMap ? FBinaryItem::Map : FBinaryItem::Array;
+					Item.Length = Argument;
+					return true;
+
+				case FHttpCbor::MajorTag:
+					// Tags only annotate the next item
+					continue;
+
+				default:
+					return ReadSimple(Item, Info, Argument);
+				}
+			}
+		}
+
+	private:
+		bool ReadSimple(FBinaryItem& Item, uint8 Info, uint64 Argument)
+		{
+			switch (Info)
+			{
+			case 20:
+			case 21:
+				Item.Type = FBinaryItem::Bool;
+				Item.bBoolValue = Info == 21;
+				return true;
+
+			case 22:
+			case 23:
+				// Null and undefined
+				Item.Type = FBinaryItem::Nil;
+				return true;
+
+			case 25:
+				Item.Type = FBinaryItem::Float;
+				Item.FloatValue = HalfToDouble((uint16)Argument);
+				return true;
+
+			case 26:
+				Item.Type = FBinaryItem::Float;
+				Item.FloatValue = FloatFromBits((uint32)Argument);
+				return true;
+
+			case 27:
+				Item.Type = FBinaryItem::Float;
+				Item.FloatValue = DoubleFromBits(Argument);
+				return true;
+
+			default:
+				return Fail(TEXT("Unsupported CBOR simple value"));
+			}
+		}
+
+		static double HalfToDouble(uint16 Half)
+		{
+			const int32 Exponent = (Half >> 10) & 0x1f;
+			const int32 Mantissa = Half & 0x3ff;
+
+			double Value = 0.0;
+			if (Exponent == 0)
+			{
+				Value = FMath::Pow(2.0, -24.0) * Mantissa;
+			}
+			else if (Exponent != 31)
+			{
+				Value = FMath::Pow(2.0, (double)Exponent - 25.0) * (Mantissa + 1024);
+			}
+			else
+			{
+				Value = Mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+			}
+
+			return Half & 0x8000 ? -Value : Value;
+		}
+	};
+
+	// Reads binary documents into struct memory following plans. Strings are decoded straight into their FString.
+	template<typename DecoderType>
+	class TBinaryPlanReader : public DecoderType
+	{
+	public:
+		using DecoderType::DecoderType;
+
+		bool ReadDocument(const FHttpStructPlan& Plan, void* Data)
+		{
+			FBinaryItem Item;
+			if (!this->ReadItem(Item))
+			{
+				return false;
+			}
+
+			if (Item.Type != FBinaryItem::Map)
+			{
+				return this->Fail(TEXT("Expected map"));
+			}
+
+			if (!ReadStruct(Plan, Item, Data))
+			{
+				return false;
+			}
+
+			return this->Cur == this->End || this->Fail(TEXT("Unexpected data after document"));
+		}
+
+	private:
+		// Deeper documents are rejected instead of overflowing the stack
+		static constexpr int32 MaxDepth = 64;
+
+		// Each element takes at least a byte, so larger counts can't be real and would only allocate
+		bool CheckCount(uint64 Count)
+		{
+			return Count <= (uint64)(this->End - this->Cur) || this->Fail(TEXT("Too many elements"));
+		}
+
+		bool Enter()
+		{
+			return ++Depth <= MaxDepth || this->Fail(TEXT("Nesting is too deep"));
+		}
+
+		static FString ToString(const FBinaryItem& Item)
+		{
+			FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Item.Data), (int32)Item.Length);
+			return FString(Converted.Length(), Converted.Get());
+		}
+
+		bool ToInt(const FBinaryItem& Item, int64& OutValue)
+		{
+			switch (Item.Type)
+			{
+			case FBinaryItem::Int: OutValue = Item.IntValue; return true;
+			case FBinaryItem::UInt: OutValue = (int64)Item.UIntValue; return true;
+			case FBinaryItem::Float: OutValue = (int64)Item.FloatValue; return true;
+			default: return this->Fail(TEXT("Expected number"));
+			}
+		}
+
+		bool ToDouble(const FBinaryItem& Item, double& OutValue)
+		{
+			switch (Item.Type)
+			{
+			case FBinaryItem::Int: OutValue = (double)Item.IntValue; return true;
+			case FBinaryItem::UInt: OutValue = (double)Item.UIntValue; return true;
+			case FBinaryItem::Float: OutValue = Item.FloatValue; return true;
+			default: return this->Fail(TEXT("Expected number"));
+			}
+		}
+
+		bool ToString(const FBinaryItem& Item, FString& OutValue)
+		{
+			if (Item.Type != FBinaryItem::String)
+			{
+				return this->Fail(TEXT("Expected string"));
+			}
+
+			OutValue = ToString(Item);
+			return true;
+		}
+
+		bool ToEnumValue(const FBinaryItem& Item, const UEnum* Enum, int64& OutValue)
+		{
+			if (Item.Type != FBinaryItem::String)
+			{
+				return ToInt(Item, OutValue);
+			}
+
+			OutValue = Enum->GetValueByNameString(ToString(Item));
+			return OutValue != INDEX_NONE || this->Fail(TEXT("Unknown enum value"));
+		}
+
+		bool ImportText(const FBinaryItem& Item, const FProperty* Property, void* Value)
+		{
+			FString Text;
+			if (!ToString(Item, Text))
+			{
+				return false;
+			}
+
+			return Property->ImportText_Direct(*Text, Value, nullptr, PPF_None) != nullptr || this->Fail(TEXT("Invalid value"));
+		}
+
+		bool ReadStruct(const FHttpStructPlan& Plan, const FBinaryItem& MapItem, void* Data)
+		{
+			if (!Enter() || !CheckCount(MapItem.Length))
+			{
+				return false;
+			}
+
+			int32 Hint = 0;
+			for (uint64 Pair = 0; Pair < MapItem.Length; ++Pair)
+			{
+				FBinaryItem Key;
+				if (!this->ReadItem(Key))
+				{
+					return false;
+				}
+
+				if (Key.Type != FBinaryItem::String)
+				{
+					return this->Fail(TEXT("Expected string key"));
+				}
+
+				const FAnsiStringView KeyView(reinterpret_cast<const ANSICHAR*>(Key.Data), (int32)Key.Length);
+				const FHttpFieldPlan* Field = Plan.Fields.Num() > 0 ? Plan.FindField(KeyView, Hint) : nullptr;
+				if (!(Field ? ReadField(*Field, Data) : SkipValue()))
+				{
+					return false;
+				}
+			}
+
+			--Depth;
+			return true;
+		}
+
+		bool ReadField(const FHttpFieldPlan& Field, void* Data)
+		{
+			const FProperty* Property = Field.Value.Property;
+			if (Property->ArrayDim == 1)
+			{
+				return ReadValue(Field.Value, Property->ContainerPtrToValuePtr<void>(Data));
+			}
+
+			FBinaryItem Item;
+			if (!this->ReadItem(Item))
+			{
+				return false;
+			}
+
+			if (Item.Type == FBinaryItem::Nil)
+			{
+				return true;
+			}
+
+			if (Item.Type != FBinaryItem::Array || Item.Length > (uint64)Property->ArrayDim)
+			{
+				return this->Fail(TEXT("Expected array not longer than static array"));
+			}
+
+			for (int32 Index = 0; Index < (int32)Item.Length; ++Index)
+			{
+				if (!ReadValue(Field.Value, Property->ContainerPtrToValuePtr<void>(Data, Index)))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		bool ReadValue(const FHttpValuePlan& Plan, void* Value)
+		{
+			FBinaryItem Item;
+			return this->ReadItem(Item) && ReadValue(Plan, Item, Value);
+		}
+
+		bool ReadValue(const FHttpValuePlan& Plan, const FBinaryItem& Item, void* Value)
+		{
+			// Nil keeps what the struct already has
+			if (Item.Type == FBinaryItem::Nil)
+			{
+				return true;
+			}
+
+			switch (Plan.Kind)
+			{
+			case EHttpValueKind::Bool:
+				if (Item.Type != FBinaryItem::Bool)
+				{
+					return this->Fail(TEXT("Expected bool"));
+				}
+				static_cast<const FBoolProperty*>(Plan.Property)->SetPropertyValue(Value, Item.bBoolValue);
+				return true;
+
+			case EHttpValueKind::SignedInt:
+			{
+				int64 IntValue = 0;
+				if (!ToInt(Item, IntValue))
+				{
+					return false;
+				}
+				static_cast<const FNumericProperty*>(Plan.Property)->SetIntPropertyValue(Value, IntValue);
+				return true;
+			}
+
+			case EHttpValueKind::UnsignedInt:
+			{
+				int64 IntValue = 0;
+				if (Item.Type != FBinaryItem::UInt && !ToInt(Item, IntValue))
+				{
+					return false;
+				}
+				static_cast<const FNumericProperty*>(Plan.Property)->SetIntPropertyValue(Value, Item.Type == FBinaryItem::UInt ? Item.UIntValue : (uint64)IntValue);
+				return true;
+			}
+
+			case EHttpValueKind::Float:
+			{
+				double DoubleValue = 0.0;
+				if (!ToDouble(Item, DoubleValue))
+				{
+					return false;
+				}
+				*static_cast<float*>(Value) = (float)DoubleValue;
+				return true;
+			}
+
+			case EHttpValueKind::Double:
+				return ToDouble(Item, *static_cast<double*>(Value));
+
+			case EHttpValueKind::Enum:
+			{
+				const FEnumProperty* EnumProperty = static_cast<const FEnumProperty*>(Plan.Property);
+				int64 EnumValue = 0;
+				if (!ToEnumValue(Item, EnumProperty->GetEnum(), EnumValue))
+				{
+					return false;
+				}
+				EnumProperty->GetUnderlyingProperty()->SetIntPropertyValue(Value, EnumValue);
+				return true;
+			}
+
+			case EHttpValueKind::ByteEnum:
+			{
+				int64 EnumValue = 0;
+				if (!ToEnumValue(Item, static_cast<const FByteProperty*>(Plan.Property)->GetIntPropertyEnum(), EnumValue))
+				{
+					return false;
+				}
+				*static_cast<uint8*>(Value) = (uint8)EnumValue;
+				return true;
+			}
+
+			case EHttpValueKind::String:
+				return ToString(Item, *static_cast<FString*>(Value));
+
+			case EHttpValueKind::Name:
+			case EHttpValueKind::Text:
+			case EHttpValueKind::SoftObject:
+			{
+				FString Text;
+				if (!ToString(Item, Text))
+				{
+					return false;
+				}
+
+				if (Plan.Kind == EHttpValueKind::Name)
+				{
+					*static_cast<FName*>(Value) = FName(Text);
+				}
+				else if (Plan.Kind == EHttpValueKind::Text)
+				{
+					*static_cast<FText*>(Value) = FText::FromString(MoveTemp(Text));
+				}
+				else
+				{
+					*static_cast<FSoftObjectPtr*>(Value) = FSoftObjectPath(Text);
+				}
+				return true;
+			}
+
+			case EHttpValueKind::Struct:
+				if (Item.Type != FBinaryItem::Map)
+				{
+					return this->Fail(TEXT("Expected map"));
+				}
+				return ReadStruct(*Plan.StructPlan, Item, Value);
+
+			case EHttpValueKind::Array:
+				return ReadArray(Plan, Item, Value);
+
+			case EHttpValueKind::Set:
+				return ReadSet(Plan, Item, Value);
+
+			case EHttpValueKind::Map:
+				return ReadMap(Plan, Item, Value);
+
+			case EHttpValueKind::Object:
+				// Object references aren't resolved off the game thread, they keep their defaults
+				return SkipItem(Item);
+
+			default:
+				return ImportText(Item, Plan.Property, Value);
+			}
+		}
+
+		bool ReadArray(const FHttpValuePlan& Plan, const FBinaryItem& Item, void* Value)
+		{
+			FScriptArrayHelper Helper(static_cast<const FArrayProperty*>(Plan.Property), Value);
+
+			// Byte strings go to byte arrays in one copy
+			if (Plan.bBytes && Item.Type == FBinaryItem::Bytes)
+			{
+				Helper.EmptyAndAddUninitializedValues((int32)Item.Length);
+				if (Item.Length > 0)
+				{
+					FMemory::Memcpy(Helper.GetRawPtr(0), Item.Data, Item.Length);
+				}
+				return true;
+			}
+
+			if (Item.Type != FBinaryItem::Array)
+			{
+				return this->Fail(TEXT("Expected array"));
+			}
+
+			if (!Enter() || !CheckCount(Item.Length))
+			{
+				return false;
+			}
+
+			Helper.EmptyAndAddValues((int32)Item.Length);
+			for (int32 Index = 0; Index < (int32)Item.Length; ++Index)
+			{
+				if (!ReadValue(*Plan.Inner, Helper.GetRawPtr(Index)))
+				{
+					return false;
+				}
+			}
+
+			--Depth;
+			return true;
+		}
+
+		bool ReadSet(const FHttpValuePlan& Plan, const FBinaryItem& Item, void* Value)
+		{
+			if (Item.Type != FBinaryItem::Array)
+			{
+				return this->Fail(TEXT("Expected array"));
+			}
+
+			if (!Enter() || !CheckCount(Item.Length))
+			{
+				return false;
+			}
+
+			FScriptSetHelper Helper(static_cast<const FSetProperty*>(Plan.Property), Value);
+			Helper.EmptyElements();
+
+			// Element is hashed once read, a repeated one replaces the earlier
+			FHttpPropertyValue Element(Plan.Inner->Property);
+
+			bool bRead = true;
+			for (uint64 Index = 0; bRead && Index < Item.Length; ++Index)
+			{
+				Element.Reset();
+				bRead = ReadValue(*Plan.Inner, Element.Get());
+				if (bRead)
+				{
+					Helper.AddElement(Element.Get());
+				}
+			}
+
+			--Depth;
+			return bRead;
+		}
+
+		bool ReadMap(const FHttpValuePlan& Plan, const FBinaryItem& Item, void* Value)
+		{
+			if (Item.Type != FBinaryItem::Map)
+			{
+				return this->Fail(TEXT("Expected map"));
+			}
+
+			if (!Enter() || !CheckCount(Item.Length))
+			{
+				return false;
+			}
+
+			FScriptMapHelper Helper(static_cast<const FMapProperty*>(Plan.Property), Value);
+			Helper.EmptyValues();
+
+			const bool bTextKeys = Plan.Key->Kind == EHttpValueKind::Struct || Plan.Key->Kind == EHttpValueKind::Other;
+
+			// Key is hashed once read, a repeated one overwrites the earlier value
+			FHttpPropertyValue Key(Plan.Key->Property);
+
+			bool bRead = true;
+			for (uint64 Pair = 0; bRead && Pair < Item.Length; ++Pair)
+			{
+				Key.Reset();
+
+				FBinaryItem KeyItem;
+				bRead = this->ReadItem(KeyItem);
+				if (bRead)
+				{
+					// Keys are read the way they were written
+					bRead = bTextKeys ? ImportText(KeyItem, Plan.Key->Property, Key.Get()) : ReadValue(*Plan.Key, KeyItem, Key.Get());
+				}
+
+				bRead = bRead && ReadValue(*Plan.Inner, FHttpPropertyValue::FindOrResetMapValue(Helper, Plan.Inner->Property, Key.Get()));
+			}
+
+			--Depth;
+			return bRead;
+		}
+
+		bool SkipValue()
+		{
+			FBinaryItem Item;
+			return this->ReadItem(Item) && SkipItem(Item);
+		}
+
+		// Strings and bytes are already consumed with their head
+		bool SkipItem(const FBinaryItem& Item)
+		{
+			if (Item.Type != FBinaryItem::Array && Item.Type != FBinaryItem::Map)
+			{
+				return true;
+			}
+
+			if (!Enter() || !CheckCount(Item.Length))
+			{
+				return false;
+			}
+
+			const uint64 NumValues = Item.Type == FBinaryItem::Map ? Item.Length * 2 : Item.Length;
+			for (uint64 Index = 0; Index < NumValues; ++Index)
+			{
+				if (!SkipValue())
+				{
+					return false;
+				}
+			}
+
+			--Depth;
+			return true;
+		}
+
+		int32 Depth = 0;
+	};
+
+	template<typename EncoderType>
+	void AppendBinaryProperty(TArray<uint8>& Out, const FProperty* Property, const void* Value)
+	{
+		// Only the top level is planned per call, nested structs use cached plans
+		FHttpValuePlan Plan;
+		FHttpPlanCache::BuildValuePlan(Plan, Property, [](const UStruct* Struct) -> const FHttpStructPlan&
+		{
+			return FHttpPlanCache::Get().FindOrBuild(Struct);
+		});
+
+		TBinaryPlanWriter<EncoderType>(Out).WriteValue(Plan, Value);
+	}
+
+	template<typename DecoderType>
+	bool ReadBinaryStruct(TArrayView<const uint8> Bytes, const UScriptStruct* Struct, void* Data, FString* OutError)
+	{
+		TBinaryPlanReader<DecoderType> Reader(Bytes);
+		if (!Reader.ReadDocument(FHttpPlanCache::Get().FindOrBuild(Struct), Data))
+		{
+			if (OutError)
+			{
+				*OutError = MoveTemp(Reader.Error);
+			}
+			return false;
+		}
+
+		return true;
+	}
+}
+
+EHttpWireFormat FHttpStructSerializer::NegotiateFormat(const FHttpServerRequest& Request)
+{
+	const TArray<FString>* Values = Request.Headers.Find(TEXT("accept"));
+	if (!Values)
+	{
+		return EHttpWireFormat::Json;
+	}
+
+	// Highest quality wins, the first listed one on ties
+	EHttpWireFormat BestFormat = EHttpWireFormat::Json;
+	float BestQuality = 0.0f;
+
+	for (const FString& Value : *Values)
+	{
+		FStringView Remaining = Value;
+		while (!Remaining.IsEmpty())
+		{
+			int32 Comma = INDEX_NONE;
+			if (!Remaining.FindChar(TEXT(','), Comma))
+			{
+				Comma = Remaining.Len();
+			}
+
+			FStringView Token = Remaining.Left(Comma).TrimStartAndEnd();
+			Remaining.RightChopInline(Comma + 1);
+
+			FStringView Params;
+			int32 Semicolon = INDEX_NONE;
+			if (Token.FindChar(TEXT(';'), Semicolon))
+			{
+				Params = Token.RightChop(Semicolon + 1);
+				Token = Token.Left(Semicolon).TrimEnd();
+			}
+
+			EHttpWireFormat Format = EHttpWireFormat::Json;
+			if (!ParseMediaType(Token, Format))
+			{
+				continue;
+			}
+
+			const float Quality = ParseQuality(Params);
+			if (Quality > BestQuality)
+			{
+				BestFormat = Format;
+				BestQuality = Quality;
+			}
+		}
+	}
+
+	return BestFormat;
+}
+
+EHttpWireFormat FHttpStructSerializer::GetBodyFormat(const FHttpServerRequest& Request)
+{
+	const TArray<FString>* Values = Request.Headers.Find(TEXT("content-type"));
+	if (!Values || Values->Num() == 0)
+	{
+		return EHttpWireFormat::Json;
+	}
+
+	FStringView MediaType = (*Values)[0];
+	int32 Semicolon = INDEX_NONE;
+	if (MediaType.FindChar(TEXT(';'), Semicolon))
+	{
+		MediaType = MediaType.Left(Semicolon);
+	}
+
+	EHttpWireFormat Format = EHttpWireFormat::Json;
+	ParseMediaType(MediaType.TrimStartAndEnd(), Format);
+	return Format;
+}
+
+const TCHAR* FHttpStructSerializer::GetContentType(EHttpWireFormat Format)
+{
+	switch (Format)
+	{
+	case EHttpWireFormat::MessagePack:
+		return TEXT("application/msgpack");
+	case EHttpWireFormat::Cbor:
+		return TEXT("application/cbor");
+	default:
+		return TEXT("application/json");
+	}
+}
+
+void FHttpStructSerializer::AppendStruct(TArray<uint8>& Out, EHttpWireFormat Format, const UStruct* Struct, const void* Data)
+{
+	if (Format == EHttpWireFormat::Json || !Struct || !Data)
+	{
+		FHttpJsonSerializer::AppendStruct(Out, Struct, Data);
+		return;
+	}
+
+	const FHttpStructPlan& Plan = FHttpPlanCache::Get().FindOrBuild(Struct);
+	if (Format == EHttpWireFormat::MessagePack)
+	{
+		TBinaryPlanWriter<FMessagePackEncoder>(Out).WriteStruct(Plan, Data);
+	}
+	else
+	{
+		TBinaryPlanWriter<FCborEncoder>(Out).WriteStruct(Plan, Data);
+	}
+}
+
+void FHttpStructSerializer::AppendProperty(TArray<uint8>& Out, EHttpWireFormat Format, const FProperty* Property, const void* Value)
+{
+	if (Format == EHttpWireFormat::Json || !Property || !Value)
+	{
+		FHttpJsonSerializer::AppendProperty(Out, Property, Value);
+		return;
+	}
+
+	if (Format == EHttpWireFormat::MessagePack)
+	{
+		AppendBinaryProperty<FMessagePackEncoder>(Out, Property, Value);
+	}
+	else
+	{
+		AppendBinaryProperty<FCborEncoder>(Out, Property, Value);
+	}
+}
+
+bool FHttpStructSerializer::ReadStruct(TArrayView<const uint8> Bytes, EHttpWireFormat Format, const UScriptStruct* Struct, void* Data, FString* OutError)
+{
+	if (!Struct || !Data)
+	{
+		return false;
+	}
+
+	switch (Format)
+	{
+	case EHttpWireFormat::MessagePack:
+		return ReadBinaryStruct<FMessagePackDecoder>(Bytes, Struct, Data, OutError);
+	case EHttpWireFormat::Cbor:
+		return ReadBinaryStruct<FCborDecoder>(Bytes, Struct, Data, OutError);
+	default:
+		return FHttpJsonSerializer::ReadStruct(Bytes, Struct, Data, OutError);
+	}
+}
@@ -0,0 +1,301 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpTrafficRecording.h"
+#include "HttpResponseBuilder.h"
+#include "HAL/FileManager.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/FileHelper.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+
+namespace
+{
+	// "SHTR" and format version
+	constexpr uint32 RecordingMagic = 0x52544853;
+	constexpr uint32 RecordingVersion = 1;
+
+	void WriteVarInt(TArray<uint8>& Out, uint64 Value)
+	{
+		while (Value >= 0x80)
+		{
+			Out.Add((uint8)(Value | 0x80));
+			Value >>= 7;
+		}
+		Out.Add((uint8)Value);
+	}
+
+	void WriteString(TArray<uint8>& Out, FStringView Text)
+	{
+		const FTCHARToUTF8 Utf8(Text.GetData(), Text.Len());
+		WriteVarInt(Out, Utf8.Length());
+		Out.Append(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+	}
+
+	void WriteBytes(TArray<uint8>& Out, TArrayView<const uint8> Bytes)
+	{
+		WriteVarInt(Out, Bytes.Num());
+		Out.Append(Bytes.GetData(), Bytes.Num());
+	}
+
+	struct FRecordingReader
+	{
+		TArrayView<const uint8> Data;
+		int32 Pos = 0;
+
+		bool ReadVarInt(uint64& OutValue)
+		{
+			OutValue = 0;
+			for (int32 Shift = 0; Shift < 64; Shift += 7)
+			{
+				if (Pos >= Data.Num())
+				{
+					return false;
+				}
+
+				const uint8 Byte = Data[Pos++];
+				OutValue |= (uint64)(Byte & 0x7f) << Shift;
+				if ((Byte & 0x80) == 0)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		bool ReadBytes(TArrayView<const uint8>& OutBytes)
+		{
+			uint64 Len = 0;
+			if (!ReadVarInt(Len) || Len > (uint64)(Data.Num() - Pos))
+			{
+				return false;
+			}
+
+			OutBytes = Data.Slice(Pos, (int32)Len);
+			Pos += (int32)Len;
+			return true;
+		}
+
+		bool ReadString(FString& OutText)
+		{
+			TArrayView<const uint8> Bytes;
+			if (!ReadBytes(Bytes))
+			{
+				return false;
+			}
+
+			OutText = FString(FUTF8ToTCHAR(reinterpret_cast<const ANSICHAR*>(Bytes.GetData()), Bytes.Num()));
+			return true;
+		}
+	};
+
+	const TCHAR* GetVerbName(EHttpServerRequestVerbs Verb)
+	{
+		switch (Verb)
+		{
+		case EHttpServerRequestVerbs::VERB_POST:
+			return TEXT("POST");
+		case EHttpServerRequestVerbs::VERB_PUT:
+			return TEXT("PUT");
+		case EHttpServerRequestVerbs::VERB_PATCH:
+			return TEXT("PATCH");
+		case EHttpServerRequestVerbs::VERB_DELETE:
+			return TEXT("DELETE");
+		case EHttpServerRequestVerbs::VERB_OPTIONS:
+			return TEXT("OPTIONS");
+		default:
+			return TEXT("GET");
+		}
+	}
+
+	// Replaced by the replay client
+	bool IsTransportHeader(const FString& Name)
+	{
+		return Name.Equals(TEXT("host"), ESearchCase::IgnoreCase)
+			|| Name.Equals(TEXT("connection"), ESearchCase::IgnoreCase)
+			|| Name.Equals(TEXT("content-length"), ESearchCase::IgnoreCase)
+			|| Name.Equals(TEXT("transfer-encoding"), ESearchCase::IgnoreCase);
+	}
+}
+
+const TCHAR* FHttpTrafficRecorder::RedactedValue = TEXT("<redacted>");
+
+TUniquePtr<FHttpTrafficRecorder> FHttpTrafficRecorder::Create(const FString& Filename, const TArray<FString>& RedactedHeaders)
+{
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Writer.IsValid())
+	{
+		return nullptr;
+	}
+
+	uint32 Magic = RecordingMagic;
+	uint32 Version = RecordingVersion;
+	*Writer << Magic << Version;
+
+	return TUniquePtr<FHttpTrafficRecorder>(new FHttpTrafficRecorder(MoveTemp(Writer), RedactedHeaders));
+}
+
+FHttpTrafficRecorder::FHttpTrafficRecorder(TUniquePtr<FArchive>&& InWriter, const TArray<FString>& InRedactedHeaders)
+	: Writer(MoveTemp(InWriter))
+{
+	// TSet of FString compares case-insensitively
+	RedactedHeaders.Append(InRedactedHeaders);
+
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("SimpleHttpTrafficRecorder"), 64 * 1024, TPri_BelowNormal);
+}
+
+FHttpTrafficRecorder::~FHttpTrafficRecorder()
+{
+	bStopping = true;
+	WakeEvent->Trigger();
+
+	Thread->WaitForCompletion();
+	delete Thread;
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	Writer->Close();
+}
+
+uint32 FHttpTrafficRecorder::Run()
+{
+	while (true)
+	{
+		// Checked before draining, so records queued before the stop are all written
+		const bool bStop = bStopping;
+
+		TArray<uint8> Record;
+		while (PendingRecords.Dequeue(Record))
+		{
+			Writer->Serialize(Record.GetData(), Record.Num());
+		}
+
+		if (bStop)
+		{
+			return 0;
+		}
+
+		// Game thread doesn't signal every record, batches are written a few times a second
+		WakeEvent->Wait(100);
+	}
+}
+
+bool FHttpTrafficRecorder::IsRedacted(const FString& Header) const
+{
+	return RedactedHeaders.Contains(Header);
+}
+
+void FHttpTrafficRecorder::Record(const FHttpServerRequest& Request)
+{
+	const double Now = FPlatformTime::Seconds();
+	const uint64 DelayMicroseconds = NumRecords > 0 ? (uint64)FMath::Max((Now - LastRecordTime) * 1000000.0, 0.0) : 0;
+	LastRecordTime = Now;
+	++NumRecords;
+
+	TStringBuilder<256> Target;
+	Target.Append(Request.RelativePath.GetPath());
+
+	TCHAR Separator = TEXT('?');
+	for (const TPair<FString, FString>& QueryParam : Request.QueryParams)
+	{
+		Target.AppendChar(Separator);
+		Target.Append(FGenericPlatformHttp::UrlEncode(QueryParam.Key));
+		Target.AppendChar(TEXT('='));
+		Target.Append(FGenericPlatformHttp::UrlEncode(QueryParam.Value));
+		Separator = TEXT('&');
+	}
+
+	TArray<uint8> Record;
+	Record.Reserve(256 + Request.Body.Num());
+	WriteVarInt(Record, DelayMicroseconds);
+	Record.Add((uint8)Request.Verb);
+	WriteString(Record, Target.ToView());
+
+	WriteVarInt(Record, Request.Headers.Num());
+	for (const TPair<FString, TArray<FString>>& Header : Request.Headers)
+	{
+		WriteString(Record, Header.Key);
+		WriteString(Record, IsRedacted(Header.Key) ? FString(RedactedValue) : FString::Join(Header.Value, TEXT(", ")));
+	}
+
+	WriteBytes(Record, Request.Body);
+
+	PendingRecords.Enqueue(MoveTemp(Record));
+}
+
+bool FHttpTrafficRecorder::Load(const FString& Filename, TArray<FHttpRecordedRequest>& OutRequests, FString& OutError)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *Filename))
+	{
+		OutError = FString::Printf(TEXT("Can't read '%s'"), *Filename);
+		return false;
+	}
+
+	if (Data.Num() < 8 || FMemory::Memcmp(Data.GetData(), &RecordingMagic, 4) != 0)
+	{
+		OutError = FString::Printf(TEXT("'%s' isn't a traffic recording"), *Filename);
+		return false;
+	}
+
+	uint32 Version = 0;
+	FMemory::Memcpy(&Version, Data.GetData() + 4, 4);
+	if (Version != RecordingVersion)
+	{
+		OutError = FString::Printf(TEXT("Unsupported recording version %u"), Version);
+		return false;
+	}
+
+	FRecordingReader Reader{ Data, 8 };
+	while (Reader.Pos < Data.Num())
+	{
+		FHttpRecordedRequest& Request = OutRequests.AddDefaulted_GetRef();
+
+		uint64 NumHeaders = 0;
+		TArrayView<const uint8> Body;
+		bool bValid = Reader.ReadVarInt(Request.DelayMicroseconds) && Reader.Pos < Data.Num();
+		if (bValid)
+		{
+			Request.Verb = (EHttpServerRequestVerbs)Data[Reader.Pos++];
+			bValid = Reader.ReadString(Request.Target) && Reader.ReadVarInt(NumHeaders);
+		}
+
+		for (uint64 Index = 0; bValid && Index < NumHeaders; ++Index)
+		{
+			TPair<FString, FString>& Header = Request.Headers.AddDefaulted_GetRef();
+			bValid = Reader.ReadString(Header.Key) && Reader.ReadString(Header.Value);
+		}
+
+		if (!bValid || !Reader.ReadBytes(Body))
+		{
+			// Recording cut short by a crash still replays up to the last complete request
+			OutRequests.Pop();
+			OutError = FString::Printf(TEXT("Recording is truncated at byte %d"), Reader.Pos);
+			return OutRequests.Num() > 0;
+		}
+
+		Request.Body.Append(Body.GetData(), Body.Num());
+	}
+
+	return true;
+}
+
+TArray<uint8> FHttpRecordedRequest::MakeRequestBytes(const FString& Host) const
+{
+	TStringBuilder<1024> Head;
+	Head.Appendf(TEXT("%s %s HTTP/1.1\r\nhost: %s\r\n"), GetVerbName(Verb), *Target, *Host);
+
+	for (const TPair<FString, FString>& Header : Headers)
+	{
+		if (!IsTransportHeader(Header.Key))
+		{
+			Head.Appendf(TEXT("%s: %s\r\n"), *Header.Key, *Header.Value);
+		}
+	}
+
+	Head.Appendf(TEXT("content-length: %d\r\n\r\n"), Body.Num());
+
+	TArray<uint8> Bytes;
+	FHttpResponseBuilder::AppendUtf8(Bytes, Head.ToView());
+	Bytes.Append(Body);
+	return Bytes;
+}
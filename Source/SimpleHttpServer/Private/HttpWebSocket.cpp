@@ -0,0 +1,393 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpWebSocket.h"
+#include "SimpleHttpServer.h"
+#include "HttpStreamServer.h"
+#include "HttpResponseBuilder.h"
+#include "Misc/Base64.h"
+#include "Misc/SecureHash.h"
+
+namespace
+{
+	// RFC 6455 handshake constant
+	const TCHAR* WebSocketGuid = TEXT("258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+
+	const uint16 CloseNormal = 1000;
+	const uint16 CloseProtocolError = 1002;
+	const uint16 CloseMessageTooBig = 1009;
+
+	bool HeaderContains(const FHttpServerRequest& Request, const TCHAR* Name, const TCHAR* Token)
+	{
+		const TArray<FString>* Values = Request.Headers.Find(Name);
+		if (!Values)
+		{
+			return false;
+		}
+
+		for (const FString& Value : *Values)
+		{
+			if (Value.Contains(Token, ESearchCase::IgnoreCase))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
+
+FString FHttpWebSocketMessage::GetText() const
+{
+	FUTF8ToTCHAR TCHARData(reinterpret_cast<const ANSICHAR*>(Data.GetData()), Data.Num());
+	return FString(TCHARData.Length(), TCHARData.Get());
+}
+
+int32 FHttpWebSocketChannel::Broadcast(TArrayView<const uint8> Data, bool bBinary)
+{
+	return BroadcastFrame(EncodeFrame(bBinary ? OpBinary : OpText, Data));
+}
+
+int32 FHttpWebSocketChannel::Broadcast(FStringView Text)
+{
+	TArray<uint8> Bytes;
+	FHttpResponseBuilder::AppendUtf8(Bytes, Text);
+	return Broadcast(Bytes, false);
+}
+
+int32 FHttpWebSocketChannel::BroadcastFrame(const TSharedRef<const TArray<uint8>>& Frame)
+{
+	FScopeLock ScopeLock(&ClientsLock);
+
+	int32 NumSent = 0;
+	for (const TPair<uint32, TSharedRef<FClient>>& Client : Clients)
+	{
+		if (SendFrame(*Client.Value, Frame))
+		{
+			++NumSent;
+		}
+	}
+
+	return NumSent;
+}
+
+bool FHttpWebSocketChannel::Send(uint32 ClientId, TArrayView<const uint8> Data, bool bBinary)
+{
+	FScopeLock ScopeLock(&ClientsLock);
+
+	const TSharedRef<FClient>* Client = Clients.Find(ClientId);
+	return Client && SendFrame(**Client, EncodeFrame(bBinary ? OpBinary : OpText, Data));
+}
+
+bool FHttpWebSocketChannel::Send(uint32 ClientId, FStringView Text)
+{
+	TArray<uint8> Bytes;
+	FHttpResponseBuilder::AppendUtf8(Bytes, Text);
+	return Send(ClientId, Bytes, false);
+}
+
+void FHttpWebSocketChannel::Disconnect(uint32 ClientId)
+{
+	FScopeLock ScopeLock(&ClientsLock);
+
+	if (const TSharedRef<FClient>* Client = Clients.Find(ClientId))
+	{
+		CloseClient(**Client, CloseNormal);
+	}
+}
+
+int32 FHttpWebSocketChannel::GetNumClients() const
+{
+	FScopeLock ScopeLock(&ClientsLock);
+	return Clients.Num();
+}
+
+bool FHttpWebSocketChannel::SendFrame(FClient& Client, const TSharedRef<const TArray<uint8>>& Frame)
+{
+	if (Client.Connection->GetQueuedBytes() > MaxQueuedBytes)
+	{
+		if (DropPolicy == EHttpWebSocketDropPolicy::Disconnect)
+		{
+			UE_LOG(LogSimpleHttpServer, Warning, TEXT("WebSocket client %u is too slow, disconnecting it."), Client.Connection->GetId());
+			Client.Connection->Abort();
+		}
+		else
+		{
+			++NumDroppedMessages;
+		}
+
+		return false;
+	}
+
+	return Client.Connection->Send(Frame);
+}
+
+void FHttpWebSocketChannel::Accept(const TSharedRef<FHttpStreamConnection>& Connection, const FHttpServerRequest& Request)
+{
+	const TArray<FString>* Key = Request.Headers.Find(TEXT("sec-websocket-key"));
+	if (!Key || Key->Num() == 0 || !HeaderContains(Request, TEXT("upgrade"), TEXT("websocket")) || !HeaderContains(Request, TEXT("sec-websocket-version"), TEXT("13")))
+	{
+		TMap<FString, TArray<FString>> Headers;
+		Headers.Add(TEXT("sec-websocket-version"), { TEXT("13") });
+		Headers.Add(TEXT("content-length"), { TEXT("0") });
+		Headers.Add(TEXT("connection"), { TEXT("close") });
+
+		Connection->Send(FHttpStreamServer::MakeResponseHead(426, Headers));
+		Connection->Close();
+		return;
+	}
+
+	FTCHARToUTF8 KeyAndGuid(*((*Key)[0] + WebSocketGuid));
+	uint8 Hash[FSHA1::DigestSize];
+	FSHA1::HashBuffer(KeyAndGuid.Get(), KeyAndGuid.Length(), Hash);
+
+	TMap<FString, TArray<FString>> Headers;
+	Headers.Add(TEXT("upgrade"), { TEXT("websocket") });
+	Headers.Add(TEXT("connection"), { TEXT("Upgrade") });
+	Headers.Add(TEXT("sec-websocket-accept"), { FBase64::Encode(Hash, FSHA1::DigestSize) });
+
+	const uint32 ClientId = Connection->GetId();
+	TSharedRef<FClient> Client = MakeShared<FClient>(Connection);
+	TWeakPtr<FHttpWebSocketChannel> WeakThis = AsShared();
+
+	// Both callbacks are released when connection closes
+	Connection->OnData = [WeakThis, Client](TArrayView<const uint8> Data)
+	{
+		if (TSharedPtr<FHttpWebSocketChannel> This = WeakThis.Pin())
+		{
+			if (const uint16 CloseCode = This->ProcessData(*Client, Data))
+			{
+				This->CloseClient(*Client, CloseCode);
+			}
+		}
+	};
+
+	Connection->OnClosed = [WeakThis, ClientId]()
+	{
+		if (TSharedPtr<FHttpWebSocketChannel> This = WeakThis.Pin())
+		{
+			This->RemoveClient(ClientId);
+		}
+	};
+
+	{
+		// Handshake is queued under the lock, so no broadcast gets in front of it
+		FScopeLock ScopeLock(&ClientsLock);
+		Connection->Send(FHttpStreamServer::MakeResponseHead(101, Headers));
+		Clients.Add(ClientId, Client);
+	}
+
+	if (OnConnected)
+	{
+		OnConnected(ClientId);
+	}
+}
+
+uint16 FHttpWebSocketChannel::ProcessData(FClient& Client, TArrayView<const uint8> Data)
+{
+	Client.Pending.Append(Data.GetData(), Data.Num());
+
+	int32 Offset = 0;
+	uint16 CloseCode = 0;
+	while (CloseCode == 0 && Client.Connection->IsOpen())
+	{
+		const TArrayView<const uint8> Frame = TArrayView<const uint8>(Client.Pending).Slice(Offset, Client.Pending.Num() - Offset);
+
+		FFrameHeader Header;
+		if (!ParseFrameHeader(Frame, Header))
+		{
+			break;
+		}
+
+		// Client frames are always masked
+		if (!Header.bMasked)
+		{
+			CloseCode = CloseProtocolError;
+			break;
+		}
+
+		if (Header.PayloadSize > (uint64)MaxMessageSize || Client.Message.Num() + Header.PayloadSize > (uint64)MaxMessageSize)
+		{
+			CloseCode = CloseMessageTooBig;
+			break;
+		}
+
+		if (Frame.Num() < Header.HeaderSize + (int64)Header.PayloadSize)
+		{
+			break;
+		}
+
+		TArray<uint8> Payload;
+		Payload.SetNumUninitialized((int32)Header.PayloadSize);
+		for (int32 Index = 0; Index < Payload.Num(); ++Index)
+		{
+			Payload[Index] = Frame[Header.HeaderSize + Index] ^ Header.Mask[Index & 3];
+		}
+
+		Offset += Header.HeaderSize + (int32)Header.PayloadSize;
+
+		switch (Header.Opcode)
+		{
+		case OpText:
+		case OpBinary:
+			if (Client.MessageOpcode != 0)
+			{
+				CloseCode = CloseProtocolError;
+			}
+			else if (Header.bFinal)
+			{
+				if (OnMessage)
+				{
+					OnMessage(FHttpWebSocketMessage{ Client.Connection->GetId(), Header.Opcode == OpBinary, MoveTemp(Payload) });
+				}
+			}
+			else
+			{
+				Client.MessageOpcode = Header.Opcode;
+				Client.Message = MoveTemp(Payload);
+			}
+			break;
+
+		case OpContinuation:
+			if (Client.MessageOpcode == 0)
+			{
+				CloseCode = CloseProtocolError;
+				break;
+			}
+
+			Client.Message.Append(Payload);
+			if (Header.bFinal)
+			{
+				if (OnMessage)
+				{
+					OnMessage(FHttpWebSocketMessage{ Client.Connection->GetId(), Client.MessageOpcode == OpBinary, MoveTemp(Client.Message) });
+				}
+
+				Client.Message.Reset();
+				Client.MessageOpcode = 0;
+			}
+			break;
+
+		case OpPing:
+			// Control frames skip the drop policy, they are tiny and the client waits for them
+			Client.Connection->Send(EncodeFrame(OpPong, Payload));
+			break;
+
+		case OpPong:
+			break;
+
+		case OpClose:
+			// Echo status code back and close after it is sent
+			Client.Connection->Send(EncodeFrame(OpClose, TArrayView<const uint8>(Payload).Slice(0, FMath::Min(Payload.Num(), 2))));
+			Client.Connection->Close();
+			break;
+
+		default:
+			CloseCode = CloseProtocolError;
+			break;
+		}
+	}
+
+	Client.Pending.RemoveAt(0, FMath::Min(Offset, Client.Pending.Num()), false);
+	return CloseCode;
+}
+
+bool FHttpWebSocketChannel::ParseFrameHeader(TArrayView<const uint8> Data, FFrameHeader& OutHeader)
+{
+	if (Data.Num() < 2)
+	{
+		return false;
+	}
+
+	OutHeader.bFinal = (Data[0] & 0x80) != 0;
+	OutHeader.Opcode = Data[0] & 0x0F;
+	OutHeader.bMasked = (Data[1] & 0x80) != 0;
+
+	int32 HeaderSize = 2;
+	uint64 PayloadSize = Data[1] & 0x7F;
+	if (PayloadSize == 126)
+	{
+		HeaderSize += 2;
+		if (Data.Num() < HeaderSize)
+		{
+			return false;
+		}
+		PayloadSize = ((uint64)Data[2] << 8) | Data[3];
+	}
+	else if (PayloadSize == 127)
+	{
+		HeaderSize += 8;
+		if (Data.Num() < HeaderSize)
+		{
+			return false;
+		}
+		PayloadSize = 0;
+		for (int32 Index = 2; Index < 10; ++Index)
+		{
+			PayloadSize = (PayloadSize << 8) | Data[Index];
+		}
+	}
+
+	if (OutHeader.bMasked)
+	{
+		if (Data.Num() < HeaderSize + 4)
+		{
+			return false;
+		}
+		FMemory::Memcpy(OutHeader.Mask, Data.GetData() + HeaderSize, 4);
+		HeaderSize += 4;
+	}
+
+	OutHeader.PayloadSize = PayloadSize;
+	OutHeader.HeaderSize = HeaderSize;
+	return true;
+}
+
+void FHttpWebSocketChannel::CloseClient(FClient& Client, uint16 Code)
+{
+	const uint8 Payload[] = { (uint8)(Code >> 8), (uint8)(Code & 0xFF) };
+	Client.Connection->Send(EncodeFrame(OpClose, Payload));
+	Client.Connection->Close();
+}
+
+void FHttpWebSocketChannel::RemoveClient(uint32 ClientId)
+{
+	{
+		FScopeLock ScopeLock(&ClientsLock);
+		Clients.Remove(ClientId);
+	}
+
+	if (OnDisconnected)
+	{
+		OnDisconnected(ClientId);
+	}
+}
+
+TSharedRef<const TArray<uint8>> FHttpWebSocketChannel::EncodeFrame(uint8 Opcode, TArrayView<const uint8> Payload)
+{
+	TArray<uint8> Frame;
+	Frame.Reserve(Payload.Num() + 10);
+	Frame.Add(0x80 | Opcode);
+
+	const uint64 PayloadSize = Payload.Num();
+	if (PayloadSize < 126)
+	{
+		Frame.Add((uint8)PayloadSize);
+	}
+	else if (PayloadSize <= 0xFFFF)
+	{
+		Frame.Add(126);
+		Frame.Add((uint8)(PayloadSize >> 8));
+		Frame.Add((uint8)(PayloadSize & 0xFF));
+	}
+	else
+	{
+		Frame.Add(127);
+		for (int32 Shift = 56; Shift >= 0; Shift -= 8)
+		{
+			Frame.Add((uint8)((PayloadSize >> Shift) & 0xFF));
+		}
+	}
+
+	Frame.Append(Payload.GetData(), Payload.Num());
+	return MakeShared<const TArray<uint8>>(MoveTemp(Frame));
+}
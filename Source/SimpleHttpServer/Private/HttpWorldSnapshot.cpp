@@ -0,0 +1,235 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpWorldSnapshot.h"
+#include "SimpleHttpServer.h"
+
+FHttpSnapshotValue::FHttpSnapshotValue(FName InName, const UScriptStruct* InStruct)
+	: Name(InName)
+	, Struct(InStruct)
+{
+	Memory = FMemory::Malloc(FMath::Max(Struct->GetStructureSize(), 1), Struct->GetMinAlignment());
+	Struct->InitializeStruct(Memory);
+}
+
+FHttpSnapshotValue::~FHttpSnapshotValue()
+{
+	Struct->DestroyStruct(Memory);
+	FMemory::Free(Memory);
+}
+
+const FHttpSnapshotValue* FHttpWorldSnapshot::Find(FName Name) const
+{
+	// Few values per snapshot, linear scan beats hashing
+	for (const TUniquePtr<FHttpSnapshotValue>& Value : Values)
+	{
+		if (Value->Name == Name)
+		{
+			return Value.Get();
+		}
+	}
+
+	return nullptr;
+}
+
+FHttpSnapshotRef::FHttpSnapshotRef(const FHttpSnapshotRef& Other)
+	: Snapshot(Other.Snapshot)
+{
+	if (Snapshot)
+	{
+		++Snapshot->RefCount;
+	}
+}
+
+FHttpSnapshotRef::FHttpSnapshotRef(FHttpSnapshotRef&& Other)
+	: Snapshot(Other.Snapshot)
+{
+	Other.Snapshot = nullptr;
+}
+
+FHttpSnapshotRef& FHttpSnapshotRef::operator=(const FHttpSnapshotRef& Other)
+{
+	if (this != &Other)
+	{
+		Release();
+		Snapshot = Other.Snapshot;
+		if (Snapshot)
+		{
+			++Snapshot->RefCount;
+		}
+	}
+
+	return *this;
+}
+
+FHttpSnapshotRef& FHttpSnapshotRef::operator=(FHttpSnapshotRef&& Other)
+{
+	if (this != &Other)
+	{
+		Release();
+		Snapshot = Other.Snapshot;
+		Other.Snapshot = nullptr;
+	}
+
+	return *this;
+}
+
+FHttpSnapshotRef::~FHttpSnapshotRef()
+{
+	Release();
+}
+
+void FHttpSnapshotRef::Release()
+{
+	// Publisher holds its own reference, so this deletes only after the publisher is gone
+	if (Snapshot && --Snapshot->RefCount == 0)
+	{
+		delete Snapshot;
+	}
+
+	Snapshot = nullptr;
+}
+
+FHttpSnapshotPublisher::~FHttpSnapshotPublisher()
+{
+	FHttpWorldSnapshot* Snapshot = Current.exchange(nullptr);
+
+	// A reader that loaded the old pointer hasn't counted its reference yet, wait for it before dropping ours
+	while (NumAcquiring.load() != 0)
+	{
+		FPlatformProcess::Yield();
+	}
+
+	// Snapshots still read by handlers are deleted by their last reader
+	ReleaseSnapshot(Snapshot);
+
+	for (FHttpWorldSnapshot* RetiredSnapshot : Retired)
+	{
+		ReleaseSnapshot(RetiredSnapshot);
+	}
+	Retired.Reset();
+}
+
+void FHttpSnapshotPublisher::RegisterStruct(FName Name, const UScriptStruct* Struct, TFunction<void(void* OutValue)> Capture)
+{
+	if (!Struct || !Capture)
+	{
+		UE_LOG(LogSimpleHttpServer, Error, TEXT("Snapshot source '%s' needs struct type and capture function."), *Name.ToString());
+		return;
+	}
+
+	Unregister(Name);
+	Sources.Add(FSource{ Name, Struct, MoveTemp(Capture) });
+}
+
+void FHttpSnapshotPublisher::Unregister(FName Name)
+{
+	Sources.RemoveAll([Name](const FSource& Source)
+	{
+		return Source.Name == Name;
+	});
+}
+
+void FHttpSnapshotPublisher::Publish(double Time)
+{
+	check(IsInGameThread());
+
+	FHttpWorldSnapshot* Snapshot = ReclaimSnapshot();
+	if (!Snapshot)
+	{
+		Snapshot = new FHttpWorldSnapshot();
+	}
+
+	Snapshot->Version = NextVersion++;
+	Snapshot->Time = Time;
+
+	// Keep values of the same type from the reused snapshot, capture writes over them
+	TArray<TUniquePtr<FHttpSnapshotValue>> PreviousValues = MoveTemp(Snapshot->Values);
+	Snapshot->Values.Reset();
+	Snapshot->Values.Reserve(Sources.Num());
+
+	for (const FSource& Source : Sources)
+	{
+		TUniquePtr<FHttpSnapshotValue> Value;
+		for (TUniquePtr<FHttpSnapshotValue>& PreviousValue : PreviousValues)
+		{
+			if (PreviousValue.IsValid() && PreviousValue->Name == Source.Name && PreviousValue->Struct == Source.Struct)
+			{
+				Value = MoveTemp(PreviousValue);
+				break;
+			}
+		}
+
+		if (!Value.IsValid())
+		{
+			Value = MakeUnique<FHttpSnapshotValue>(Source.Name, Source.Struct);
+		}
+
+		Source.Capture(Value->Memory);
+		Snapshot->Values.Add(MoveTemp(Value));
+	}
+
+	// Readers acquiring from now on see the new snapshot
+	if (FHttpWorldSnapshot* Previous = Current.exchange(Snapshot))
+	{
+		Retired.Add(Previous);
+	}
+}
+
+FHttpSnapshotRef FHttpSnapshotPublisher::Acquire() const
+{
+	// Announce the reader first, so the publisher doesn't reuse a snapshot between our load and increment
+	++NumAcquiring;
+
+	FHttpWorldSnapshot* Snapshot = Current.load();
+	if (Snapshot)
+	{
+		++Snapshot->RefCount;
+	}
+
+	--NumAcquiring;
+
+	return FHttpSnapshotRef(Snapshot);
+}
+
+FHttpWorldSnapshot* FHttpSnapshotPublisher::ReclaimSnapshot()
+{
+	// Someone could be about to reference a retired snapshot, try next tick
+	if (Retired.Num() == 0 || NumAcquiring.load() != 0)
+	{
+		return nullptr;
+	}
+
+	FHttpWorldSnapshot* Reclaimed = nullptr;
+	for (int32 Index = Retired.Num() - 1; Index >= 0; --Index)
+	{
+		FHttpWorldSnapshot* Snapshot = Retired[Index];
+
+		// Only the publisher's own reference is left
+		if (Snapshot->RefCount.load() != 1)
+		{
+			continue;
+		}
+
+		Retired.RemoveAtSwap(Index, 1, false);
+
+		// One is enough for the next publish, free the rest
+		if (Reclaimed)
+		{
+			delete Snapshot;
+		}
+		else
+		{
+			Reclaimed = Snapshot;
+		}
+	}
+
+	return Reclaimed;
+}
+
+void FHttpSnapshotPublisher::ReleaseSnapshot(const FHttpWorldSnapshot* Snapshot)
+{
+	if (Snapshot && --Snapshot->RefCount == 0)
+	{
+		delete Snapshot;
+	}
+}
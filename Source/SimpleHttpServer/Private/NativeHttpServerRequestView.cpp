@@ -0,0 +1,84 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "NativeHttpServerRequestView.h"
+#include "SimpleHttpServer.h"
+
+FNativeHttpServerRequestView::FNativeHttpServerRequestView(const FHttpServerRequest& SourceRequest, const FHttpRouteMatch& Match, const TSharedRef<const FSimpleHttpRoute>& InRoute)
+	: Request(MakeShared<const FHttpServerRequest>(SourceRequest))
+	, Route(InRoute)
+{
+	// Match values point into the source request path, move them to our copy
+	const TCHAR* SourcePath = *SourceRequest.RelativePath.GetPath();
+	const TCHAR* OwnPath = *Request->RelativePath.GetPath();
+
+	PathParamValues.Reserve(Match.Params.Num());
+	for (const TPair<FStringView, FStringView>& Param : Match.Params)
+	{
+		if (Param.Value.IsEmpty())
+		{
+			PathParamValues.Add(FStringView());
+			continue;
+		}
+
+		const int32 Offset = UE_PTRDIFF_TO_INT32(Param.Value.GetData() - SourcePath);
+		PathParamValues.Add(FStringView(OwnPath + Offset, Param.Value.Len()));
+	}
+}
+
+FStringView FNativeHttpServerRequestView::GetHeader(FStringView Name) const
+{
+	const TArray<FString>* Values = FindHeaderValues(Name);
+	return Values && Values->Num() > 0 ? FStringView((*Values)[0]) : FStringView();
+}
+
+const TArray<FString>* FNativeHttpServerRequestView::FindHeaderValues(FStringView Name) const
+{
+	// Few headers per request, linear scan is cheaper than building FString key
+	for (const TPair<FString, TArray<FString>>& Header : Request->Headers)
+	{
+		if (Name.Equals(Header.Key, ESearchCase::IgnoreCase))
+		{
+			return &Header.Value;
+		}
+	}
+
+	return nullptr;
+}
+
+FStringView FNativeHttpServerRequestView::GetQueryParam(FStringView Name) const
+{
+	for (const TPair<FString, FString>& QueryParam : Request->QueryParams)
+	{
+		if (Name.Equals(QueryParam.Key, ESearchCase::IgnoreCase))
+		{
+			return QueryParam.Value;
+		}
+	}
+
+	return FStringView();
+}
+
+FStringView FNativeHttpServerRequestView::GetPathParam(FStringView Name) const
+{
+	const TArray<FStringView>& ParamNames = Route->ParamNames;
+	for (int32 Index = 0; Index < ParamNames.Num() && Index < PathParamValues.Num(); ++Index)
+	{
+		if (ParamNames[Index].Equals(Name, ESearchCase::IgnoreCase))
+		{
+			return PathParamValues[Index];
+		}
+	}
+
+	return FStringView();
+}
+
+FUtf8StringView FNativeHttpServerRequestView::GetBodyUtf8() const
+{
+	return FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Request->Body.GetData()), Request->Body.Num());
+}
+
+FString FNativeHttpServerRequestView::GetBodyAsString() const
+{
+	FUTF8ToTCHAR BodyTCHARData(reinterpret_cast<const ANSICHAR*>(Request->Body.GetData()), Request->Body.Num());
+	return FString(BodyTCHARData.Length(), BodyTCHARData.Get());
+}
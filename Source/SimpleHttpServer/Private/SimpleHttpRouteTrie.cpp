@@ -0,0 +1,253 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "SimpleHttpRouteTrie.h"
+#include "SimpleHttpServer.h"
+
+FStringView FHttpRouteMatch::FindParam(FStringView Name) const
+{
+	for (const TPair<FStringView, FStringView>& Param : Params)
+	{
+		if (Param.Key.Equals(Name, ESearchCase::IgnoreCase))
+		{
+			return Param.Value;
+		}
+	}
+
+	return FStringView();
+}
+
+FSimpleHttpRouteTrie::FNode::FNode()
+{
+	for (int32& RouteIndex : Routes)
+	{
+		RouteIndex = INDEX_NONE;
+	}
+}
+
+FSimpleHttpRouteTrie::FSimpleHttpRouteTrie()
+	: Root(MakeUnique<FNode>())
+{
+}
+
+FSimpleHttpRouteTrie::~FSimpleHttpRouteTrie() = default;
+
+bool FSimpleHttpRouteTrie::Insert(FStringView Pattern, uint8 VerbMask, int32 RouteIndex)
+{
+	FNode* Node = Root.Get();
+
+	int32 StaticStart = 0;
+	int32 Pos = 0;
+	while (Pos < Pattern.Len())
+	{
+		const TCHAR Char = Pattern[Pos];
+		const bool bSegmentStart = Pos == 0 || Pattern[Pos - 1] == TEXT('/');
+		if (!bSegmentStart || (Char != TEXT(':') && Char != TEXT('*')))
+		{
+			++Pos;
+			continue;
+		}
+
+		Node = InsertStatic(Node, Pattern.Mid(StaticStart, Pos - StaticStart));
+
+		int32 End = Pos;
+		while (End < Pattern.Len() && Pattern[End] != TEXT('/'))
+		{
+			++End;
+		}
+
+		const FStringView Name = Pattern.Mid(Pos + 1, End - Pos - 1);
+		if (Name.IsEmpty())
+		{
+			UE_LOG(LogSimpleHttpServer, Error, TEXT("Route '%.*s' has unnamed parameter."), Pattern.Len(), Pattern.GetData());
+			return false;
+		}
+
+		if (Char == TEXT('*'))
+		{
+			if (End != Pattern.Len())
+			{
+				UE_LOG(LogSimpleHttpServer, Error, TEXT("Route '%.*s': wildcard must be the last segment."), Pattern.Len(), Pattern.GetData());
+				return false;
+			}
+
+			Node = InsertParam(Node, Node->WildcardChild, Name, Pattern);
+		}
+		else
+		{
+			Node = InsertParam(Node, Node->ParamChild, Name, Pattern);
+		}
+
+		if (!Node)
+		{
+			return false;
+		}
+
+		Pos = End;
+		StaticStart = End;
+	}
+
+	Node = InsertStatic(Node, Pattern.Mid(StaticStart));
+
+	for (int32 VerbIndex = 0; VerbIndex < NumVerbs; ++VerbIndex)
+	{
+		if (VerbMask & (1 << VerbIndex))
+		{
+			Node->Routes[VerbIndex] = RouteIndex;
+		}
+	}
+
+	return true;
+}
+
+FSimpleHttpRouteTrie::FNode* FSimpleHttpRouteTrie::InsertStatic(FNode* Node, FStringView Text)
+{
+	const FString LowerText = FString(Text).ToLower();
+	FStringView Remaining = LowerText;
+
+	while (!Remaining.IsEmpty())
+	{
+		const int32 ChildIndex = Node->Indices.Find(Remaining[0]);
+		if (ChildIndex == INDEX_NONE)
+		{
+			TUniquePtr<FNode> NewChild = MakeUnique<FNode>();
+			NewChild->Prefix = FString(Remaining);
+
+			FNode* Result = NewChild.Get();
+			Node->Indices.Add(Remaining[0]);
+			Node->Children.Add(MoveTemp(NewChild));
+			return Result;
+		}
+
+		TUniquePtr<FNode>& Child = Node->Children[ChildIndex];
+
+		int32 CommonLen = 0;
+		const int32 MaxCommonLen = FMath::Min(Child->Prefix.Len(), Remaining.Len());
+		while (CommonLen < MaxCommonLen && Child->Prefix[CommonLen] == Remaining[CommonLen])
+		{
+			++CommonLen;
+		}
+
+		// Split child so that its prefix is the common part
+		if (CommonLen < Child->Prefix.Len())
+		{
+			TUniquePtr<FNode> Split = MakeUnique<FNode>();
+			Split->Prefix = Child->Prefix.Left(CommonLen);
+
+			Child->Prefix.RightChopInline(CommonLen, false);
+			Split->Indices.Add(Child->Prefix[0]);
+			Split->Children.Add(MoveTemp(Child));
+
+			Child = MoveTemp(Split);
+		}
+
+		Node = Child.Get();
+		Remaining.RightChopInline(CommonLen);
+	}
+
+	return Node;
+}
+
+FSimpleHttpRouteTrie::FNode* FSimpleHttpRouteTrie::InsertParam(FNode* Node, TUniquePtr<FNode>& Child, FStringView Name, FStringView Pattern)
+{
+	if (!Child.IsValid())
+	{
+		Child = MakeUnique<FNode>();
+		Child->ParamName = FString(Name);
+	}
+	else if (!Child->ParamName.Equals(Name, ESearchCase::CaseSensitive))
+	{
+		UE_LOG(LogSimpleHttpServer, Error, TEXT("Route '%.*s': parameter '%.*s' conflicts with already bound parameter '%s'."),
+			Pattern.Len(), Pattern.GetData(), Name.Len(), Name.GetData(), *Child->ParamName);
+		return nullptr;
+	}
+
+	return Child.Get();
+}
+
+bool FSimpleHttpRouteTrie::Find(FStringView Path, uint8 Verb, FHttpRouteMatch& OutMatch) const
+{
+	OutMatch.RouteIndex = INDEX_NONE;
+	OutMatch.Params.Reset();
+
+	const int32 VerbIndex = GetVerbIndex(Verb);
+	if (VerbIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	return FindRecursive(*Root, Path, VerbIndex, OutMatch);
+}
+
+bool FSimpleHttpRouteTrie::FindRecursive(const FNode& Node, FStringView Path, int32 VerbIndex, FHttpRouteMatch& OutMatch) const
+{
+	if (Path.IsEmpty())
+	{
+		if (Node.Routes[VerbIndex] != INDEX_NONE)
+		{
+			OutMatch.RouteIndex = Node.Routes[VerbIndex];
+			return true;
+		}
+	}
+	else
+	{
+		const int32 ChildIndex = Node.Indices.Find(FChar::ToLower(Path[0]));
+		if (ChildIndex != INDEX_NONE)
+		{
+			const FNode& Child = *Node.Children[ChildIndex];
+			if (Path.StartsWith(Child.Prefix, ESearchCase::IgnoreCase) && FindRecursive(Child, Path.RightChop(Child.Prefix.Len()), VerbIndex, OutMatch))
+			{
+				return true;
+			}
+		}
+
+		if (Node.ParamChild.IsValid())
+		{
+			int32 SegmentEnd = 0;
+			if (!Path.FindChar(TEXT('/'), SegmentEnd))
+			{
+				SegmentEnd = Path.Len();
+			}
+
+			if (SegmentEnd > 0)
+			{
+				OutMatch.Params.Emplace(Node.ParamChild->ParamName, Path.Left(SegmentEnd));
+				if (FindRecursive(*Node.ParamChild, Path.RightChop(SegmentEnd), VerbIndex, OutMatch))
+				{
+					return true;
+				}
+
+				OutMatch.Params.Pop(false);
+			}
+		}
+	}
+
+	if (Node.WildcardChild.IsValid() && Node.WildcardChild->Routes[VerbIndex] != INDEX_NONE)
+	{
+		OutMatch.Params.Emplace(Node.WildcardChild->ParamName, Path);
+		OutMatch.RouteIndex = Node.WildcardChild->Routes[VerbIndex];
+		return true;
+	}
+
+	return false;
+}
+
+int32 FSimpleHttpRouteTrie::GetVerbIndex(uint8 Verb)
+{
+	if (Verb == 0 || !FMath::IsPowerOfTwo(Verb))
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 VerbIndex = FMath::CountTrailingZeros((uint32)Verb);
+	return VerbIndex < NumVerbs ? VerbIndex : INDEX_NONE;
+}
+
+void FSimpleHttpRouteTrie::Reset()
+{
+	Root = MakeUnique<FNode>();
+}
+
+bool FSimpleHttpRouteTrie::IsEmpty() const
+{
+	return Root->Children.IsEmpty() && !Root->ParamChild.IsValid() && !Root->WildcardChild.IsValid();
+}
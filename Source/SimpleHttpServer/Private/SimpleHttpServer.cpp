@@ -6,16 +6,65 @@
 #include "HttpServerHttpVersion.h"
 #include "HttpServerModule.h"
 #include "HttpServerResponse.h"
+#include "HttpResponseBuilder.h"
+#include "HttpConditionalRequest.h"
+#include "HttpResponseCompression.h"
+#include "HttpStaticDirectory.h"
+#include "HttpStructSerializer.h"
+#include "HttpServerMetrics.h"
+#include "HttpServerTrace.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
 #include "Misc/EngineVersionComparison.h"
+#include "Misc/QueuedThreadPool.h"
+#include "Misc/IQueuedWork.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Async/Async.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
 
 DEFINE_LOG_CATEGORY(LogSimpleHttpServer);
 
+// Counters are summed over all servers
+DECLARE_STATS_GROUP(TEXT("SimpleHttpServer"), STATGROUP_SimpleHttpServer, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Requests/Frame"), STAT_SimpleHttpServer_Requests, STATGROUP_SimpleHttpServer);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Game Thread Handlers (ms)"), STAT_SimpleHttpServer_GameThreadMs, STATGROUP_SimpleHttpServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pending Requests"), STAT_SimpleHttpServer_QueueDepth, STATGROUP_SimpleHttpServer);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Open Stream Connections"), STAT_SimpleHttpServer_Connections, STATGROUP_SimpleHttpServer);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Bytes In/sec"), STAT_SimpleHttpServer_BytesInPerSecond, STATGROUP_SimpleHttpServer);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Bytes Out/sec"), STAT_SimpleHttpServer_BytesOutPerSecond, STATGROUP_SimpleHttpServer);
+
+CSV_DEFINE_CATEGORY(SimpleHttpServer, true);
+
 namespace
 {
-	FHttpPath MakeHttpPathForRoute(const FString& HttpPath)
+	// AsyncPool work does nothing on Abandon and leaks its closure. This one releases it, so route completions answer 500.
+	class FRouteQueuedWork final : public IQueuedWork
 	{
-		return FHttpPath(HttpPath);
-	}
+	public:
+		explicit FRouteQueuedWork(TUniqueFunction<void()>&& InWork)
+			: Work(MoveTemp(InWork))
+		{
+		}
+
+		virtual void DoThreadedWork() override
+		{
+			Work();
+			delete this;
+		}
+
+		virtual void Abandon() override
+		{
+			delete this;
+		}
+
+	private:
+		TUniqueFunction<void()> Work;
+	};
 
 	FString NormalizeHttpPath(FString InPath)
 	{
@@ -38,12 +87,258 @@ namespace
 		return InPath;
 	}
 
-	bool VerbsMatch(ENativeHttpServerRequestVerbs AllowedVerbs, EHttpServerRequestVerbs RequestVerb)
+	// Same normalization as NormalizeHttpPath, but without allocation
+	FStringView GetRequestPathView(const FHttpServerRequest& Request)
+	{
+		FStringView Path = Request.RelativePath.GetPath();
+		while (Path.Len() > 1 && Path[Path.Len() - 1] == TEXT('/'))
+		{
+			Path.LeftChopInline(1);
+		}
+
+		return Path.IsEmpty() ? FStringView(TEXT("/")) : Path;
+	}
+
+	void CollectParamNames(FSimpleHttpRoute& Route)
+	{
+		const FStringView Path = Route.Path;
+		for (int32 Pos = 0; Pos < Path.Len(); ++Pos)
+		{
+			const bool bSegmentStart = Pos == 0 || Path[Pos - 1] == TEXT('/');
+			if (!bSegmentStart || (Path[Pos] != TEXT(':') && Path[Pos] != TEXT('*')))
+			{
+				continue;
+			}
+
+			int32 End = Pos + 1;
+			while (End < Path.Len() && Path[End] != TEXT('/'))
+			{
+				++End;
+			}
+
+			Route.ParamNames.Add(Path.Mid(Pos + 1, End - Pos - 1));
+			Pos = End;
+		}
+	}
+
+	// Smaller bodies are hashed on the game thread, a task hop costs more than hashing them
+	constexpr int32 InlineHashMaxSize = 16 * 1024;
+
+	// ETag, cache store and 304 of successful GET responses
+	struct FGetResponseFinisher
+	{
+		TWeakPtr<FHttpResponseCache> Cache;
+		FString CacheKey;
+		FString RequestPath;
+		float TtlSeconds = 0.0f;
+		FHttpConditionalRequest ConditionalRequest;
+		bool bGenerateETag = false;
+		FName Encoding;
+		int32 CompressionMinSize = 0;
+		uint64 RequestId = 0;
+
+		// Next step on the game thread, compresses if Encoding is set
+		FHttpResultCallback OnComplete;
+
+		// Client, used when the worker has compressed already
+		FHttpResultCallback SendOnComplete;
+
+		void operator()(TUniquePtr<FHttpServerResponse>&& Response) const
+		{
+			if (!Response.IsValid() || Response->Code != EHttpServerResponseCodes::Ok)
+			{
+				OnComplete(MoveTemp(Response));
+				return;
+			}
+
+			const bool bCompress = !Encoding.IsNone() && FHttpResponseCompression::ShouldCompress(*Response, CompressionMinSize);
+			if (Response->Body.Num() <= InlineHashMaxSize && !bCompress)
+			{
+				TSharedPtr<const FHttpCachedResponse> CachedResponse;
+				Finish(Response, CachedResponse);
+				OnComplete(MoveTemp(Response));
+				return;
+			}
+
+			// Hashing and compression share one worker hop
+			AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Finisher = *this, Response = MoveTemp(Response)]() mutable
+			{
+				TSharedPtr<const FHttpCachedResponse> CachedResponse;
+				if (Finisher.Finish(Response, CachedResponse) && !Finisher.Encoding.IsNone() && FHttpResponseCompression::ShouldCompress(*Response, Finisher.CompressionMinSize))
+				{
+					SIMPLEHTTPSERVER_TRACE_STAGE_SCOPE(Finisher.RequestId, Compress);
+					Finisher.Compress(*Response, CachedResponse);
+				}
+
+				FHttpRouteCompletion::CompleteOnGameThread(Finisher.SendOnComplete, MoveTemp(Response));
+			});
+		}
+
+		// False if response was turned into 304
+		bool Finish(TUniquePtr<FHttpServerResponse>& Response, TSharedPtr<const FHttpCachedResponse>& OutCachedResponse) const
+		{
+			if (bGenerateETag)
+			{
+				FHttpConditionalRequest::AddETagIfMissing(*Response);
+			}
+
+			if (TSharedPtr<FHttpResponseCache> PinnedCache = Cache.Pin())
+			{
+				OutCachedResponse = PinnedCache->Store(CacheKey, RequestPath, *Response, TtlSeconds);
+			}
+
+			if (ConditionalRequest.IsNotModified(Response->Headers))
+			{
+				Response = FHttpConditionalRequest::MakeNotModified(Response->Headers);
+				return false;
+			}
+
+			return true;
+		}
+
+		// Encoded body of a cached response is kept, so cache hits don't compress it again
+		void Compress(FHttpServerResponse& Response, const TSharedPtr<const FHttpCachedResponse>& CachedResponse) const
+		{
+			TSharedPtr<FHttpResponseCache> PinnedCache = Cache.Pin();
+			if (!CachedResponse.IsValid() || !PinnedCache.IsValid())
+			{
+				FHttpResponseCompression::Compress(Response, Encoding);
+				return;
+			}
+
+			// Empty encoded body means compression didn't help, same as for cache hits
+			TSharedRef<TArray<uint8>> EncodedBody = MakeShared<TArray<uint8>>();
+			if (FHttpResponseCompression::CompressBody(Response.Body, Encoding, *EncodedBody))
+			{
+				Response.Body = *EncodedBody;
+				FHttpResponseCompression::SetEncodingHeaders(Response, Encoding);
+			}
+
+			PinnedCache->StoreEncodedBody(CachedResponse->ContentVersion, Encoding, EncodedBody);
+		}
+	};
+}
+
+namespace
+{
+	// Null and error message if body isn't a valid document of Struct
+	TSharedPtr<const FStructOnScope> ParseRequestBody(const UScriptStruct* Struct, EHttpWireFormat Format, TArrayView<const uint8> Body, FString& OutError)
+	{
+		TSharedRef<FStructOnScope> Value = MakeShared<FStructOnScope>(Struct);
+		if (!FHttpStructSerializer::ReadStruct(Body, Format, Struct, Value->GetStructMemory(), &OutError))
+		{
+			return nullptr;
+		}
+
+		return Value;
+	}
+
+	// Text formats get charset, binary ones are sent as is
+	void SetWireContentType(FHttpResponseBuilder& Builder, EHttpWireFormat Format)
+	{
+		if (Format == EHttpWireFormat::Json)
+		{
+			Builder.SetTextContentType(FHttpStructSerializer::GetContentType(Format));
+		}
+		else
+		{
+			Builder.SetHeader(TEXT("content-type"), FHttpStructSerializer::GetContentType(Format));
+		}
+	}
+
+	TUniquePtr<FHttpServerResponse> MakeInvalidBodyResponse(const FString& Error)
+	{
+		return FHttpServerResponse::Error(EHttpServerResponseCodes::BadRequest, TEXT("invalid_body"), Error);
+	}
+
+	// Match values point into the request path and names into the trie, copy them for requests outliving both
+	TMap<FString, FString> CopyPathParams(const FHttpRouteMatch& Match)
+	{
+		TMap<FString, FString> PathParams;
+		PathParams.Reserve(Match.Params.Num());
+		for (const TPair<FStringView, FStringView>& Param : Match.Params)
+		{
+			PathParams.Add(FString(Param.Key), FString(Param.Value));
+		}
+
+		return PathParams;
+	}
+
+	// Game thread work calling blueprint route
+	TUniqueFunction<void()> MakeDelegateWork(const FHttpServerRequestDelegate& Delegate, FNativeHttpServerRequest&& NativeHttpServerRequest, const FHttpHandlerTiming& Timing, const FHttpResultCallback& OnComplete)
+	{
+		return [Delegate, NativeHttpServerRequest = MoveTemp(NativeHttpServerRequest), Timing, OnComplete]()
+		{
+			// Bound object could be destroyed while request was waiting in the queue
+			if (!Delegate.IsBound())
+			{
+				OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::NotFound));
+				return;
+			}
+
+			FNativeHttpServerResponse HttpServerResponse;
+			{
+				SIMPLEHTTPSERVER_TRACE_STAGE_SCOPE(Timing.RequestId, Execute);
+				FHttpHandlerScope HandlerScope(Timing);
+				HttpServerResponse = Delegate.Execute(NativeHttpServerRequest);
+			}
+
+			OnComplete(MakeUnique<FHttpServerResponse>(MoveTemp(HttpServerResponse.HttpServerResponse)));
+		};
+	}
+}
+
+const FString& FNativeHttpServerRequestBody::GetString()
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (!String.IsSet())
+	{
+		FUTF8ToTCHAR BodyTCHARData(reinterpret_cast<const ANSICHAR*>(Bytes.GetData()), Bytes.Num());
+		String.Emplace(BodyTCHARData.Length(), BodyTCHARData.Get());
+	}
+
+	return String.GetValue();
+}
+
+TSharedPtr<FJsonObject> FNativeHttpServerRequestBody::GetJsonObject(const FString& BodyString)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (!bJsonParsed)
+	{
+		bJsonParsed = true;
+
+		TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(BodyString);
+		if (!FJsonSerializer::Deserialize(JsonReader, JsonObject))
+		{
+			JsonObject.Reset();
+		}
+	}
+
+	return JsonObject;
+}
+
+TArrayView<const uint8> FNativeHttpServerRequest::GetBodyBytes() const
+{
+	return RawBody.IsValid() ? TArrayView<const uint8>(RawBody->Bytes) : TArrayView<const uint8>();
+}
+
+const FString& FNativeHttpServerRequest::GetBodyString() const
+{
+	static const FString EmptyBody;
+	if (bBodyDecoded)
 	{
-		const uint8 AllowedMask = static_cast<uint8>(AllowedVerbs);
-		const uint8 RequestMask = static_cast<uint8>((ENativeHttpServerRequestVerbs)RequestVerb);
-		return (AllowedMask & RequestMask) != 0;
+		return Body;
 	}
+
+	return RawBody.IsValid() ? RawBody->GetString() : EmptyBody;
+}
+
+TSharedPtr<FJsonObject> FNativeHttpServerRequest::GetBodyJson() const
+{
+	// Reuse decoded string, so body is converted only once
+	return RawBody.IsValid() ? RawBody->GetJsonObject(GetBodyString()) : nullptr;
 }
 
 void USimpleHttpServer::BeginDestroy()
@@ -51,6 +346,16 @@ void USimpleHttpServer::BeginDestroy()
 	Super::BeginDestroy();
 
 	StopServer();
+	StopTrafficRecording();
+
+	FScopeLock ScopeLock(&RouteThreadPoolLock);
+	if (RouteThreadPool)
+	{
+		// Queued handlers are released without running, their completions answer 500. Running ones are waited for.
+		RouteThreadPool->Destroy();
+		delete RouteThreadPool;
+		RouteThreadPool = nullptr;
+	}
 }
 
 void USimpleHttpServer::StartServer(int32 ServerPort)
@@ -69,11 +374,32 @@ void USimpleHttpServer::StartServer(int32 ServerPort)
 
 	if (HttpRouter.IsValid())
 	{
+		// Dedicated servers can record without Blueprint changes
+		FString RecordingFilename;
+		if (!TrafficRecorder.IsValid() && FParse::Value(FCommandLine::Get(), TEXT("SimpleHttpRecord="), RecordingFilename))
+		{
+			StartTrafficRecording(RecordingFilename);
+		}
+
 		BindRoutes();
 
+		// All requests go through the plugin router first. Unmatched requests are left to HTTPServer module.
+		if (!bRequestPreprocessorRegistered)
+		{
+			RequestPreprocessorHandle = HttpRouter->RegisterRequestPreprocessor(FHttpRequestHandler::CreateUObject(this, &USimpleHttpServer::DispatchRequest));
+			bRequestPreprocessorRegistered = true;
+		}
+
+		if (!TickHandle.IsValid())
+		{
+			TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &USimpleHttpServer::Tick));
+		}
+
 		HttpServerModule.StartAllListeners();
 
 		bServerStarted = true;
+
+		StartStreamServer();
 		UE_LOG(LogSimpleHttpServer, Log, TEXT("Web server started on port = %d"), CurrentServerPort);
 	}
 	else
@@ -90,263 +416,991 @@ void USimpleHttpServer::StopServer()
 	FHttpServerModule& httpServerModule = FHttpServerModule::Get();
 	httpServerModule.StopAllListeners();
 
-	if (HttpRouter.IsValid())
+	if (TickHandle.IsValid())
 	{
-		if (bRootPreprocessorRegistered)
-		{
-			HttpRouter->UnregisterRequestPreprocessor(RootRequestPreprocessorHandle);
-			bRootPreprocessorRegistered = false;
-		}
-
-		// Editor will crash after receive request if you start game from editor, close it and start again.
-		// It is because HttpRouter lived in FHttpServerModule and don't be destroyed on game ending.
-		// When server stopped or being destroyed we must unbind all handlers to prevent errors on the next game start.
-		for (FHttpRouteHandle HttpRouteHandle : CreatedRouteHandlers)
-		{
-			HttpRouter->UnbindRoute(HttpRouteHandle);
-		}
+		FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+		TickHandle.Reset();
 	}
-}
 
-void USimpleHttpServer::BindRoute(FString HttpPath, ENativeHttpServerRequestVerbs Verbs, FHttpServerRequestDelegate OnHttpServerRequest)
-{
-	const FString NormalizedPath = NormalizeHttpPath(HttpPath);
-	RouteDelegates.Add(NormalizedPath, OnHttpServerRequest);
-	if (ENativeHttpServerRequestVerbs* ExistingVerbs = RouteVerbs.Find(NormalizedPath))
+	// Stream server thread can queue requests too, stop it before clearing the queue
+	if (StreamServer.IsValid())
 	{
-		*ExistingVerbs = (ENativeHttpServerRequestVerbs)((uint8)(*ExistingVerbs) | (uint8)Verbs);
+		StreamServer->Stop();
+		StreamServer.Reset();
 	}
-	else
+
+	// Connections of queued requests are gone with the listeners
+	GameThreadQueue.Empty();
+	GameThreadQueueDepth = 0;
+	GameThreadDequeued = 0;
+	GameThreadDeferredUpTo = 0;
+
+	// Editor will crash after receive request if you start game from editor, close it and start again.
+	// It is because HttpRouter lived in FHttpServerModule and don't be destroyed on game ending.
+	// When server stopped or being destroyed we must unbind preprocessor to prevent errors on the next game start.
+	if (HttpRouter.IsValid() && bRequestPreprocessorRegistered)
 	{
-		RouteVerbs.Add(NormalizedPath, Verbs);
+		HttpRouter->UnregisterRequestPreprocessor(RequestPreprocessorHandle);
 	}
+	bRequestPreprocessorRegistered = false;
 
-	if (HttpRouter.IsValid())
-	{
-		if (NormalizedPath == TEXT("/"))
-		{
-			if (!bRootPreprocessorRegistered)
-			{
-				RootRequestPreprocessorHandle = HttpRouter->RegisterRequestPreprocessor(
-					FHttpRequestHandler::CreateLambda([this](const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
-					{
-						if (!Request.RelativePath.IsRoot())
-						{
-							return false;
-						}
-
-						if (const ENativeHttpServerRequestVerbs* AllowedVerbs = RouteVerbs.Find(TEXT("/")))
-						{
-							if (!VerbsMatch(*AllowedVerbs, Request.Verb))
-							{
-								return false;
-							}
-						}
-
-						if (RouteDelegates.Contains(TEXT("/")))
-						{
-							return HandleRequest(TEXT("/"), Request, OnComplete);
-						}
-
-						if (RouteHandlers.Contains(TEXT("/")))
-						{
-							return HandleRequestNative(TEXT("/"), Request, OnComplete);
-						}
-
-						return false;
-					}));
-
-				bRootPreprocessorRegistered = true;
-			}
+	// Parked long-poll requests belong to stopped listeners
+	LongPollTopics.Reset();
 
-			return;
-		}
+	// Routes are bound again by BindRoutes on the next start
+	Routes.Reset();
+	RouteTrie.Reset();
 
-		const FHttpPath RoutePath = MakeHttpPathForRoute(NormalizedPath);
-		if (!RoutePath.IsValidPath())
-		{
-			UE_LOG(LogSimpleHttpServer, Error, TEXT("Invalid route path: '%s'. This route will not be bound."), *NormalizedPath);
-			return;
-		}
+	// Subscribers were disconnected with the stream server
+	EventStreams.Reset();
+	WebSockets.Reset();
+
+	FWriteScopeLock WriteLock(StreamRoutesLock);
+	StreamRoutes.Reset();
+	StreamRouteTrie.Reset();
+}
 
-		FHttpRouteHandle HttpRouteHandle = HttpRouter->BindRoute(RoutePath, (EHttpServerRequestVerbs)Verbs,
+void USimpleHttpServer::BindRoute(FString HttpPath, ENativeHttpServerRequestVerbs Verbs, FHttpServerRequestDelegate OnHttpServerRequest)
+{
+	FSimpleHttpRoute Route;
+	Route.Delegate = OnHttpServerRequest;
 
-		FHttpRequestHandler::CreateLambda([&, NormalizedPath](const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
-		{
-			return HandleRequest(NormalizedPath, Request, OnComplete);
-		}));
+	AddRoute(MoveTemp(HttpPath), Verbs, MoveTemp(Route));
+}
+
+void USimpleHttpServer::BindRouteNative(FString HttpPath, ENativeHttpServerRequestVerbs Verbs, FHttpRouteHandler Handler, EHttpRouteExecution Execution)
+{
+	FSimpleHttpRoute Route;
+	Route.Native.Handler = MoveTemp(Handler);
+	Route.Native.Execution = Execution;
+
+	AddRoute(MoveTemp(HttpPath), Verbs, MoveTemp(Route));
+}
+
+void USimpleHttpServer::BindStreamRoute(FString HttpPath, ENativeHttpServerRequestVerbs Verbs, FHttpStreamHandler Handler, EHttpRouteExecution Execution)
+{
+	FSimpleHttpRoute Route;
+	Route.Stream = MoveTemp(Handler);
+	Route.Native.Execution = Execution;
+
+	AddStreamRoute(MoveTemp(HttpPath), Verbs, MoveTemp(Route));
+}
 
+void USimpleHttpServer::BindEventStream(FString HttpPath)
+{
+	FSimpleHttpRoute Route;
+	Route.Path = NormalizeHttpPath(MoveTemp(HttpPath));
 
-		CreatedRouteHandlers.Add(HttpRouteHandle);
+	if (EventStreams.Contains(Route.Path))
+	{
+		UE_LOG(LogSimpleHttpServer, Warning, TEXT("Event stream '%s' is already bound."), *Route.Path);
+		return;
 	}
-	else
+
+	TSharedRef<FHttpEventStream> EventStream = MakeShared<FHttpEventStream>();
+	EventStreams.Add(Route.Path, EventStream);
+	Route.EventStream = EventStream;
+
+	const FString Path = Route.Path;
+	AddStreamRoute(Path, ENativeHttpServerRequestVerbs::GET, MoveTemp(Route));
+}
+
+void USimpleHttpServer::PublishEvent(FString HttpPath, FString EventName, FString Data)
+{
+	if (TSharedPtr<FHttpEventStream> EventStream = FindEventStream(MoveTemp(HttpPath)))
 	{
-		UE_LOG(LogSimpleHttpServer, Error, TEXT("Failed bind to HttpRouter: router is invalid"));
+		EventStream->Publish(EventName, Data);
 	}
 }
 
-void USimpleHttpServer::BindRouteNative(FString HttpPath, ENativeHttpServerRequestVerbs Verbs, FHttpRouteHandler Handler)
+int32 USimpleHttpServer::GetEventStreamSubscribers(FString HttpPath) const
+{
+	TSharedPtr<FHttpEventStream> EventStream = FindEventStream(MoveTemp(HttpPath));
+	return EventStream.IsValid() ? EventStream->GetNumSubscribers() : 0;
+}
+
+TSharedPtr<FHttpEventStream> USimpleHttpServer::FindEventStream(FString HttpPath) const
+{
+	const TSharedRef<FHttpEventStream>* EventStream = EventStreams.Find(NormalizeHttpPath(MoveTemp(HttpPath)));
+	return EventStream ? TSharedPtr<FHttpEventStream>(*EventStream) : nullptr;
+}
+
+void USimpleHttpServer::BindLongPoll(FString HttpPath)
 {
-	const FString NormalizedPath = NormalizeHttpPath(HttpPath);
-	RouteHandlers.Add(NormalizedPath, Handler);
-	if (ENativeHttpServerRequestVerbs* ExistingVerbs = RouteVerbs.Find(NormalizedPath))
+	const FString Path = NormalizeHttpPath(MoveTemp(HttpPath));
+
+	if (LongPollTopics.Contains(Path))
 	{
-		*ExistingVerbs = (ENativeHttpServerRequestVerbs)((uint8)(*ExistingVerbs) | (uint8)Verbs);
+		UE_LOG(LogSimpleHttpServer, Warning, TEXT("Long-poll route '%s' is already bound."), *Path);
+		return;
 	}
-	else
+
+	TSharedRef<FHttpLongPollTopic> Topic = MakeShared<FHttpLongPollTopic>();
+	Topic->TimeoutSeconds = LongPollTimeoutSeconds;
+	LongPollTopics.Add(Path, Topic);
+
+	// Parking is a few instructions under a lock, no need to wait for the game thread queue
+	BindRouteNative(Path, ENativeHttpServerRequestVerbs::GET, [Topic](const FNativeHttpServerRequestView& Request, FHttpRouteCompletion Completion)
+	{
+		Topic->HandleRequest(Request, MoveTemp(Completion));
+	}, EHttpRouteExecution::TaskGraph);
+}
+
+void USimpleHttpServer::PublishLongPoll(FString HttpPath, FString Text, FString ContentType)
+{
+	if (TSharedPtr<FHttpLongPollTopic> Topic = FindLongPoll(MoveTemp(HttpPath)))
 	{
-		RouteVerbs.Add(NormalizedPath, Verbs);
+		Topic->Publish(Text, ContentType);
 	}
+}
 
-	if (HttpRouter.IsValid())
+TSharedPtr<FHttpLongPollTopic> USimpleHttpServer::FindLongPoll(FString HttpPath) const
+{
+	const TSharedRef<FHttpLongPollTopic>* Topic = LongPollTopics.Find(NormalizeHttpPath(MoveTemp(HttpPath)));
+	return Topic ? TSharedPtr<FHttpLongPollTopic>(*Topic) : nullptr;
+}
+
+void USimpleHttpServer::RegisterSnapshotActorTransforms(FName Name, TSubclassOf<AActor> ActorClass)
+{
+	TWeakObjectPtr<UClass> WeakActorClass = ActorClass.Get();
+
+	RegisterSnapshot<FHttpSnapshotActorTransforms>(Name, [this, WeakActorClass](FHttpSnapshotActorTransforms& OutValue)
 	{
-		if (NormalizedPath == TEXT("/"))
-		{
-			if (!bRootPreprocessorRegistered)
-			{
-				RootRequestPreprocessorHandle = HttpRouter->RegisterRequestPreprocessor(
-					FHttpRequestHandler::CreateLambda([this](const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
-					{
-						if (!Request.RelativePath.IsRoot())
-						{
-							return false;
-						}
-
-						if (const ENativeHttpServerRequestVerbs* AllowedVerbs = RouteVerbs.Find(TEXT("/")))
-						{
-							if (!VerbsMatch(*AllowedVerbs, Request.Verb))
-							{
-								return false;
-							}
-						}
-
-						if (RouteDelegates.Contains(TEXT("/")))
-						{
-							return HandleRequest(TEXT("/"), Request, OnComplete);
-						}
-
-						if (RouteHandlers.Contains(TEXT("/")))
-						{
-							return HandleRequestNative(TEXT("/"), Request, OnComplete);
-						}
-
-						return false;
-					}));
-
-				bRootPreprocessorRegistered = true;
-			}
+		OutValue.Actors.Reset();
 
+		UWorld* World = GetWorld();
+		UClass* Class = WeakActorClass.Get();
+		if (!World || !Class)
+		{
 			return;
 		}
 
-		const FHttpPath RoutePath = MakeHttpPathForRoute(NormalizedPath);
-		if (!RoutePath.IsValidPath())
+		for (TActorIterator<AActor> It(World, Class); It; ++It)
 		{
-			UE_LOG(LogSimpleHttpServer, Error, TEXT("Invalid route path: '%s'. This route will not be bound."), *NormalizedPath);
-			return;
+			FHttpSnapshotActorTransform& Actor = OutValue.Actors.AddDefaulted_GetRef();
+			Actor.Name = It->GetName();
+			Actor.Transform = It->GetActorTransform();
 		}
+	});
+}
 
-		FHttpRouteHandle HttpRouteHandle = HttpRouter->BindRoute(RoutePath, (EHttpServerRequestVerbs)Verbs,
+void USimpleHttpServer::UnregisterSnapshot(FName Name)
+{
+	SnapshotPublisher.Unregister(Name);
+}
 
-		FHttpRequestHandler::CreateLambda([&, NormalizedPath](const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+void USimpleHttpServer::BindWebSocket(FString HttpPath, FHttpWebSocketMessageDelegate OnMessage)
+{
+	BindWebSocketNative(MoveTemp(HttpPath), [OnMessage](const TSharedRef<FHttpWebSocketChannel>& Channel, const FHttpWebSocketMessage& Message)
+	{
+		if (!Message.bBinary && OnMessage.IsBound())
 		{
-			return HandleRequestNative(NormalizedPath, Request, OnComplete);
-		}));
+			OnMessage.Execute((int32)Message.ClientId, Message.GetText());
+		}
+	});
+}
 
+void USimpleHttpServer::BindWebSocketNative(FString HttpPath, FHttpWebSocketHandler Handler, EHttpRouteExecution Execution)
+{
+	FSimpleHttpRoute Route;
+	Route.Path = NormalizeHttpPath(MoveTemp(HttpPath));
 
-		CreatedRouteHandlers.Add(HttpRouteHandle);
-	}
-	else
+	if (WebSockets.Contains(Route.Path))
 	{
-		UE_LOG(LogSimpleHttpServer, Error, TEXT("Failed bind to HttpRouter: router is invalid"));
+		UE_LOG(LogSimpleHttpServer, Warning, TEXT("WebSocket '%s' is already bound."), *Route.Path);
+		return;
 	}
-}
 
-bool USimpleHttpServer::HandleRequest(FString HttpPath, const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
-{
-	FNativeHttpServerRequest NativeHttpServerRequest;
-	FillNativeRequst(Request, NativeHttpServerRequest);
+	TSharedRef<FHttpWebSocketChannel> Channel = MakeShared<FHttpWebSocketChannel>();
+	Channel->MaxQueuedBytes = WebSocketMaxQueuedBytes;
+	Channel->DropPolicy = WebSocketDropPolicy;
 
-	if (FHttpServerRequestDelegate* HttpServerRequestDelegate = RouteDelegates.Find(HttpPath))
+	// Messages arrive on the stream server thread, run handler where it asked for
+	TWeakPtr<FHttpWebSocketChannel> WeakChannel = Channel;
+	Channel->OnMessage = [this, WeakChannel, Handler = MoveTemp(Handler), Execution](FHttpWebSocketMessage&& Message)
 	{
-		if ((*HttpServerRequestDelegate).IsBound())
+		ExecuteRoute(Execution, [WeakChannel, Handler, Message = MoveTemp(Message)]()
 		{
-			FNativeHttpServerResponse HttpServerResponse = (*HttpServerRequestDelegate).Execute(NativeHttpServerRequest);
-			TUniquePtr<FHttpServerResponse> Response = MakeUnique<FHttpServerResponse>();
-			Response->Body = HttpServerResponse.HttpServerResponse.Body;
-			Response->Code = HttpServerResponse.HttpServerResponse.Code;
-			Response->Headers = HttpServerResponse.HttpServerResponse.Headers;
-			Response->HttpVersion = HttpServerResponse.HttpServerResponse.HttpVersion;
+			if (TSharedPtr<FHttpWebSocketChannel> PinnedChannel = WeakChannel.Pin())
+			{
+				Handler(PinnedChannel.ToSharedRef(), Message);
+			}
+		});
+	};
 
-			OnComplete(MoveTemp(Response));
-			return true;
-		}
-	}
+	WebSockets.Add(Route.Path, Channel);
+	Route.WebSocket = Channel;
 
-	TUniquePtr<FHttpServerResponse> response = FHttpServerResponse::Error(EHttpServerResponseCodes::NotFound);
-	OnComplete(MoveTemp(response));
-	return true;
+	const FString Path = Route.Path;
+	AddStreamRoute(Path, ENativeHttpServerRequestVerbs::GET, MoveTemp(Route));
 }
 
-bool USimpleHttpServer::HandleRequestNative(FString HttpPath, const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+int32 USimpleHttpServer::BroadcastWebSocketMessage(FString HttpPath, FString Message)
 {
-	FNativeHttpServerRequest NativeHttpServerRequest;
-	FillNativeRequst(Request, NativeHttpServerRequest);
+	TSharedPtr<FHttpWebSocketChannel> Channel = FindWebSocket(MoveTemp(HttpPath));
+	return Channel.IsValid() ? Channel->Broadcast(Message) : 0;
+}
 
-	if (FHttpRouteHandler* HttpServerRequestDelegate = RouteHandlers.Find(HttpPath))
-	{
-		(*HttpServerRequestDelegate)(NativeHttpServerRequest);
-		return true;
-	}
+bool USimpleHttpServer::SendWebSocketMessage(FString HttpPath, int32 ClientId, FString Message)
+{
+	TSharedPtr<FHttpWebSocketChannel> Channel = FindWebSocket(MoveTemp(HttpPath));
+	return Channel.IsValid() && Channel->Send((uint32)ClientId, Message);
+}
 
-	TUniquePtr<FHttpServerResponse> response = FHttpServerResponse::Error(EHttpServerResponseCodes::NotFound);
-	OnComplete(MoveTemp(response));
-	return true;
+int32 USimpleHttpServer::GetWebSocketClients(FString HttpPath) const
+{
+	TSharedPtr<FHttpWebSocketChannel> Channel = FindWebSocket(MoveTemp(HttpPath));
+	return Channel.IsValid() ? Channel->GetNumClients() : 0;
 }
 
-void USimpleHttpServer::FillNativeRequst(const FHttpServerRequest& Request, FNativeHttpServerRequest& NativeRequest)
+TSharedPtr<FHttpWebSocketChannel> USimpleHttpServer::FindWebSocket(FString HttpPath) const
 {
-	NativeRequest.Verb = (ENativeHttpServerRequestVerbs)Request.Verb;
-	NativeRequest.RelativePath = *Request.RelativePath.GetPath();
+	const TSharedRef<FHttpWebSocketChannel>* Channel = WebSockets.Find(NormalizeHttpPath(MoveTemp(HttpPath)));
+	return Channel ? TSharedPtr<FHttpWebSocketChannel>(*Channel) : nullptr;
+}
+
+void USimpleHttpServer::AddStreamRoute(FString HttpPath, ENativeHttpServerRequestVerbs Verbs, FSimpleHttpRoute&& Route)
+{
+	Route.Path = NormalizeHttpPath(MoveTemp(HttpPath));
+
+	TSharedRef<FSimpleHttpRoute> SharedRoute = MakeShared<FSimpleHttpRoute>(MoveTemp(Route));
+	CollectParamNames(*SharedRoute);
 
-	for (const auto& Header : Request.Headers)
 	{
-		FString StrHeaderVals;
-		for (const auto& val : Header.Value)
+		FWriteScopeLock WriteLock(StreamRoutesLock);
+
+		if (!StreamRouteTrie.Insert(SharedRoute->Path, (uint8)Verbs, StreamRoutes.Num()))
 		{
-			StrHeaderVals += val + TEXT(" ");
+			UE_LOG(LogSimpleHttpServer, Error, TEXT("Invalid route path: '%s'. This route will not be bound."), *SharedRoute->Path);
+			return;
 		}
 
-		NativeRequest.Headers.Add(Header.Key, StrHeaderVals);
+		StreamRoutes.Add(SharedRoute);
 	}
 
-	NativeRequest.PathParams = Request.PathParams;
-	NativeRequest.QueryParams = Request.QueryParams;
-
-
-	// Convert UTF8 to FString
-	FUTF8ToTCHAR BodyTCHARData(reinterpret_cast<const ANSICHAR*>(Request.Body.GetData()), Request.Body.Num());
-	FString StrBodyData{ BodyTCHARData.Length(), BodyTCHARData.Get() };
-
-	NativeRequest.Body = *StrBodyData;
+	// Route bound after start
+	if (bServerStarted)
+	{
+		StartStreamServer();
+	}
 }
 
-FNativeHttpServerResponse USimpleHttpServer::MakeResponse(FString Text, FString ContentType, int32 Code)
+int32 USimpleHttpServer::GetStreamServerPort() const
 {
+	return StreamServer.IsValid() && StreamServer->IsRunning() ? StreamServer->GetPort() : 0;
+}
+
+void USimpleHttpServer::StartStreamServer()
+{
+	if (StreamServer.IsValid() || StreamRoutes.Num() == 0)
+	{
+		return;
+	}
+
+	// Server thread calls back into this object, it is stopped in StopServer before the object goes away
+	StreamServer = MakeUnique<FHttpStreamServer>([this](const TSharedRef<FHttpStreamConnection>& Connection, const FHttpServerRequest& Request)
+	{
+		return DispatchStreamRequest(Connection, Request);
+	});
+
+	if (!StreamServer->Start(StreamBindAddress, StreamPort > 0 ? StreamPort : CurrentServerPort + 1))
+	{
+		StreamServer.Reset();
+	}
+}
+
+void USimpleHttpServer::ServeDirectory(FString UrlPrefix, FString DiskPath, int32 MaxAgeSeconds, bool bStreamLargeFiles)
+{
+	TSharedRef<FHttpStaticDirectory> StaticDirectory = MakeShared<FHttpStaticDirectory>(MoveTemp(DiskPath), ResponseCache);
+	StaticDirectory->MaxAgeSeconds = MaxAgeSeconds;
+	StaticDirectory->bCompress = bEnableCompression;
+	StaticDirectory->CompressionMinSize = CompressionMinSize;
+
+	const FString Prefix = NormalizeHttpPath(MoveTemp(UrlPrefix));
+	const FString FilesPath = Prefix == TEXT("/") ? TEXT("/*path") : Prefix + TEXT("/*path");
+
+	FHttpRouteHandler Handler = [StaticDirectory](const FNativeHttpServerRequestView& Request, FHttpRouteCompletion Completion)
+	{
+		StaticDirectory->HandleRequest(Request, MoveTemp(Completion));
+	};
+
+	BindRouteNative(FilesPath, ENativeHttpServerRequestVerbs::GET, Handler, EHttpRouteExecution::ThreadPool);
+
+	// Directory compresses files itself and keeps encodings per file version
+	SetRouteCompressionEnabled(FilesPath, false);
+
+	if (Prefix != TEXT("/"))
+	{
+		BindRouteNative(Prefix, ENativeHttpServerRequestVerbs::GET, Handler, EHttpRouteExecution::ThreadPool);
+		SetRouteCompressionEnabled(Prefix, false);
+	}
+
+	if (bStreamLargeFiles)
+	{
+		// Same port StartStreamServer listens on
+		StaticDirectory->StreamPort = StreamPort > 0 ? StreamPort : CurrentServerPort + 1;
+
+		// Redirects never take the host from the request, unless it is one of the allowed names
+		if (!StreamPublicUrl.IsEmpty())
+		{
+			StaticDirectory->StreamBaseUrl = StreamPublicUrl;
+			StaticDirectory->StreamBaseUrl.RemoveFromEnd(TEXT("/"));
+		}
+		else if (StreamBindAddress != TEXT("0.0.0.0"))
+		{
+			StaticDirectory->StreamBaseUrl = FString::Printf(TEXT("http://%s:%d"), *StreamBindAddress, StaticDirectory->StreamPort);
+		}
+
+		StaticDirectory->StreamAllowedHosts = StreamAllowedHosts;
+
+		FHttpStreamHandler StreamHandler = [StaticDirectory](const FNativeHttpServerRequestView& Request, FHttpStreamWriter Writer)
+		{
+			StaticDirectory->HandleStreamRequest(Request, MoveTemp(Writer));
+		};
+
+		BindStreamRoute(FilesPath, ENativeHttpServerRequestVerbs::GET, StreamHandler, EHttpRouteExecution::TaskGraph);
+		if (Prefix != TEXT("/"))
+		{
+			BindStreamRoute(Prefix, ENativeHttpServerRequestVerbs::GET, StreamHandler, EHttpRouteExecution::TaskGraph);
+		}
+	}
+}
+
+void USimpleHttpServer::AddRoute(FString HttpPath, ENativeHttpServerRequestVerbs Verbs, FSimpleHttpRoute&& Route)
+{
+	Route.Path = NormalizeHttpPath(MoveTemp(HttpPath));
+
+	if (!RouteTrie.Insert(Route.Path, (uint8)Verbs, Routes.Num()))
+	{
+		UE_LOG(LogSimpleHttpServer, Error, TEXT("Invalid route path: '%s'. This route will not be bound."), *Route.Path);
+		return;
+	}
+
+	Route.MetricsId = Metrics->RegisterRoute(Route.Path);
+
+	TSharedRef<FSimpleHttpRoute> SharedRoute = MakeShared<FSimpleHttpRoute>(MoveTemp(Route));
+	CollectParamNames(*SharedRoute);
+
+	Routes.Add(SharedRoute);
+}
+
+bool USimpleHttpServer::DispatchRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+{
+	const uint64 RequestId = ++LastRequestId;
+	SIMPLEHTTPSERVER_TRACE_STAGE_SCOPE(RequestId, Receive);
+
+	// Unmatched requests are recorded too, they are part of the load
+	if (TrafficRecorder.IsValid())
+	{
+		TrafficRecorder->Record(Request);
+	}
+
+	FHttpRouteMatch Match;
+	{
+		SIMPLEHTTPSERVER_TRACE_SCOPE(RouteMatch);
+		if (!RouteTrie.Find(GetRequestPathView(Request), (uint8)Request.Verb, Match))
+		{
+			// Someone else could bind routes on this port, let HTTPServer module handle it
+			return false;
+		}
+	}
+
+	const TSharedRef<const FSimpleHttpRoute>& Route = Routes[Match.RouteIndex];
+	SIMPLEHTTPSERVER_TRACE_ROUTE(RequestId, Route->Path);
+
+	++RequestsThisFrame;
+
+	// Counted when response is handed to the client, so cache hits are included
+	FHttpResultCallback SendOnComplete = bRecordMetrics && Route->MetricsId != INDEX_NONE
+		? FHttpServerMetrics::MakeRecordingCallback(Metrics, Route->MetricsId, Request.Body.Num(), FHttpResultCallback(OnComplete))
+		: OnComplete;
+	SIMPLEHTTPSERVER_TRACE_CALLBACK(RequestId, Send, SendOnComplete);
+
+	FHttpResultCallback RouteOnComplete = SendOnComplete;
+
+	// Compression is the last step before the client
+	const FName Encoding = bEnableCompression && !CompressionDisabledRoutes.Contains(Route->Path) ? FHttpResponseCompression::NegotiateEncoding(Request) : NAME_None;
+	if (!Encoding.IsNone())
+	{
+		RouteOnComplete = FHttpResponseCompression::MakeCompressingCallback(Encoding, CompressionMinSize, MoveTemp(RouteOnComplete));
+		SIMPLEHTTPSERVER_TRACE_CALLBACK(RequestId, Compress, RouteOnComplete);
+	}
+
+	if (Request.Verb == EHttpServerRequestVerbs::VERB_GET)
+	{
+		const FHttpResultCallback ClientOnComplete = RouteOnComplete;
+
+		FHttpConditionalRequest ConditionalRequest(Request);
+
+		FString CacheKey;
+		const FHttpRouteCachePolicy* CachePolicy = CachePolicies.Num() > 0 ? CachePolicies.Find(Route->Path) : nullptr;
+		if (CachePolicy && CachePolicy->TtlSeconds > 0.0f)
+		{
+			CacheKey = FHttpResponseCache::MakeKey(Request, GetRequestPathView(Request), *CachePolicy);
+
+			if (TSharedPtr<const FHttpCachedResponse> CachedResponse = ResponseCache->Find(CacheKey))
+			{
+				// Unchanged resource skips both the handler and the body copy
+				if (ConditionalRequest.IsNotModified(CachedResponse->Headers))
+				{
+					SendOnComplete(FHttpConditionalRequest::MakeNotModified(CachedResponse->Headers));
+				}
+				else if (!Encoding.IsNone() && FHttpResponseCompression::ShouldCompress(CachedResponse->Headers, CachedResponse->Body.Num(), CompressionMinSize))
+				{
+					FHttpResponseCompression::CompleteFromCache(ResponseCache, CachedResponse.ToSharedRef(), Encoding, SendOnComplete);
+				}
+				else
+				{
+					SendOnComplete(CachedResponse->MakeResponse());
+				}
+
+				return true;
+			}
+		}
+
+		if (bGenerateETags || ConditionalRequest.IsConditional() || !CacheKey.IsEmpty())
+		{
+			// Add ETag, store response to cache and answer 304 if client copy is still valid
+			FGetResponseFinisher Finisher;
+			if (!CacheKey.IsEmpty())
+			{
+				Finisher.Cache = ResponseCache;
+				Finisher.CacheKey = MoveTemp(CacheKey);
+				Finisher.TtlSeconds = CachePolicy->TtlSeconds;
+			}
+			Finisher.RequestPath = FString(GetRequestPathView(Request));
+			Finisher.ConditionalRequest = MoveTemp(ConditionalRequest);
+			Finisher.bGenerateETag = bGenerateETags;
+			Finisher.Encoding = Encoding;
+			Finisher.CompressionMinSize = CompressionMinSize;
+			Finisher.RequestId = RequestId;
+			Finisher.OnComplete = ClientOnComplete;
+			Finisher.SendOnComplete = SendOnComplete;
+
+			RouteOnComplete = MoveTemp(Finisher);
+		}
+	}
+
+	const UScriptStruct* BodyStruct = nullptr;
+	if (RouteBodyStructs.Num() > 0)
+	{
+		if (const TObjectPtr<UScriptStruct>* FoundStruct = RouteBodyStructs.Find(Route->Path))
+		{
+			BodyStruct = *FoundStruct;
+		}
+	}
+
+	if (Route->Native.Handler)
+	{
+		return HandleRequestNative(Route, Request, Match, BodyStruct, RequestId, RouteOnComplete);
+	}
+
+	return HandleRequest(Route, Request, Match, BodyStruct, RequestId, RouteOnComplete);
+}
+
+bool USimpleHttpServer::DispatchStreamRequest(const TSharedRef<FHttpStreamConnection>& Connection, const FHttpServerRequest& Request)
+{
+	FHttpRouteMatch Match;
+	TSharedPtr<const FSimpleHttpRoute> Route;
+	{
+		FReadScopeLock ReadLock(StreamRoutesLock);
+		if (!StreamRouteTrie.Find(GetRequestPathView(Request), (uint8)Request.Verb, Match))
+		{
+			return false;
+		}
+
+		Route = StreamRoutes[Match.RouteIndex];
+	}
+
+	if (Route->EventStream.IsValid())
+	{
+		Route->EventStream->Subscribe(Connection);
+		return true;
+	}
+
+	if (Route->WebSocket.IsValid())
+	{
+		Route->WebSocket->Accept(Connection, Request);
+		return true;
+	}
+
+	FNativeHttpServerRequestView RequestView(Request, Match, Route.ToSharedRef());
+	FHttpStreamWriter Writer(Connection);
+
+	ExecuteRoute(Route->Native.Execution, [RequestView = MoveTemp(RequestView), Writer = MoveTemp(Writer)]()
+	{
+		RequestView.GetRoute().Stream(RequestView, Writer);
+	});
+
+	return true;
+}
+
+bool USimpleHttpServer::HandleRequest(const TSharedRef<const FSimpleHttpRoute>& Route, const FHttpServerRequest& Request, const FHttpRouteMatch& Match, const UScriptStruct* BodyStruct, uint64 RequestId, const FHttpResultCallback& OnComplete)
+{
+	if (!Route->Delegate.IsBound())
+	{
+		TUniquePtr<FHttpServerResponse> response = FHttpServerResponse::Error(EHttpServerResponseCodes::NotFound);
+		OnComplete(MoveTemp(response));
+		return true;
+	}
+
+	const FHttpHandlerTiming Timing = StartHandlerTiming(*Route, RequestId);
+
+	if (!BodyStruct)
+	{
+		FNativeHttpServerRequest NativeHttpServerRequest;
+		{
+			SIMPLEHTTPSERVER_TRACE_STAGE_SCOPE(RequestId, FillRequest);
+			FillNativeRequst(Request, Match, NativeHttpServerRequest);
+		}
+
+		EnqueueGameThreadRequest(MakeDelegateWork(Route->Delegate, MoveTemp(NativeHttpServerRequest), Timing, OnComplete));
+		return true;
+	}
+
+	// Only the request is copied here, its body bytes once. Headers are joined and the body parsed on a worker.
+	FHttpServerRequest RequestCopy = Request;
+	TArray<uint8> BodyBytes = MoveTemp(RequestCopy.Body);
+	TMap<FString, FString> PathParams = CopyPathParams(Match);
+
+	// Parse on a worker, so bad bodies never reach the game thread queue
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis = TWeakObjectPtr<USimpleHttpServer>(this), BodyStruct, Delegate = Route->Delegate, RequestCopy = MoveTemp(RequestCopy),
+		PathParams = MoveTemp(PathParams), BodyBytes = MoveTemp(BodyBytes), Timing, OnComplete]() mutable
+	{
+		// Struct routes read the parsed body, the string form is decoded only if the graph asks for it
+		FNativeHttpServerRequest NativeHttpServerRequest;
+		{
+			SIMPLEHTTPSERVER_TRACE_STAGE_SCOPE(Timing.RequestId, FillRequest);
+			FillNativeRequst(RequestCopy, MoveTemp(PathParams), MoveTemp(BodyBytes), false, NativeHttpServerRequest);
+		}
+
+		const EHttpWireFormat BodyFormat = FHttpStructSerializer::GetBodyFormat(RequestCopy);
+
+		FString Error;
+		NativeHttpServerRequest.ParsedBody = ParseRequestBody(BodyStruct, BodyFormat, NativeHttpServerRequest.GetBodyBytes(), Error);
+		if (!NativeHttpServerRequest.ParsedBody.IsValid())
+		{
+			FHttpRouteCompletion::CompleteOnGameThread(OnComplete, MakeInvalidBodyResponse(Error));
+			return;
+		}
+
+		USimpleHttpServer* Server = WeakThis.Get();
+		if (!Server)
+		{
+			FHttpRouteCompletion::CompleteOnGameThread(OnComplete, FHttpServerResponse::Error(EHttpServerResponseCodes::NotFound));
+			return;
+		}
+
+		Server->EnqueueGameThreadRequest(MakeDelegateWork(Delegate, MoveTemp(NativeHttpServerRequest), Timing, OnComplete));
+	});
+
+	return true;
+}
+
+bool USimpleHttpServer::HandleRequestNative(const TSharedRef<const FSimpleHttpRoute>& Route, const FHttpServerRequest& Request, const FHttpRouteMatch& Match, const UScriptStruct* BodyStruct, uint64 RequestId, const FHttpResultCallback& OnComplete)
+{
+	const FHttpHandlerTiming Timing = StartHandlerTiming(*Route, RequestId);
+
+	FNativeHttpServerRequestView RequestView(Request, Match, Route);
+	FHttpRouteCompletion Completion(OnComplete);
+
+	if (!BodyStruct)
+	{
+		ExecuteRoute(Route->Native.Execution, [RequestView = MoveTemp(RequestView), Timing, Completion]()
+		{
+			SIMPLEHTTPSERVER_TRACE_STAGE_SCOPE(Timing.RequestId, Execute);
+			FHttpHandlerScope HandlerScope(Timing);
+			RequestView.GetRoute().Native.Handler(RequestView, Completion);
+		});
+
+		return true;
+	}
+
+	const EHttpRouteExecution Execution = Route->Native.Execution;
+
+	// Worker routes parse right before the handler, game thread routes get a worker hop for parsing
+	const EHttpRouteExecution ParseExecution = Execution == EHttpRouteExecution::GameThread ? EHttpRouteExecution::TaskGraph : Execution;
+	ExecuteRoute(ParseExecution, [WeakThis = TWeakObjectPtr<USimpleHttpServer>(this), BodyStruct, Execution, RequestView = MoveTemp(RequestView), Timing, Completion]() mutable
+	{
+		FString Error;
+		RequestView.ParsedBody = ParseRequestBody(BodyStruct, FHttpStructSerializer::GetBodyFormat(RequestView.GetRequest()), RequestView.GetBody(), Error);
+		if (!RequestView.ParsedBody.IsValid())
+		{
+			Completion.Complete(MakeInvalidBodyResponse(Error));
+			return;
+		}
+
+		if (Execution != EHttpRouteExecution::GameThread)
+		{
+			SIMPLEHTTPSERVER_TRACE_STAGE_SCOPE(Timing.RequestId, Execute);
+			FHttpHandlerScope HandlerScope(Timing);
+			RequestView.GetRoute().Native.Handler(RequestView, Completion);
+			return;
+		}
+
+		// Unanswered completion sends 500 if the server is gone
+		if (USimpleHttpServer* Server = WeakThis.Get())
+		{
+			Server->EnqueueGameThreadRequest([RequestView = MoveTemp(RequestView), Timing, Completion]()
+			{
+				SIMPLEHTTPSERVER_TRACE_STAGE_SCOPE(Timing.RequestId, Execute);
+				FHttpHandlerScope HandlerScope(Timing);
+				RequestView.GetRoute().Native.Handler(RequestView, Completion);
+			});
+		}
+	});
+
+	return true;
+}
+
+FHttpHandlerTiming USimpleHttpServer::StartHandlerTiming(const FSimpleHttpRoute& Route, uint64 RequestId) const
+{
+	if (!bRecordMetrics || Route.MetricsId == INDEX_NONE)
+	{
+		return FHttpHandlerTiming(RequestId);
+	}
+
+	return FHttpHandlerTiming(Metrics, Route.MetricsId, RequestId);
+}
+
+void USimpleHttpServer::ExecuteRoute(EHttpRouteExecution Execution, TUniqueFunction<void()>&& Work)
+{
+	switch (Execution)
+	{
+	case EHttpRouteExecution::TaskGraph:
+		AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, MoveTemp(Work));
+		break;
+
+	case EHttpRouteExecution::ThreadPool:
+	{
+		FScopeLock ScopeLock(&RouteThreadPoolLock);
+
+		if (!RouteThreadPool)
+		{
+			RouteThreadPool = FQueuedThreadPool::Allocate();
+			RouteThreadPool->Create(FMath::Max(ThreadPoolSize, 1), 128 * 1024, TPri_Normal, TEXT("SimpleHttpServerPool"));
+		}
+
+		RouteThreadPool->AddQueuedWork(new FRouteQueuedWork(MoveTemp(Work)));
+		break;
+	}
+
+	default:
+		EnqueueGameThreadRequest(MoveTemp(Work));
+		break;
+	}
+}
+
+void USimpleHttpServer::FillNativeRequst(const FHttpServerRequest& Request, const FHttpRouteMatch& Match, FNativeHttpServerRequest& NativeRequest)
+{
+	FillNativeRequst(Request, CopyPathParams(Match), TArray<uint8>(Request.Body), bDecodeBodyEagerly, NativeRequest);
+}
+
+void USimpleHttpServer::FillNativeRequst(const FHttpServerRequest& Request, TMap<FString, FString>&& PathParams, TArray<uint8>&& BodyBytes, bool bDecodeBody, FNativeHttpServerRequest& NativeRequest)
+{
+	NativeRequest.Verb = (ENativeHttpServerRequestVerbs)Request.Verb;
+	NativeRequest.RelativePath = *Request.RelativePath.GetPath();
+
+	for (const auto& Header : Request.Headers)
+	{
+		FString StrHeaderVals;
+		for (const auto& val : Header.Value)
+		{
+			StrHeaderVals += val + TEXT(" ");
+		}
+
+		NativeRequest.Headers.Add(Header.Key, StrHeaderVals);
+	}
+
+	NativeRequest.PathParams = MoveTemp(PathParams);
+	NativeRequest.QueryParams = Request.QueryParams;
+	NativeRequest.ResponseFormat = FHttpStructSerializer::NegotiateFormat(Request);
+
+
+	// Body is decoded on first access
+	NativeRequest.RawBody = MakeShared<FNativeHttpServerRequestBody>(MoveTemp(BodyBytes));
+
+	// Decode straight into Body, the body's cached string stays empty
+	if (bDecodeBody)
+	{
+		const TArray<uint8>& Bytes = NativeRequest.RawBody->Bytes;
+		FUTF8ToTCHAR BodyTCHARData(reinterpret_cast<const ANSICHAR*>(Bytes.GetData()), Bytes.Num());
+		NativeRequest.Body = FString(BodyTCHARData.Length(), BodyTCHARData.Get());
+		NativeRequest.bBodyDecoded = true;
+	}
+}
+
+FNativeHttpServerResponse USimpleHttpServer::MakeResponse(FString Text, FString ContentType, int32 Code)
+{
+	SIMPLEHTTPSERVER_TRACE_SCOPE(Build);
+
+	FHttpResponseBuilder Builder((EHttpServerResponseCodes)Code);
+	Builder.SetTextContentType(ContentType);
+	Builder.Append(FStringView(Text));
+
 	FNativeHttpServerResponse HttpServerResponse;
-	HttpServerResponse.HttpServerResponse.Code = (EHttpServerResponseCodes)Code;
+	HttpServerResponse.HttpServerResponse = MoveTemp(Builder.GetResponse());
+	return HttpServerResponse;
+}
 
-	FTCHARToUTF8 ConvertToUtf8(*Text);
-	const uint8* ConvertToUtf8Bytes = (reinterpret_cast<const uint8*>(ConvertToUtf8.Get()));
-	HttpServerResponse.HttpServerResponse.Body.Append(ConvertToUtf8Bytes, ConvertToUtf8.Length());
+FNativeHttpServerResponse USimpleHttpServer::MakeStructResponse(EHttpWireFormat Format, const UStruct* Struct, const void* Data, int32 Code)
+{
+	SIMPLEHTTPSERVER_TRACE_SCOPE(Build);
 
-	FString Utf8CharsetContentType = FString::Printf(TEXT("%s;charset=utf-8"), *ContentType);
-	TArray<FString> ContentTypeValue = { MoveTemp(Utf8CharsetContentType) };
-	HttpServerResponse.HttpServerResponse.Headers.Add(TEXT("content-type"), MoveTemp(ContentTypeValue));
+	FHttpResponseBuilder Builder((EHttpServerResponseCodes)Code);
+	SetWireContentType(Builder, Format);
+	FHttpStructSerializer::AppendStruct(Builder.GetBody(), Format, Struct, Data);
 
+	FNativeHttpServerResponse HttpServerResponse;
+	HttpServerResponse.HttpServerResponse = MoveTemp(Builder.GetResponse());
+	return HttpServerResponse;
+}
+
+FNativeHttpServerResponse USimpleHttpServer::MakeStructResponseFromProperty(EHttpWireFormat Format, const FProperty* Property, const void* Value, int32 Code)
+{
+	SIMPLEHTTPSERVER_TRACE_SCOPE(Build);
+
+	FHttpResponseBuilder Builder((EHttpServerResponseCodes)Code);
+	SetWireContentType(Builder, Format);
+	FHttpStructSerializer::AppendProperty(Builder.GetBody(), Format, Property, Value);
+
+	FNativeHttpServerResponse HttpServerResponse;
+	HttpServerResponse.HttpServerResponse = MoveTemp(Builder.GetResponse());
 	return HttpServerResponse;
 }
 
+FNativeHttpServerResponse USimpleHttpServer::MakeNegotiatedResponse(FNativeHttpServerResponse&& Response)
+{
+	Response.HttpServerResponse.Headers.FindOrAdd(TEXT("vary")).AddUnique(TEXT("accept"));
+	return MoveTemp(Response);
+}
+
+FNativeHttpServerResponse USimpleHttpServer::MakeJsonResponseFromValue(const int32& Value, int32 Code)
+{
+	// Called only through the custom thunk
+	checkNoEntry();
+	return FNativeHttpServerResponse();
+}
+
+FNativeHttpServerResponse USimpleHttpServer::MakeStructResponseFromValue(const FNativeHttpServerRequest& Request, const int32& Value, int32 Code)
+{
+	// Called only through the custom thunk
+	checkNoEntry();
+	return FNativeHttpServerResponse();
+}
+
+void USimpleHttpServer::SetRouteCachePolicy(FString HttpPath, FHttpRouteCachePolicy Policy)
+{
+	const FString NormalizedPath = NormalizeHttpPath(MoveTemp(HttpPath));
+	CachePolicies.Add(NormalizedPath, MoveTemp(Policy));
+}
+
+void USimpleHttpServer::RemoveRouteCachePolicy(FString HttpPath)
+{
+	CachePolicies.Remove(NormalizeHttpPath(MoveTemp(HttpPath)));
+}
+
+void USimpleHttpServer::SetRouteCompressionEnabled(FString HttpPath, bool bEnabled)
+{
+	const FString NormalizedPath = NormalizeHttpPath(MoveTemp(HttpPath));
+	if (bEnabled)
+	{
+		CompressionDisabledRoutes.Remove(NormalizedPath);
+	}
+	else
+	{
+		CompressionDisabledRoutes.Add(NormalizedPath);
+	}
+}
+
+void USimpleHttpServer::SetRouteBodyStruct(FString HttpPath, UScriptStruct* BodyStruct)
+{
+	const FString NormalizedPath = NormalizeHttpPath(MoveTemp(HttpPath));
+	if (BodyStruct)
+	{
+		RouteBodyStructs.Add(NormalizedPath, BodyStruct);
+	}
+	else
+	{
+		RouteBodyStructs.Remove(NormalizedPath);
+	}
+}
+
+void USimpleHttpServer::BindMetricsRoute(FString HttpPath)
+{
+	BindRouteNative(MoveTemp(HttpPath), ENativeHttpServerRequestVerbs::GET, [Metrics = Metrics](const FNativeHttpServerRequestView& Request, FHttpRouteCompletion Completion)
+	{
+		FHttpResponseBuilder Builder(EHttpServerResponseCodes::Ok);
+		Builder.SetTextContentType(TEXT("text/plain; version=0.0.4"));
+		Metrics->Export(Builder.GetBody());
+		Completion.Complete(Builder.Build());
+	}, EHttpRouteExecution::TaskGraph);
+}
+
+bool USimpleHttpServer::StartTrafficRecording(FString Filename)
+{
+	StopTrafficRecording();
+
+	if (FPaths::IsRelative(Filename))
+	{
+		Filename = FPaths::Combine(FPaths::ProjectSavedDir(), Filename);
+	}
+
+	TrafficRecorder = FHttpTrafficRecorder::Create(Filename, RecordingRedactedHeaders);
+	if (!TrafficRecorder.IsValid())
+	{
+		UE_LOG(LogSimpleHttpServer, Error, TEXT("Could not create traffic recording '%s'"), *Filename);
+		return false;
+	}
+
+	UE_LOG(LogSimpleHttpServer, Log, TEXT("Recording traffic to '%s'"), *Filename);
+	return true;
+}
+
+void USimpleHttpServer::StopTrafficRecording()
+{
+	if (TrafficRecorder.IsValid())
+	{
+		UE_LOG(LogSimpleHttpServer, Log, TEXT("Traffic recording stopped after %lld requests"), TrafficRecorder->GetNumRecords());
+		TrafficRecorder.Reset();
+	}
+}
+
+void USimpleHttpServer::InvalidateCache(FString RequestPath)
+{
+	ResponseCache->Invalidate(NormalizeHttpPath(MoveTemp(RequestPath)));
+}
+
+void USimpleHttpServer::InvalidateCachePrefix(FString Prefix)
+{
+	ResponseCache->InvalidatePrefix(Prefix);
+}
+
+void USimpleHttpServer::ClearCache()
+{
+	ResponseCache->Clear();
+}
+
+FSimpleHttpServerQueueStats USimpleHttpServer::GetQueueStats() const
+{
+	FSimpleHttpServerQueueStats Stats = QueueStats;
+	Stats.QueueDepth = GameThreadQueueDepth.load();
+	return Stats;
+}
+
+void USimpleHttpServer::EnqueueGameThreadRequest(TUniqueFunction<void()>&& Work)
+{
+	GameThreadQueue.Enqueue(MoveTemp(Work));
+	++GameThreadQueueDepth;
+}
+
+bool USimpleHttpServer::Tick(float DeltaTime)
+{
+	// Handlers running from now on read this tick's state
+	if (SnapshotPublisher.HasSources())
+	{
+		const UWorld* World = GetWorld();
+		SnapshotPublisher.Publish(World ? World->GetTimeSeconds() : FPlatformTime::Seconds());
+	}
+
+	// Capture is not handler time, the budget and frame stats start after it
+	const double StartTime = FPlatformTime::Seconds();
+	const double BudgetSeconds = GameThreadBudgetMs / 1000.0;
+
+	int32 Processed = 0;
+	TUniqueFunction<void()> Work;
+	while (GameThreadQueue.Dequeue(Work))
+	{
+		--GameThreadQueueDepth;
+		++GameThreadDequeued;
+		Work();
+		++Processed;
+
+		if (BudgetSeconds > 0.0 && FPlatformTime::Seconds() - StartTime >= BudgetSeconds)
+		{
+			break;
+		}
+	}
+
+	const double HandlersSeconds = FPlatformTime::Seconds() - StartTime;
+
+	const int32 Deferred = GameThreadQueueDepth.load();
+
+	// Queue is FIFO, requests past GameThreadDeferredUpTo are deferred for the first time
+	const uint64 QueuedUpTo = GameThreadDequeued + FMath::Max(Deferred, 0);
+	const uint64 NewlyDeferred = QueuedUpTo - FMath::Min(FMath::Max(GameThreadDeferredUpTo, GameThreadDequeued), QueuedUpTo);
+	GameThreadDeferredUpTo = FMath::Max(GameThreadDeferredUpTo, QueuedUpTo);
+
+	for (const TPair<FString, TSharedRef<FHttpLongPollTopic>>& Topic : LongPollTopics)
+	{
+		Topic.Value->ExpireWaiters(StartTime);
+	}
+
+	if (EventStreams.Num() > 0 && EventStreamKeepAliveSeconds > 0.0f && StartTime - LastKeepAliveTime >= EventStreamKeepAliveSeconds)
+	{
+		LastKeepAliveTime = StartTime;
+		for (const TPair<FString, TSharedRef<FHttpEventStream>>& EventStream : EventStreams)
+		{
+			EventStream.Value->SendKeepAlive();
+		}
+	}
+
+	QueueStats.ProcessedLastFrame = Processed;
+	QueueStats.DeferredLastFrame = Deferred;
+	QueueStats.TotalDeferred += (int64)NewlyDeferred;
+	QueueStats.TimeSpentLastFrameMs = (float)((FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	PublishFrameStats(StartTime, HandlersSeconds);
+
+	return true;
+}
+
+void USimpleHttpServer::PublishFrameStats(double Now, double HandlersSeconds)
+{
+#if STATS || CSV_PROFILER
+	const int32 Requests = RequestsThisFrame;
+
+	if (Now - BytesRateWindowStart >= 1.0)
+	{
+		uint64 BytesIn = 0;
+		uint64 BytesOut = 0;
+		Metrics->GetTotalBytes(BytesIn, BytesOut);
+
+		// First window only takes the starting totals
+		if (BytesRateWindowStart > 0.0)
+		{
+			const double WindowSeconds = Now - BytesRateWindowStart;
+			BytesInPerSecond = (float)((BytesIn - BytesInAtWindowStart) / WindowSeconds);
+			BytesOutPerSecond = (float)((BytesOut - BytesOutAtWindowStart) / WindowSeconds);
+		}
+
+		BytesRateWindowStart = Now;
+		BytesInAtWindowStart = BytesIn;
+		BytesOutAtWindowStart = BytesOut;
+	}
+
+	const float HandlersMs = (float)(HandlersSeconds * 1000.0);
+	const int32 QueueDepth = GameThreadQueueDepth.load();
+	const int32 Connections = StreamServer.IsValid() ? StreamServer->GetNumConnections() : 0;
+
+	INC_DWORD_STAT_BY(STAT_SimpleHttpServer_Requests, Requests);
+	INC_FLOAT_STAT_BY(STAT_SimpleHttpServer_GameThreadMs, HandlersMs);
+	INC_DWORD_STAT_BY(STAT_SimpleHttpServer_QueueDepth, QueueDepth);
+	INC_DWORD_STAT_BY(STAT_SimpleHttpServer_Connections, Connections);
+	INC_FLOAT_STAT_BY(STAT_SimpleHttpServer_BytesInPerSecond, BytesInPerSecond);
+	INC_FLOAT_STAT_BY(STAT_SimpleHttpServer_BytesOutPerSecond, BytesOutPerSecond);
+
+	CSV_CUSTOM_STAT(SimpleHttpServer, RequestsPerFrame, Requests, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SimpleHttpServer, GameThreadMs, HandlersMs, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SimpleHttpServer, QueueDepth, QueueDepth, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SimpleHttpServer, OpenConnections, Connections, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SimpleHttpServer, BytesInPerSecond, BytesInPerSecond, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(SimpleHttpServer, BytesOutPerSecond, BytesOutPerSecond, ECsvCustomStatOp::Accumulate);
+#endif
+
+	RequestsThisFrame = 0;
+}
+
 UWorld* USimpleHttpServer::GetWorld() const
 {
 #if WITH_EDITOR
@@ -359,7 +1413,7 @@ UWorld* USimpleHttpServer::GetWorld() const
 void USimpleHttpServer::BindRoutes()
 {
 	// You can bind any functions for your C++ class
-	//BindRoute("/Test", ENativeHttpServerRequestVerbs::GET, [this](FNativeHttpServerRequest HttpServerRequest) {USimpleHttpServer::TestRoute(HttpServerRequest); });
+	//BindRouteNative("/Test", ENativeHttpServerRequestVerbs::GET, [this](const FNativeHttpServerRequestView& HttpServerRequest, FHttpRouteCompletion Completion) { Completion.Complete(MakeResponse("{}")); });
 
 	ReceiveBindRoutes();
 }
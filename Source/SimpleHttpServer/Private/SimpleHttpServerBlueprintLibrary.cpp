@@ -0,0 +1,54 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "SimpleHttpServerBlueprintLibrary.h"
+#include "HttpConditionalRequest.h"
+
+FString USimpleHttpServerBlueprintLibrary::GetRequestBody(const FNativeHttpServerRequest& Request)
+{
+	return Request.GetBodyString();
+}
+
+TArray<uint8> USimpleHttpServerBlueprintLibrary::GetRequestBodyBytes(const FNativeHttpServerRequest& Request)
+{
+	return TArray<uint8>(Request.GetBodyBytes());
+}
+
+bool USimpleHttpServerBlueprintLibrary::GetRequestBodyJson(const FNativeHttpServerRequest& Request, FJsonObjectWrapper& OutJson)
+{
+	OutJson.JsonObject = Request.GetBodyJson();
+	return OutJson.JsonObject.IsValid();
+}
+
+bool USimpleHttpServerBlueprintLibrary::GetRequestBodyStruct(const FNativeHttpServerRequest& Request, int32& Value)
+{
+	// Called only through the custom thunk
+	checkNoEntry();
+	return false;
+}
+
+bool USimpleHttpServerBlueprintLibrary::CopyRequestBodyStruct(const FNativeHttpServerRequest& Request, const FStructProperty* ValueProperty, void* ValueAddress)
+{
+	if (!Request.ParsedBody.IsValid() || !ValueProperty || !ValueAddress || ValueProperty->Struct != Request.ParsedBody->GetStruct())
+	{
+		return false;
+	}
+
+	ValueProperty->Struct->CopyScriptStruct(ValueAddress, Request.ParsedBody->GetStructMemory());
+	return true;
+}
+
+void USimpleHttpServerBlueprintLibrary::SetResponseETag(FNativeHttpServerResponse& Response, const FString& ETag)
+{
+	FString ETagValue = ETag.IsEmpty() ? FHttpConditionalRequest::ComputeETag(Response.HttpServerResponse.Body) : ETag;
+	if (!ETagValue.EndsWith(TEXT("\"")))
+	{
+		ETagValue = FString::Printf(TEXT("\"%s\""), *ETagValue);
+	}
+
+	Response.HttpServerResponse.Headers.Add(FHttpConditionalRequest::ETagHeader, TArray<FString>{ MoveTemp(ETagValue) });
+}
+
+void USimpleHttpServerBlueprintLibrary::SetResponseLastModified(FNativeHttpServerResponse& Response, FDateTime LastModified)
+{
+	Response.HttpServerResponse.Headers.Add(FHttpConditionalRequest::LastModifiedHeader, TArray<FString>{ LastModified.ToHttpDate() });
+}
@@ -0,0 +1,127 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpConditionalRequest.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const TCHAR* const ETag = TEXT("\"v2\"");
+	const TCHAR* const LastModified = TEXT("Mon, 06 May 2024 07:08:09 GMT");
+	const TCHAR* const Earlier = TEXT("Sun, 05 May 2024 07:08:09 GMT");
+
+	FHttpConditionalRequest MakeConditional(const TCHAR* IfNoneMatch, const TCHAR* IfModifiedSince = nullptr)
+	{
+		FHttpServerRequest Request;
+		if (IfNoneMatch)
+		{
+			Request.Headers.Add(TEXT("if-none-match"), TArray<FString>{ IfNoneMatch });
+		}
+
+		if (IfModifiedSince)
+		{
+			Request.Headers.Add(TEXT("if-modified-since"), TArray<FString>{ IfModifiedSince });
+		}
+
+		return FHttpConditionalRequest(Request);
+	}
+
+	TMap<FString, TArray<FString>> MakeResponseHeaders()
+	{
+		TMap<FString, TArray<FString>> Headers;
+		Headers.Add(FHttpConditionalRequest::ETagHeader, TArray<FString>{ ETag });
+		Headers.Add(FHttpConditionalRequest::LastModifiedHeader, TArray<FString>{ LastModified });
+		Headers.Add(TEXT("cache-control"), TArray<FString>{ TEXT("max-age=60") });
+		Headers.Add(TEXT("content-type"), TArray<FString>{ TEXT("text/plain") });
+		return Headers;
+	}
+}
+
+BEGIN_DEFINE_SPEC(FHttpConditionalRequestSpec, "SimpleHttpServer.ConditionalRequest", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+END_DEFINE_SPEC(FHttpConditionalRequestSpec)
+
+void FHttpConditionalRequestSpec::Define()
+{
+	Describe("IsNotModified", [this]()
+	{
+		It("matches If-None-Match against the ETag", [this]()
+		{
+			const TMap<FString, TArray<FString>> Headers = MakeResponseHeaders();
+
+			TestTrue(TEXT("Same tag"), MakeConditional(ETag).IsNotModified(Headers));
+			TestTrue(TEXT("Weak tag"), MakeConditional(TEXT("W/\"v2\"")).IsNotModified(Headers));
+			TestTrue(TEXT("One of a list"), MakeConditional(TEXT("\"v1\", \"v2\"")).IsNotModified(Headers));
+			TestTrue(TEXT("Any"), MakeConditional(TEXT("*")).IsNotModified(Headers));
+			TestFalse(TEXT("Other tag"), MakeConditional(TEXT("\"v1\"")).IsNotModified(Headers));
+			TestFalse(TEXT("Tags are case-sensitive"), MakeConditional(TEXT("\"V2\"")).IsNotModified(Headers));
+		});
+
+		It("lets If-None-Match win over If-Modified-Since", [this]()
+		{
+			const TMap<FString, TArray<FString>> Headers = MakeResponseHeaders();
+
+			TestFalse(TEXT("Changed tag, old date"), MakeConditional(TEXT("\"v1\""), LastModified).IsNotModified(Headers));
+			TestTrue(TEXT("Same tag, newer content"), MakeConditional(ETag, Earlier).IsNotModified(Headers));
+		});
+
+		It("falls back to If-Modified-Since without If-None-Match", [this]()
+		{
+			const TMap<FString, TArray<FString>> Headers = MakeResponseHeaders();
+
+			TestTrue(TEXT("Same date"), MakeConditional(nullptr, LastModified).IsNotModified(Headers));
+			TestFalse(TEXT("Modified since"), MakeConditional(nullptr, Earlier).IsNotModified(Headers));
+			TestFalse(TEXT("Bad date"), MakeConditional(nullptr, TEXT("yesterday")).IsNotModified(Headers));
+		});
+
+		It("is false without validators on either side", [this]()
+		{
+			TestFalse(TEXT("Not conditional"), MakeConditional(nullptr).IsConditional());
+			TestFalse(TEXT("No ETag"), MakeConditional(ETag).IsNotModified(TMap<FString, TArray<FString>>()));
+		});
+	});
+
+	Describe("MakeNotModified", [this]()
+	{
+		It("keeps validators and caching headers without a body", [this]()
+		{
+			const TUniquePtr<FHttpServerResponse> Response = FHttpConditionalRequest::MakeNotModified(MakeResponseHeaders());
+
+			TestEqual(TEXT("Code"), (int32)Response->Code, (int32)EHttpServerResponseCodes::NotModified);
+			TestTrue(TEXT("ETag"), Response->Headers.Contains(FHttpConditionalRequest::ETagHeader));
+			TestTrue(TEXT("Last-Modified"), Response->Headers.Contains(FHttpConditionalRequest::LastModifiedHeader));
+			TestTrue(TEXT("Cache-Control"), Response->Headers.Contains(TEXT("cache-control")));
+			TestFalse(TEXT("Content-Type"), Response->Headers.Contains(TEXT("content-type")));
+			TestEqual(TEXT("Body"), Response->Body.Num(), 0);
+		});
+	});
+
+	Describe("ComputeETag", [this]()
+	{
+		It("is strong and follows the content", [this]()
+		{
+			const TArray<uint8> Body = { 'a', 'b' };
+			const FString Tag = FHttpConditionalRequest::ComputeETag(Body);
+
+			TestTrue(TEXT("Quoted"), Tag.StartsWith(TEXT("\"")) && Tag.EndsWith(TEXT("\"")));
+			TestEqual(TEXT("Stable"), FHttpConditionalRequest::ComputeETag(Body), Tag);
+			TestNotEqual(TEXT("Other content"), FHttpConditionalRequest::ComputeETag(TArray<uint8>{ 'a', 'c' }), Tag);
+		});
+
+		It("is added only when the response has none", [this]()
+		{
+			FHttpServerResponse Response;
+			Response.Body = { 'a' };
+			Response.Headers.Add(FHttpConditionalRequest::ETagHeader, TArray<FString>{ ETag });
+
+			FHttpConditionalRequest::AddETagIfMissing(Response);
+			TestEqual(TEXT("Kept"), Response.Headers.FindRef(FHttpConditionalRequest::ETagHeader)[0], FString(ETag));
+
+			Response.Headers.Reset();
+			FHttpConditionalRequest::AddETagIfMissing(Response);
+			TestEqual(TEXT("Added"), Response.Headers.FindRef(FHttpConditionalRequest::ETagHeader)[0], FHttpConditionalRequest::ComputeETag(Response.Body));
+		});
+	});
+}
+
+#endif
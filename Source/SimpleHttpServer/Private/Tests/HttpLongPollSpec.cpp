@@ -0,0 +1,122 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpLongPoll.h"
+#include "NativeHttpServerRequestView.h"
+#include "SimpleHttpServer.h"
+#include "SimpleHttpRouteTrie.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FHttpLongPollSpec, "SimpleHttpServer.LongPoll", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+	TSharedPtr<FHttpLongPollTopic> Topic;
+
+	// Responses in completion order, shared with callbacks
+	TSharedPtr<TArray<TUniquePtr<FHttpServerResponse>>> Responses;
+
+	void Poll(uint64 Since)
+	{
+		FHttpServerRequest Request;
+		Request.Verb = EHttpServerRequestVerbs::VERB_GET;
+		Request.RelativePath = FHttpPath(TEXT("/state"));
+		Request.QueryParams.Add(TEXT("since"), LexToString(Since));
+
+		const FNativeHttpServerRequestView View(Request, FHttpRouteMatch(), MakeShared<const FSimpleHttpRoute>());
+		Topic->HandleRequest(View, FHttpRouteCompletion([Responses = Responses](TUniquePtr<FHttpServerResponse>&& Response)
+		{
+			Responses->Add(MoveTemp(Response));
+		}));
+	}
+
+	FString GetVersionHeader(int32 Index) const
+	{
+		const TArray<FString>* Values = (*Responses)[Index]->Headers.Find(FHttpLongPollTopic::VersionHeader);
+		return Values && Values->Num() > 0 ? (*Values)[0] : FString();
+	}
+END_DEFINE_SPEC(FHttpLongPollSpec)
+
+void FHttpLongPollSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		Topic = MakeShared<FHttpLongPollTopic>();
+		Topic->TimeoutSeconds = 5.0f;
+		Responses = MakeShared<TArray<TUniquePtr<FHttpServerResponse>>>();
+		Topic->Publish(TEXT("{\"state\":1}"));
+	});
+
+	AfterEach([this]()
+	{
+		// Answer clients still parked, so their completions aren't released unanswered
+		Topic->Publish(TEXT("{}"));
+	});
+
+	It("answers clients on another version right away", [this]()
+	{
+		Poll(0);
+
+		TestEqual(TEXT("Answered"), Responses->Num(), 1);
+		TestEqual(TEXT("Waiting"), Topic->GetNumWaiting(), 0);
+		if (Responses->Num() == 1)
+		{
+			TestEqual(TEXT("Code"), (int32)(*Responses)[0]->Code, (int32)EHttpServerResponseCodes::Ok);
+			TestEqual(TEXT("Version"), GetVersionHeader(0), FString(TEXT("1")));
+		}
+	});
+
+	It("parks clients on the current version until the next publish", [this]()
+	{
+		Poll(1);
+		TestEqual(TEXT("Parked"), Topic->GetNumWaiting(), 1);
+		TestEqual(TEXT("Not answered"), Responses->Num(), 0);
+
+		Topic->Publish(TEXT("{\"state\":2}"));
+
+		TestEqual(TEXT("Waiting"), Topic->GetNumWaiting(), 0);
+		if (TestEqual(TEXT("Answered"), Responses->Num(), 1))
+		{
+			TestEqual(TEXT("Version"), GetVersionHeader(0), FString(TEXT("2")));
+			TestEqual(TEXT("Body"), (*Responses)[0]->Body.Num(), 11);
+		}
+	});
+
+	Describe("ExpireWaiters", [this]()
+	{
+		It("keeps clients parked until their deadline", [this]()
+		{
+			Poll(1);
+			Topic->ExpireWaiters(FPlatformTime::Seconds());
+
+			TestEqual(TEXT("Waiting"), Topic->GetNumWaiting(), 1);
+			TestEqual(TEXT("Not answered"), Responses->Num(), 0);
+		});
+
+		It("answers expired clients with 204 and the current version", [this]()
+		{
+			Poll(1);
+			Topic->ExpireWaiters(FPlatformTime::Seconds() + Topic->TimeoutSeconds + 1.0);
+
+			TestEqual(TEXT("Waiting"), Topic->GetNumWaiting(), 0);
+			if (TestEqual(TEXT("Answered"), Responses->Num(), 1))
+			{
+				TestEqual(TEXT("Code"), (int32)(*Responses)[0]->Code, (int32)EHttpServerResponseCodes::NoContent);
+				TestEqual(TEXT("Version"), GetVersionHeader(0), FString(TEXT("1")));
+				TestEqual(TEXT("Body"), (*Responses)[0]->Body.Num(), 0);
+			}
+		});
+
+		It("expires only clients past their deadline", [this]()
+		{
+			Poll(1);
+			Topic->TimeoutSeconds = 60.0f;
+			Poll(1);
+
+			Topic->ExpireWaiters(FPlatformTime::Seconds() + 10.0);
+
+			TestEqual(TEXT("Waiting"), Topic->GetNumWaiting(), 1);
+			TestEqual(TEXT("Answered"), Responses->Num(), 1);
+		});
+	});
+}
+
+#endif
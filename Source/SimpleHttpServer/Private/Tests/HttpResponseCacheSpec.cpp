@@ -0,0 +1,233 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpResponseCache.h"
+#include "HttpStructSerializer.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	FHttpServerRequest MakeRequest(const TCHAR* Path)
+	{
+		FHttpServerRequest Request;
+		Request.Verb = EHttpServerRequestVerbs::VERB_GET;
+		Request.RelativePath = FHttpPath(Path);
+		return Request;
+	}
+
+	FHttpServerResponse MakeResponse(const ANSICHAR* Body)
+	{
+		FHttpServerResponse Response;
+		Response.Code = EHttpServerResponseCodes::Ok;
+		Response.Headers.Add(TEXT("content-type"), TArray<FString>{ TEXT("text/plain") });
+		Response.Body.Append(reinterpret_cast<const uint8*>(Body), FCStringAnsi::Strlen(Body));
+		return Response;
+	}
+}
+
+BEGIN_DEFINE_SPEC(FHttpResponseCacheSpec, "SimpleHttpServer.ResponseCache", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+	TSharedPtr<FHttpResponseCache> Cache;
+	FHttpRouteCachePolicy Policy;
+
+	FString MakeKey(const FHttpServerRequest& Request)
+	{
+		return FHttpResponseCache::MakeKey(Request, Request.RelativePath.GetPath(), Policy);
+	}
+END_DEFINE_SPEC(FHttpResponseCacheSpec)
+
+void FHttpResponseCacheSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		Cache = MakeShared<FHttpResponseCache>();
+		Policy = FHttpRouteCachePolicy();
+	});
+
+	Describe("MakeKey", [this]()
+	{
+		It("ignores query params and headers the policy doesn't list", [this]()
+		{
+			FHttpServerRequest Plain = MakeRequest(TEXT("/items"));
+			FHttpServerRequest Decorated = MakeRequest(TEXT("/items"));
+			Decorated.QueryParams.Add(TEXT("utm"), TEXT("1"));
+			Decorated.Headers.Add(TEXT("user-agent"), TArray<FString>{ TEXT("test") });
+
+			TestEqual(TEXT("Same key"), MakeKey(Decorated), MakeKey(Plain));
+		});
+
+		It("varies by verb, path and listed query params and headers", [this]()
+		{
+			Policy.QueryParams = { TEXT("page") };
+			Policy.Headers = { TEXT("x-team") };
+
+			const FHttpServerRequest Base = MakeRequest(TEXT("/items"));
+			const FString BaseKey = MakeKey(Base);
+
+			FHttpServerRequest Head = Base;
+			Head.Verb = EHttpServerRequestVerbs::VERB_HEAD;
+			TestNotEqual(TEXT("Verb"), MakeKey(Head), BaseKey);
+
+			TestNotEqual(TEXT("Path"), MakeKey(MakeRequest(TEXT("/other"))), BaseKey);
+
+			FHttpServerRequest Page = Base;
+			Page.QueryParams.Add(TEXT("page"), TEXT("2"));
+			TestNotEqual(TEXT("Query param"), MakeKey(Page), BaseKey);
+
+			FHttpServerRequest EmptyPage = Base;
+			EmptyPage.QueryParams.Add(TEXT("page"), FString());
+			TestNotEqual(TEXT("Empty query param differs from a missing one"), MakeKey(EmptyPage), BaseKey);
+
+			FHttpServerRequest Team = Base;
+			Team.Headers.Add(TEXT("x-team"), TArray<FString>{ TEXT("red") });
+			TestNotEqual(TEXT("Header"), MakeKey(Team), BaseKey);
+		});
+
+		It("can't be forged with separators inside values", [this]()
+		{
+			Policy.QueryParams = { TEXT("a"), TEXT("b") };
+
+			FHttpServerRequest First = MakeRequest(TEXT("/items"));
+			First.QueryParams.Add(TEXT("a"), TEXT("1&b=2"));
+
+			FHttpServerRequest Second = MakeRequest(TEXT("/items"));
+			Second.QueryParams.Add(TEXT("a"), TEXT("1"));
+			Second.QueryParams.Add(TEXT("b"), TEXT("2"));
+
+			TestNotEqual(TEXT("Keys"), MakeKey(First), MakeKey(Second));
+		});
+
+		It("varies by negotiated wire format, not by raw Accept", [this]()
+		{
+			const FHttpServerRequest Json = MakeRequest(TEXT("/items"));
+
+			FHttpServerRequest ExplicitJson = Json;
+			ExplicitJson.Headers.Add(TEXT("accept"), TArray<FString>{ TEXT("application/json, */*;q=0.1") });
+			TestEqual(TEXT("Same format"), MakeKey(ExplicitJson), MakeKey(Json));
+
+			FHttpServerRequest MessagePack = Json;
+			MessagePack.Headers.Add(TEXT("accept"), TArray<FString>{ FHttpStructSerializer::GetContentType(EHttpWireFormat::MessagePack) });
+			TestNotEqual(TEXT("Other format"), MakeKey(MessagePack), MakeKey(Json));
+		});
+	});
+
+	Describe("Store and Find", [this]()
+	{
+		It("returns a stored response until it expires", [this]()
+		{
+			const FString Key = MakeKey(MakeRequest(TEXT("/items")));
+			TestTrue(TEXT("Stored"), Cache->Store(Key, TEXT("/items"), MakeResponse("hello"), 0.05f).IsValid());
+
+			TSharedPtr<const FHttpCachedResponse> Entry = Cache->Find(Key);
+			if (TestTrue(TEXT("Found"), Entry.IsValid()))
+			{
+				TestEqual(TEXT("Body"), Entry->Body.Num(), 5);
+				TestEqual(TEXT("Request path"), Entry->RequestPath, FString(TEXT("/items")));
+			}
+
+			FPlatformProcess::Sleep(0.1f);
+			TestFalse(TEXT("Expired"), Cache->Find(Key).IsValid());
+		});
+
+		It("doesn't store with zero TTL", [this]()
+		{
+			const FString Key = MakeKey(MakeRequest(TEXT("/items")));
+			TestFalse(TEXT("Stored"), Cache->Store(Key, TEXT("/items"), MakeResponse("hello"), 0.0f).IsValid());
+			TestFalse(TEXT("Found"), Cache->Find(Key).IsValid());
+		});
+
+		It("gives equal bodies the same content version", [this]()
+		{
+			TSharedPtr<const FHttpCachedResponse> First = Cache->Store(TEXT("a"), TEXT("/a"), MakeResponse("same"), 10.0f);
+			TSharedPtr<const FHttpCachedResponse> Second = Cache->Store(TEXT("b"), TEXT("/b"), MakeResponse("same"), 10.0f);
+			TSharedPtr<const FHttpCachedResponse> Other = Cache->Store(TEXT("c"), TEXT("/c"), MakeResponse("other"), 10.0f);
+
+			TestEqual(TEXT("Same content"), First->ContentVersion, Second->ContentVersion);
+			TestNotEqual(TEXT("Other content"), First->ContentVersion, Other->ContentVersion);
+		});
+
+		It("stops storing new keys when full and purges expired entries first", [this]()
+		{
+			Cache->MaxEntries = 2;
+			Cache->Store(TEXT("short"), TEXT("/short"), MakeResponse("a"), 0.05f);
+			Cache->Store(TEXT("long"), TEXT("/long"), MakeResponse("b"), 10.0f);
+
+			TestFalse(TEXT("Full"), Cache->Store(TEXT("new"), TEXT("/new"), MakeResponse("c"), 10.0f).IsValid());
+			TestTrue(TEXT("Existing key replaced when full"), Cache->Store(TEXT("long"), TEXT("/long"), MakeResponse("d"), 10.0f).IsValid());
+
+			FPlatformProcess::Sleep(0.1f);
+			TestTrue(TEXT("Stored after purge"), Cache->Store(TEXT("new"), TEXT("/new"), MakeResponse("c"), 10.0f).IsValid());
+			TestEqual(TEXT("Num"), Cache->Num(), 2);
+		});
+	});
+
+	Describe("Invalidate", [this]()
+	{
+		BeforeEach([this]()
+		{
+			Cache->Store(TEXT("items"), TEXT("/items"), MakeResponse("a"), 10.0f);
+			Cache->Store(TEXT("items?page=2"), TEXT("/items"), MakeResponse("b"), 10.0f);
+			Cache->Store(TEXT("item"), TEXT("/items/1"), MakeResponse("c"), 10.0f);
+			Cache->Store(TEXT("users"), TEXT("/users"), MakeResponse("d"), 10.0f);
+		});
+
+		It("removes every query of exactly one path", [this]()
+		{
+			Cache->Invalidate(TEXT("/ITEMS"));
+
+			TestFalse(TEXT("Path"), Cache->Find(TEXT("items")).IsValid());
+			TestFalse(TEXT("Path with query"), Cache->Find(TEXT("items?page=2")).IsValid());
+			TestTrue(TEXT("Sub path kept"), Cache->Find(TEXT("item")).IsValid());
+			TestTrue(TEXT("Other path kept"), Cache->Find(TEXT("users")).IsValid());
+		});
+
+		It("removes every path under a prefix", [this]()
+		{
+			Cache->InvalidatePrefix(TEXT("/items"));
+
+			TestEqual(TEXT("Num"), Cache->Num(), 1);
+			TestTrue(TEXT("Other path kept"), Cache->Find(TEXT("users")).IsValid());
+		});
+	});
+
+	Describe("encoded bodies", [this]()
+	{
+		It("are kept per content version and encoding", [this]()
+		{
+			Cache->StoreEncodedBody(1, NAME_Gzip, MakeShared<const TArray<uint8>>(TArray<uint8>{ 1, 2 }));
+
+			TSharedPtr<const TArray<uint8>> Gzip = Cache->FindEncodedBody(1, NAME_Gzip);
+			if (TestTrue(TEXT("Found"), Gzip.IsValid()))
+			{
+				TestEqual(TEXT("Bytes"), Gzip->Num(), 2);
+			}
+
+			TestFalse(TEXT("Other encoding"), Cache->FindEncodedBody(1, NAME_Zlib).IsValid());
+			TestFalse(TEXT("Other version"), Cache->FindEncodedBody(2, NAME_Gzip).IsValid());
+		});
+
+		It("outlive entries of the same content", [this]()
+		{
+			TSharedPtr<const FHttpCachedResponse> Entry = Cache->Store(TEXT("items"), TEXT("/items"), MakeResponse("hello"), 10.0f);
+			Cache->StoreEncodedBody(Entry->ContentVersion, NAME_Gzip, MakeShared<const TArray<uint8>>());
+			Cache->Invalidate(TEXT("/items"));
+
+			TestTrue(TEXT("Encoded body kept"), Cache->FindEncodedBody(Entry->ContentVersion, NAME_Gzip).IsValid());
+		});
+
+		It("drop the oldest first when over the limit", [this]()
+		{
+			Cache->MaxEncodedBodies = 2;
+			for (uint64 Version = 1; Version <= 3; ++Version)
+			{
+				Cache->StoreEncodedBody(Version, NAME_Gzip, MakeShared<const TArray<uint8>>());
+			}
+
+			TestFalse(TEXT("Oldest dropped"), Cache->FindEncodedBody(1, NAME_Gzip).IsValid());
+			TestTrue(TEXT("Second kept"), Cache->FindEncodedBody(2, NAME_Gzip).IsValid());
+			TestTrue(TEXT("Newest kept"), Cache->FindEncodedBody(3, NAME_Gzip).IsValid());
+		});
+	});
+}
+
+#endif
@@ -0,0 +1,140 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpResponseCompression.h"
+#include "HttpConditionalRequest.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Compression.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	FHttpServerResponse MakeTextResponse(int32 Size)
+	{
+		FHttpServerResponse Response;
+		Response.Headers.Add(TEXT("content-type"), TArray<FString>{ TEXT("application/json; charset=utf-8") });
+		Response.Body.Init('a', Size);
+		return Response;
+	}
+}
+
+BEGIN_DEFINE_SPEC(FHttpResponseCompressionSpec, "SimpleHttpServer.ResponseCompression", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+	FName Negotiate(const TCHAR* AcceptEncoding)
+	{
+		FHttpServerRequest Request;
+		if (AcceptEncoding)
+		{
+			Request.Headers.Add(TEXT("accept-encoding"), TArray<FString>{ AcceptEncoding });
+		}
+
+		return FHttpResponseCompression::NegotiateEncoding(Request);
+	}
+END_DEFINE_SPEC(FHttpResponseCompressionSpec)
+
+void FHttpResponseCompressionSpec::Define()
+{
+	Describe("NegotiateEncoding", [this]()
+	{
+		It("picks the accepted encoding with the highest quality", [this]()
+		{
+			TestEqual(TEXT("No header"), Negotiate(nullptr), FName(NAME_None));
+			TestEqual(TEXT("Gzip"), Negotiate(TEXT("gzip")), FName(NAME_Gzip));
+			TestEqual(TEXT("Deflate"), Negotiate(TEXT("deflate")), FName(NAME_Zlib));
+			TestEqual(TEXT("Gzip wins ties"), Negotiate(TEXT("deflate, gzip")), FName(NAME_Gzip));
+			TestEqual(TEXT("Quality"), Negotiate(TEXT("gzip;q=0.5, deflate;q=0.8")), FName(NAME_Zlib));
+			TestEqual(TEXT("Case and spaces"), Negotiate(TEXT(" GZIP ; Q=0.3 ")), FName(NAME_Gzip));
+			TestEqual(TEXT("Unsupported only"), Negotiate(TEXT("br, identity")), FName(NAME_None));
+		});
+
+		It("never picks an encoding refused with q=0", [this]()
+		{
+			TestEqual(TEXT("Gzip refused"), Negotiate(TEXT("gzip;q=0, deflate")), FName(NAME_Zlib));
+			TestEqual(TEXT("Both refused"), Negotiate(TEXT("gzip;q=0, deflate;q=0")), FName(NAME_None));
+		});
+	});
+
+	Describe("ShouldCompress", [this]()
+	{
+		It("only takes large enough textual bodies that are not encoded yet", [this]()
+		{
+			TestTrue(TEXT("Json"), FHttpResponseCompression::ShouldCompress(MakeTextResponse(2048), 1024));
+			TestFalse(TEXT("Too small"), FHttpResponseCompression::ShouldCompress(MakeTextResponse(100), 1024));
+
+			FHttpServerResponse Image = MakeTextResponse(2048);
+			Image.Headers.Add(TEXT("content-type"), TArray<FString>{ TEXT("image/png") });
+			TestFalse(TEXT("Binary type"), FHttpResponseCompression::ShouldCompress(Image, 1024));
+
+			FHttpServerResponse Encoded = MakeTextResponse(2048);
+			Encoded.Headers.Add(TEXT("content-encoding"), TArray<FString>{ TEXT("br") });
+			TestFalse(TEXT("Already encoded"), FHttpResponseCompression::ShouldCompress(Encoded, 1024));
+
+			FHttpServerResponse Untyped = MakeTextResponse(2048);
+			Untyped.Headers.Reset();
+			TestFalse(TEXT("No content type"), FHttpResponseCompression::ShouldCompress(Untyped, 1024));
+		});
+	});
+
+	Describe("Compress", [this]()
+	{
+		It("round trips through the engine decompressor", [this]()
+		{
+			FHttpServerResponse Response = MakeTextResponse(4096);
+			const TArray<uint8> Original = Response.Body;
+
+			if (!TestTrue(TEXT("Compressed"), FHttpResponseCompression::Compress(Response, NAME_Zlib)))
+			{
+				return;
+			}
+
+			TestTrue(TEXT("Smaller"), Response.Body.Num() < Original.Num());
+			TestEqual(TEXT("Content-Encoding"), Response.Headers.FindRef(TEXT("content-encoding"))[0], FString(TEXT("deflate")));
+
+			TArray<uint8> Decompressed;
+			Decompressed.SetNumUninitialized(Original.Num());
+			TestTrue(TEXT("Decompressed"), FCompression::UncompressMemory(NAME_Zlib, Decompressed.GetData(), Decompressed.Num(), Response.Body.GetData(), Response.Body.Num()));
+			TestEqual(TEXT("Same bytes"), Decompressed, Original);
+		});
+
+		It("keeps the response as is when compression doesn't help", [this]()
+		{
+			FHttpServerResponse Response = MakeTextResponse(0);
+			Response.Body = { 0x1f, 0x8b, 0x08 };
+
+			TestFalse(TEXT("Compressed"), FHttpResponseCompression::Compress(Response, NAME_Gzip));
+			TestEqual(TEXT("Body"), Response.Body.Num(), 3);
+			TestFalse(TEXT("Content-Encoding"), Response.Headers.Contains(TEXT("content-encoding")));
+		});
+	});
+
+	Describe("SetEncodingHeaders", [this]()
+	{
+		It("adds Vary once and weakens strong ETags", [this]()
+		{
+			FHttpServerResponse Response;
+			Response.Headers.Add(TEXT("vary"), TArray<FString>{ TEXT("accept-encoding") });
+			Response.Headers.Add(FHttpConditionalRequest::ETagHeader, TArray<FString>{ TEXT("\"v1\""), TEXT("W/\"v2\"") });
+
+			FHttpResponseCompression::SetEncodingHeaders(Response, NAME_Gzip);
+
+			TestEqual(TEXT("Content-Encoding"), Response.Headers.FindRef(TEXT("content-encoding"))[0], FString(TEXT("gzip")));
+			TestEqual(TEXT("Vary"), Response.Headers.FindRef(TEXT("vary")).Num(), 1);
+
+			const TArray<FString> ETags = Response.Headers.FindRef(FHttpConditionalRequest::ETagHeader);
+			TestEqual(TEXT("Strong tag weakened"), ETags[0], FString(TEXT("W/\"v1\"")));
+			TestEqual(TEXT("Weak tag kept"), ETags[1], FString(TEXT("W/\"v2\"")));
+		});
+
+		It("keeps weakened ETags matching the identity ones", [this]()
+		{
+			FHttpServerResponse Response;
+			Response.Headers.Add(FHttpConditionalRequest::ETagHeader, TArray<FString>{ TEXT("\"v1\"") });
+			FHttpResponseCompression::SetEncodingHeaders(Response, NAME_Zlib);
+
+			FHttpServerRequest Request;
+			Request.Headers.Add(TEXT("if-none-match"), TArray<FString>{ TEXT("\"v1\"") });
+			TestTrue(TEXT("Not modified"), FHttpConditionalRequest(Request).IsNotModified(Response.Headers));
+		});
+	});
+}
+
+#endif
@@ -0,0 +1,66 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpStaticDirectory.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FHttpStaticDirectorySpec, "SimpleHttpServer.StaticDirectory", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+	using ERangeResult = FHttpStaticDirectory::ERangeResult;
+
+	void TestRange(const TCHAR* Header, int64 FileSize, ERangeResult ExpectedResult, int64 ExpectedStart = 0, int64 ExpectedEnd = 0)
+	{
+		int64 Start = -1;
+		int64 End = -1;
+		const ERangeResult Result = FHttpStaticDirectory::ParseRange(Header, FileSize, Start, End);
+
+		TestEqual(FString::Printf(TEXT("'%s' result"), Header), (int32)Result, (int32)ExpectedResult);
+		if (Result == ERangeResult::Satisfiable && ExpectedResult == ERangeResult::Satisfiable)
+		{
+			TestEqual(FString::Printf(TEXT("'%s' start"), Header), Start, ExpectedStart);
+			TestEqual(FString::Printf(TEXT("'%s' end"), Header), End, ExpectedEnd);
+		}
+	}
+END_DEFINE_SPEC(FHttpStaticDirectorySpec)
+
+void FHttpStaticDirectorySpec::Define()
+{
+	Describe("ParseRange", [this]()
+	{
+		It("parses single byte ranges", [this]()
+		{
+			TestRange(TEXT("bytes=0-99"), 1000, ERangeResult::Satisfiable, 0, 99);
+			TestRange(TEXT("bytes=500-"), 1000, ERangeResult::Satisfiable, 500, 999);
+			TestRange(TEXT("bytes=-100"), 1000, ERangeResult::Satisfiable, 900, 999);
+			TestRange(TEXT(" Bytes = 10 - 20 "), 1000, ERangeResult::Ignored);
+			TestRange(TEXT("BYTES=10-20"), 1000, ERangeResult::Satisfiable, 10, 20);
+		});
+
+		It("clamps ranges to the file", [this]()
+		{
+			TestRange(TEXT("bytes=900-5000"), 1000, ERangeResult::Satisfiable, 900, 999);
+			TestRange(TEXT("bytes=-5000"), 1000, ERangeResult::Satisfiable, 0, 999);
+		});
+
+		It("reports ranges past the end as unsatisfiable", [this]()
+		{
+			TestRange(TEXT("bytes=1000-"), 1000, ERangeResult::Unsatisfiable);
+			TestRange(TEXT("bytes=-0"), 1000, ERangeResult::Unsatisfiable);
+			TestRange(TEXT("bytes=0-"), 0, ERangeResult::Unsatisfiable);
+		});
+
+		It("ignores malformed and multiple ranges", [this]()
+		{
+			TestRange(TEXT(""), 1000, ERangeResult::Ignored);
+			TestRange(TEXT("items=0-10"), 1000, ERangeResult::Ignored);
+			TestRange(TEXT("bytes=0-10,20-30"), 1000, ERangeResult::Ignored);
+			TestRange(TEXT("bytes=10"), 1000, ERangeResult::Ignored);
+			TestRange(TEXT("bytes=-"), 1000, ERangeResult::Ignored);
+			TestRange(TEXT("bytes=a-10"), 1000, ERangeResult::Ignored);
+			TestRange(TEXT("bytes=20-10"), 1000, ERangeResult::Ignored);
+			TestRange(TEXT("bytes=99999999999999999999-"), 1000, ERangeResult::Ignored);
+		});
+	});
+}
+
+#endif
@@ -0,0 +1,91 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpStreamServer.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FHttpStreamServerSpec, "SimpleHttpServer.StreamServer", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+	static constexpr int32 MaxRequestSize = 1024;
+
+	int32 Parse(const ANSICHAR* Text, FHttpServerRequest& OutRequest, int32 Len = INDEX_NONE)
+	{
+		const int32 TextLen = FCStringAnsi::Strlen(Text);
+		const TArray<uint8> Bytes(reinterpret_cast<const uint8*>(Text), Len == INDEX_NONE ? TextLen : FMath::Min(Len, TextLen));
+		return FHttpStreamServer::ParseRequest(Bytes, MaxRequestSize, OutRequest);
+	}
+
+	int32 Parse(const ANSICHAR* Text)
+	{
+		FHttpServerRequest Request;
+		return Parse(Text, Request);
+	}
+END_DEFINE_SPEC(FHttpStreamServerSpec)
+
+void FHttpStreamServerSpec::Define()
+{
+	Describe("ParseRequest", [this]()
+	{
+		It("parses request line, query, headers and body", [this]()
+		{
+			const ANSICHAR* Text = "POST /events/live?since=4&name=a%20b HTTP/1.1\r\nHost: localhost\r\nContent-Length: 5\r\nX-Tag: one\r\nX-Tag: two\r\n\r\nhello";
+
+			FHttpServerRequest Request;
+			TestEqual(TEXT("Consumed"), Parse(Text, Request), FCStringAnsi::Strlen(Text));
+			TestEqual(TEXT("Verb"), (int32)Request.Verb, (int32)EHttpServerRequestVerbs::VERB_POST);
+			TestEqual(TEXT("Path"), Request.RelativePath.GetPath(), FString(TEXT("/events/live")));
+			TestEqual(TEXT("since"), Request.QueryParams.FindRef(TEXT("since")), FString(TEXT("4")));
+			TestEqual(TEXT("name"), Request.QueryParams.FindRef(TEXT("name")), FString(TEXT("a b")));
+			TestEqual(TEXT("Repeated header"), Request.Headers.FindRef(TEXT("x-tag")).Num(), 2);
+			TestEqual(TEXT("Body"), Request.Body.Num(), 5);
+		});
+
+		It("waits for the rest of truncated requests", [this]()
+		{
+			const ANSICHAR* Text = "PUT /items/1 HTTP/1.1\r\nContent-Length: 4\r\n\r\nbody";
+			const int32 TextLen = FCStringAnsi::Strlen(Text);
+
+			for (int32 Len = 0; Len < TextLen; ++Len)
+			{
+				FHttpServerRequest Request;
+				TestEqual(FString::Printf(TEXT("Cut at %d"), Len), Parse(Text, Request, Len), 0);
+			}
+
+			FHttpServerRequest Request;
+			TestEqual(TEXT("Whole"), Parse(Text, Request), TextLen);
+		});
+
+		It("leaves pipelined requests for the next call", [this]()
+		{
+			const ANSICHAR* First = "GET /a HTTP/1.1\r\n\r\n";
+			const FString Both = FString(First) + TEXT("GET /b HTTP/1.1\r\n\r\n");
+
+			FHttpServerRequest Request;
+			TestEqual(TEXT("First only"), Parse(TCHAR_TO_ANSI(*Both), Request), FCStringAnsi::Strlen(First));
+			TestEqual(TEXT("Path"), Request.RelativePath.GetPath(), FString(TEXT("/a")));
+		});
+
+		It("rejects malformed requests", [this]()
+		{
+			TestEqual(TEXT("No target"), Parse("GET HTTP/1.1\r\n\r\n"), -1);
+			TestEqual(TEXT("Relative target"), Parse("GET items HTTP/1.1\r\n\r\n"), -1);
+			TestEqual(TEXT("Unknown verb"), Parse("BREW /pot HTTP/1.1\r\n\r\n"), -1);
+			TestEqual(TEXT("Header without colon"), Parse("GET / HTTP/1.1\r\nbroken\r\n\r\n"), -1);
+			TestEqual(TEXT("Chunked body"), Parse("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"), -1);
+			TestEqual(TEXT("Negative length"), Parse("POST / HTTP/1.1\r\nContent-Length: -5\r\n\r\n"), -1);
+		});
+
+		It("rejects requests over the size limit before they are complete", [this]()
+		{
+			TestEqual(TEXT("Declared body"), Parse("POST / HTTP/1.1\r\nContent-Length: 4096\r\n\r\n"), -1);
+			TestEqual(TEXT("Largest int64 length"), Parse("POST / HTTP/1.1\r\nContent-Length: 9223372036854775807\r\n\r\n"), -1);
+			TestEqual(TEXT("Length past int64"), Parse("POST / HTTP/1.1\r\nContent-Length: 99999999999999999999\r\n\r\n"), -1);
+			TestEqual(TEXT("Conflicting lengths"), Parse("POST / HTTP/1.1\r\nContent-Length: 2\r\nContent-Length: 4\r\n\r\nbody"), -1);
+
+			const FString Head = FString(TEXT("GET / HTTP/1.1\r\nX-Long: ")) + FString::ChrN(MaxRequestSize, TEXT('a'));
+			TestEqual(TEXT("Endless headers"), Parse(TCHAR_TO_ANSI(*Head)), -1);
+		});
+	});
+}
+
+#endif
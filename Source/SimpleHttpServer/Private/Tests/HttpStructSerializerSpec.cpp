@@ -0,0 +1,239 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpStructSerializer.h"
+#include "HttpJsonSerializer.h"
+#include "SimpleHttpServerTestTypes.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	TArray<uint8> ToBytes(const ANSICHAR* Text)
+	{
+		return TArray<uint8>(reinterpret_cast<const uint8*>(Text), FCStringAnsi::Strlen(Text));
+	}
+
+	FSimpleHttpServerTestBody MakeTestBody()
+	{
+		FSimpleHttpServerTestBody Body;
+		Body.Count = 300;
+		Body.Name = TEXT("name \"quoted\"");
+		Body.Values = { 1, -2, 70000 };
+		Body.Tags = { TEXT("x"), TEXT("y") };
+		Body.Scores = { { TEXT("a"), 1 }, { TEXT("b"), -1 } };
+		Body.Time = FDateTime(2024, 5, 6, 7, 8, 9);
+		return Body;
+	}
+
+	const EHttpWireFormat AllFormats[] = { EHttpWireFormat::Json, EHttpWireFormat::MessagePack, EHttpWireFormat::Cbor };
+
+	const TCHAR* GetFormatName(EHttpWireFormat Format)
+	{
+		return FHttpStructSerializer::GetContentType(Format);
+	}
+}
+
+BEGIN_DEFINE_SPEC(FHttpStructSerializerSpec, "SimpleHttpServer.StructSerializer", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+	bool Read(TArrayView<const uint8> Bytes, EHttpWireFormat Format, FSimpleHttpServerTestBody& OutBody)
+	{
+		return FHttpStructSerializer::ReadStruct(Bytes, Format, OutBody);
+	}
+
+	void TestDuplicatesCollapsed(const FSimpleHttpServerTestBody& Body)
+	{
+		TestEqual(TEXT("Tags"), Body.Tags.Num(), 2);
+		TestTrue(TEXT("Tag x"), Body.Tags.Contains(TEXT("x")));
+		TestTrue(TEXT("Tag y"), Body.Tags.Contains(TEXT("y")));
+
+		TestEqual(TEXT("Scores"), Body.Scores.Num(), 2);
+		TestEqual(TEXT("Last duplicate wins"), Body.Scores.FindRef(TEXT("a")), 2);
+		TestEqual(TEXT("Score b"), Body.Scores.FindRef(TEXT("b")), 3);
+	}
+END_DEFINE_SPEC(FHttpStructSerializerSpec)
+
+void FHttpStructSerializerSpec::Define()
+{
+	Describe("AppendStruct", [this]()
+	{
+		It("writes fields, escaped strings and containers", [this]()
+		{
+			const FSimpleHttpServerTestBody Body = MakeTestBody();
+
+			TArray<uint8> Json;
+			FHttpJsonSerializer::AppendStruct(Json, Body);
+			const FString Text(FUTF8ToTCHAR(reinterpret_cast<const ANSICHAR*>(Json.GetData()), Json.Num()));
+
+			TestTrue(TEXT("Count"), Text.Contains(TEXT("\"count\":300")));
+			TestTrue(TEXT("Name"), Text.Contains(TEXT("\"name\":\"name \\\"quoted\\\"\"")));
+			TestTrue(TEXT("Values"), Text.Contains(TEXT("\"values\":[1,-2,70000]")));
+		});
+
+		It("writes structs with their own text form as strings", [this]()
+		{
+			const FSimpleHttpServerTestBody Body = MakeTestBody();
+
+			TArray<uint8> Json;
+			FHttpJsonSerializer::AppendStruct(Json, Body);
+			const FString Text(FUTF8ToTCHAR(reinterpret_cast<const ANSICHAR*>(Json.GetData()), Json.Num()));
+
+			TestTrue(TEXT("Time as string"), Text.Contains(FString::Printf(TEXT("\"time\":\"%s\""), *Body.Time.ToString())));
+		});
+	});
+
+	Describe("ReadStruct", [this]()
+	{
+		It("reads back what AppendStruct wrote in every format", [this]()
+		{
+			const FSimpleHttpServerTestBody Expected = MakeTestBody();
+			for (const EHttpWireFormat Format : AllFormats)
+			{
+				TArray<uint8> Bytes;
+				FHttpStructSerializer::AppendStruct(Bytes, Format, FSimpleHttpServerTestBody::StaticStruct(), &Expected);
+
+				FSimpleHttpServerTestBody Body;
+				if (!TestTrue(FString::Printf(TEXT("%s read"), GetFormatName(Format)), Read(Bytes, Format, Body)))
+				{
+					continue;
+				}
+
+				TestEqual(TEXT("Count"), Body.Count, Expected.Count);
+				TestEqual(TEXT("Name"), Body.Name, Expected.Name);
+				TestEqual(TEXT("Values"), Body.Values, Expected.Values);
+				TestTrue(TEXT("Tags"), Body.Tags.Num() == 2 && Body.Tags.Contains(TEXT("x")) && Body.Tags.Contains(TEXT("y")));
+				TestTrue(TEXT("Scores"), Body.Scores.OrderIndependentCompareEqual(Expected.Scores));
+				TestEqual(TEXT("Time"), Body.Time, Expected.Time);
+			}
+		});
+
+		It("rejects every truncated body without touching memory past it", [this]()
+		{
+			const FSimpleHttpServerTestBody Expected = MakeTestBody();
+			for (const EHttpWireFormat Format : AllFormats)
+			{
+				TArray<uint8> Bytes;
+				FHttpStructSerializer::AppendStruct(Bytes, Format, FSimpleHttpServerTestBody::StaticStruct(), &Expected);
+
+				for (int32 Len = 0; Len < Bytes.Num(); ++Len)
+				{
+					// Exact-size copy, so reading past the end shows up in memory checkers
+					const TArray<uint8> Truncated(Bytes.GetData(), Len);
+
+					FSimpleHttpServerTestBody Body;
+					TestFalse(FString::Printf(TEXT("%s cut at %d"), GetFormatName(Format), Len), Read(Truncated, Format, Body));
+				}
+			}
+		});
+
+		It("rejects malformed JSON", [this]()
+		{
+			const ANSICHAR* const Cases[] =
+			{
+				"",
+				"{",
+				"[1]",
+				"{\"count\":}",
+				"{\"count\":1,}",
+				"{\"count\" 1}",
+				"{\"name\":\"abc}",
+				"{\"values\":[1,2}",
+				"{\"count\":1}x",
+				"{\"count\":tru}",
+			};
+
+			for (const ANSICHAR* Case : Cases)
+			{
+				FSimpleHttpServerTestBody Body;
+				FString Error;
+				TestFalse(FString::Printf(TEXT("'%hs'"), Case), FHttpJsonSerializer::ReadStruct(ToBytes(Case), Body, &Error));
+				TestFalse(FString::Printf(TEXT("'%hs' has error"), Case), Error.IsEmpty());
+			}
+		});
+
+		It("rejects deep nesting instead of recursing", [this]()
+		{
+			FString Json = TEXT("{\"unknown\":");
+			for (int32 Index = 0; Index < 10000; ++Index)
+			{
+				Json += TEXT("[");
+			}
+
+			FTCHARToUTF8 Utf8(*Json);
+			FSimpleHttpServerTestBody Body;
+			TestFalse(TEXT("Nested"), FHttpJsonSerializer::ReadStruct(TArrayView<const uint8>(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length()), Body));
+		});
+
+		It("rejects malformed MessagePack and CBOR", [this]()
+		{
+			// Reserved type, map claiming more entries than bytes, string longer than the body
+			const TArray<uint8> MessagePackCases[] =
+			{
+				{ 0xc1 },
+				{ 0xdf, 0xff, 0xff, 0xff, 0xff },
+				{ 0x81, 0xdb, 0x7f, 0xff, 0xff, 0xff, 'c' },
+				{ 0x80, 0x00 },
+			};
+
+			for (const TArray<uint8>& Case : MessagePackCases)
+			{
+				FSimpleHttpServerTestBody Body;
+				TestFalse(TEXT("MessagePack"), Read(Case, EHttpWireFormat::MessagePack, Body));
+			}
+
+			// Indefinite length map, array claiming more entries than bytes, text longer than the body, trailing data
+			const TArray<uint8> CborCases[] =
+			{
+				{ 0xbf, 0xff },
+				{ 0xa1, 0x66, 'v', 'a', 'l', 'u', 'e', 's', 0x9b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff },
+				{ 0xa1, 0x7b, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff },
+				{ 0xa0, 0x00 },
+			};
+
+			for (const TArray<uint8>& Case : CborCases)
+			{
+				FSimpleHttpServerTestBody Body;
+				TestFalse(TEXT("CBOR"), Read(Case, EHttpWireFormat::Cbor, Body));
+			}
+		});
+	});
+
+	Describe("duplicate keys", [this]()
+	{
+		It("keep JSON sets and maps consistent", [this]()
+		{
+			FSimpleHttpServerTestBody Body;
+			TestTrue(TEXT("Read"), FHttpJsonSerializer::ReadStruct(ToBytes("{\"tags\":[\"x\",\"x\",\"y\"],\"scores\":{\"a\":1,\"a\":2,\"b\":3}}"), Body));
+			TestDuplicatesCollapsed(Body);
+		});
+
+		It("keep MessagePack sets and maps consistent", [this]()
+		{
+			const TArray<uint8> Bytes =
+			{
+				0x82,
+				0xa4, 't', 'a', 'g', 's', 0x93, 0xa1, 'x', 0xa1, 'x', 0xa1, 'y',
+				0xa6, 's', 'c', 'o', 'r', 'e', 's', 0x83, 0xa1, 'a', 0x01, 0xa1, 'a', 0x02, 0xa1, 'b', 0x03,
+			};
+
+			FSimpleHttpServerTestBody Body;
+			TestTrue(TEXT("Read"), Read(Bytes, EHttpWireFormat::MessagePack, Body));
+			TestDuplicatesCollapsed(Body);
+		});
+
+		It("keep CBOR sets and maps consistent", [this]()
+		{
+			const TArray<uint8> Bytes =
+			{
+				0xa2,
+				0x64, 't', 'a', 'g', 's', 0x83, 0x61, 'x', 0x61, 'x', 0x61, 'y',
+				0x66, 's', 'c', 'o', 'r', 'e', 's', 0xa3, 0x61, 'a', 0x01, 0x61, 'a', 0x02, 0x61, 'b', 0x03,
+			};
+
+			FSimpleHttpServerTestBody Body;
+			TestTrue(TEXT("Read"), Read(Bytes, EHttpWireFormat::Cbor, Body));
+			TestDuplicatesCollapsed(Body);
+		});
+	});
+}
+
+#endif
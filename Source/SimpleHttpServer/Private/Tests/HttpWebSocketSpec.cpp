@@ -0,0 +1,107 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpWebSocket.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// Masked client frame as a browser sends it
+	TArray<uint8> MakeClientFrame(uint8 Opcode, uint64 PayloadSize)
+	{
+		TArray<uint8> Frame;
+		Frame.Add(0x80 | Opcode);
+
+		if (PayloadSize < 126)
+		{
+			Frame.Add(0x80 | (uint8)PayloadSize);
+		}
+		else if (PayloadSize <= MAX_uint16)
+		{
+			Frame.Add(0x80 | 126);
+			Frame.Add((uint8)(PayloadSize >> 8));
+			Frame.Add((uint8)PayloadSize);
+		}
+		else
+		{
+			Frame.Add(0x80 | 127);
+			for (int32 Shift = 56; Shift >= 0; Shift -= 8)
+			{
+				Frame.Add((uint8)(PayloadSize >> Shift));
+			}
+		}
+
+		Frame.Append({ 1, 2, 3, 4 });
+		return Frame;
+	}
+}
+
+BEGIN_DEFINE_SPEC(FHttpWebSocketSpec, "SimpleHttpServer.WebSocket", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+END_DEFINE_SPEC(FHttpWebSocketSpec)
+
+void FHttpWebSocketSpec::Define()
+{
+	Describe("ParseFrameHeader", [this]()
+	{
+		It("reads every payload length encoding", [this]()
+		{
+			const uint64 Sizes[] = { 0, 125, 126, 65535, 65536, 1ull << 40 };
+			const int32 HeaderSizes[] = { 6, 6, 8, 8, 14, 14 };
+
+			for (int32 Index = 0; Index < UE_ARRAY_COUNT(Sizes); ++Index)
+			{
+				FHttpWebSocketChannel::FFrameHeader Header;
+				const TArray<uint8> Frame = MakeClientFrame(FHttpWebSocketChannel::OpBinary, Sizes[Index]);
+
+				if (TestTrue(FString::Printf(TEXT("Parsed %llu"), Sizes[Index]), FHttpWebSocketChannel::ParseFrameHeader(Frame, Header)))
+				{
+					TestTrue(TEXT("Final"), Header.bFinal);
+					TestTrue(TEXT("Masked"), Header.bMasked);
+					TestEqual(TEXT("Opcode"), Header.Opcode, (uint8)FHttpWebSocketChannel::OpBinary);
+					TestEqual(TEXT("Payload size"), Header.PayloadSize, Sizes[Index]);
+					TestEqual(TEXT("Header size"), Header.HeaderSize, HeaderSizes[Index]);
+					TestTrue(TEXT("Mask"), Header.Mask[0] == 1 && Header.Mask[3] == 4);
+				}
+			}
+		});
+
+		It("needs the whole header of truncated frames", [this]()
+		{
+			for (const uint64 Size : { 5ull, 300ull, 70000ull })
+			{
+				const TArray<uint8> Frame = MakeClientFrame(FHttpWebSocketChannel::OpText, Size);
+				for (int32 Len = 0; Len < Frame.Num(); ++Len)
+				{
+					// Exact-size copy, so reading past the end shows up in memory checkers
+					const TArray<uint8> Truncated(Frame.GetData(), Len);
+
+					FHttpWebSocketChannel::FFrameHeader Header;
+					TestFalse(FString::Printf(TEXT("Size %llu cut at %d"), Size, Len), FHttpWebSocketChannel::ParseFrameHeader(Truncated, Header));
+				}
+			}
+		});
+
+		It("reports unmasked frames without a mask key", [this]()
+		{
+			const uint8 Frame[] = { 0x81, 0x02, 'h', 'i' };
+
+			FHttpWebSocketChannel::FFrameHeader Header;
+			TestTrue(TEXT("Parsed"), FHttpWebSocketChannel::ParseFrameHeader(Frame, Header));
+			TestFalse(TEXT("Masked"), Header.bMasked);
+			TestEqual(TEXT("Header size"), Header.HeaderSize, 2);
+		});
+
+		It("reads fragment and control bits", [this]()
+		{
+			const uint8 Frame[] = { 0x09, 0x80, 0, 0, 0, 0 };
+
+			FHttpWebSocketChannel::FFrameHeader Header;
+			TestTrue(TEXT("Parsed"), FHttpWebSocketChannel::ParseFrameHeader(Frame, Header));
+			TestFalse(TEXT("Final"), Header.bFinal);
+			TestEqual(TEXT("Opcode"), Header.Opcode, (uint8)FHttpWebSocketChannel::OpPing);
+		});
+	});
+}
+
+#endif
@@ -0,0 +1,111 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "SimpleHttpRouteTrie.h"
+#include "SimpleHttpServer.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FSimpleHttpRouteTrieSpec, "SimpleHttpServer.RouteTrie", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+	FSimpleHttpRouteTrie Trie;
+	FHttpRouteMatch Match;
+
+	static constexpr uint8 Get = (uint8)ENativeHttpServerRequestVerbs::GET;
+	static constexpr uint8 Post = (uint8)ENativeHttpServerRequestVerbs::POST;
+END_DEFINE_SPEC(FSimpleHttpRouteTrieSpec)
+
+void FSimpleHttpRouteTrieSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		Trie.Reset();
+		Match = FHttpRouteMatch();
+	});
+
+	Describe("Find", [this]()
+	{
+		It("matches static routes case-insensitively", [this]()
+		{
+			Trie.Insert(TEXT("/users/me"), Get, 0);
+			Trie.Insert(TEXT("/users"), Get, 1);
+
+			TestTrue(TEXT("Found"), Trie.Find(TEXT("/USERS/Me"), Get, Match));
+			TestEqual(TEXT("Route"), Match.RouteIndex, 0);
+
+			TestTrue(TEXT("Found prefix route"), Trie.Find(TEXT("/users"), Get, Match));
+			TestEqual(TEXT("Prefix route"), Match.RouteIndex, 1);
+
+			TestFalse(TEXT("Partial segment"), Trie.Find(TEXT("/user"), Get, Match));
+			TestEqual(TEXT("No route"), Match.RouteIndex, INDEX_NONE);
+		});
+
+		It("prefers static text over parameters and parameters over wildcards", [this]()
+		{
+			Trie.Insert(TEXT("/users/:id"), Get, 0);
+			Trie.Insert(TEXT("/users/me"), Get, 1);
+			Trie.Insert(TEXT("/users/*rest"), Get, 2);
+
+			TestTrue(TEXT("Static"), Trie.Find(TEXT("/users/me"), Get, Match) && Match.RouteIndex == 1 && Match.Params.Num() == 0);
+			TestTrue(TEXT("Parameter"), Trie.Find(TEXT("/users/42"), Get, Match) && Match.RouteIndex == 0);
+			TestEqual(TEXT("Parameter value"), FString(Match.FindParam(TEXT("id"))), FString(TEXT("42")));
+			TestTrue(TEXT("Wildcard"), Trie.Find(TEXT("/users/42/posts/7"), Get, Match) && Match.RouteIndex == 2);
+			TestEqual(TEXT("Wildcard value"), FString(Match.FindParam(TEXT("rest"))), FString(TEXT("42/posts/7")));
+		});
+
+		It("backtracks from a static branch to a parameter without leaving its values behind", [this]()
+		{
+			Trie.Insert(TEXT("/a/b/d"), Get, 0);
+			Trie.Insert(TEXT("/a/:x/c"), Get, 1);
+			Trie.Insert(TEXT("/a/:x/:y/e"), Get, 2);
+
+			TestTrue(TEXT("Found"), Trie.Find(TEXT("/a/b/c"), Get, Match));
+			TestEqual(TEXT("Route"), Match.RouteIndex, 1);
+			TestEqual(TEXT("Params"), Match.Params.Num(), 1);
+			TestEqual(TEXT("x"), FString(Match.FindParam(TEXT("x"))), FString(TEXT("b")));
+
+			TestTrue(TEXT("Found deeper"), Trie.Find(TEXT("/a/b/d/e"), Get, Match));
+			TestEqual(TEXT("Deeper route"), Match.RouteIndex, 2);
+			TestEqual(TEXT("Deeper params"), Match.Params.Num(), 2);
+			TestEqual(TEXT("y"), FString(Match.FindParam(TEXT("y"))), FString(TEXT("d")));
+
+			TestFalse(TEXT("Dead end"), Trie.Find(TEXT("/a/b/x/y"), Get, Match));
+			TestEqual(TEXT("No params after miss"), Match.Params.Num(), 0);
+		});
+
+		It("doesn't match empty parameter segments", [this]()
+		{
+			Trie.Insert(TEXT("/items/:id/tags"), Get, 0);
+
+			TestFalse(TEXT("Empty segment"), Trie.Find(TEXT("/items//tags"), Get, Match));
+		});
+
+		It("dispatches by verb", [this]()
+		{
+			Trie.Insert(TEXT("/items"), Get, 0);
+			Trie.Insert(TEXT("/items"), Post, 1);
+
+			TestTrue(TEXT("GET"), Trie.Find(TEXT("/items"), Get, Match) && Match.RouteIndex == 0);
+			TestTrue(TEXT("POST"), Trie.Find(TEXT("/items"), Post, Match) && Match.RouteIndex == 1);
+			TestFalse(TEXT("PUT"), Trie.Find(TEXT("/items"), (uint8)ENativeHttpServerRequestVerbs::PUT, Match));
+			TestFalse(TEXT("Several verbs"), Trie.Find(TEXT("/items"), Get | Post, Match));
+		});
+	});
+
+	Describe("Insert", [this]()
+	{
+		It("rejects malformed patterns", [this]()
+		{
+			AddExpectedError(TEXT("unnamed parameter"), EAutomationExpectedErrorFlags::Contains, 1);
+			AddExpectedError(TEXT("wildcard must be the last segment"), EAutomationExpectedErrorFlags::Contains, 1);
+			AddExpectedError(TEXT("conflicts with already bound parameter"), EAutomationExpectedErrorFlags::Contains, 1);
+
+			TestFalse(TEXT("Unnamed parameter"), Trie.Insert(TEXT("/users/:"), Get, 0));
+			TestFalse(TEXT("Wildcard in the middle"), Trie.Insert(TEXT("/files/*path/meta"), Get, 0));
+
+			TestTrue(TEXT("First parameter"), Trie.Insert(TEXT("/users/:id"), Get, 0));
+			TestFalse(TEXT("Other name at the same place"), Trie.Insert(TEXT("/users/:name/posts"), Get, 1));
+		});
+	});
+}
+
+#endif
@@ -0,0 +1,109 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "SimpleHttpServer.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+BEGIN_DEFINE_SPEC(FSimpleHttpServerQueueSpec, "SimpleHttpServer.GameThreadQueue", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+	USimpleHttpServer* Server = nullptr;
+
+	// Order in which queued work ran
+	TArray<int32> Ran;
+
+	void Enqueue(int32 Id, float SleepSeconds = 0.0f)
+	{
+		Server->EnqueueGameThreadRequest([this, Id, SleepSeconds]()
+		{
+			if (SleepSeconds > 0.0f)
+			{
+				FPlatformProcess::Sleep(SleepSeconds);
+			}
+
+			Ran.Add(Id);
+		});
+	}
+
+	void Tick()
+	{
+		Server->Tick(0.0f);
+	}
+END_DEFINE_SPEC(FSimpleHttpServerQueueSpec)
+
+void FSimpleHttpServerQueueSpec::Define()
+{
+	BeforeEach([this]()
+	{
+		Server = NewObject<USimpleHttpServer>();
+		Server->AddToRoot();
+		Ran.Reset();
+	});
+
+	AfterEach([this]()
+	{
+		Server->RemoveFromRoot();
+		Server = nullptr;
+	});
+
+	It("runs everything in order without a budget", [this]()
+	{
+		Server->GameThreadBudgetMs = 0.0f;
+		for (int32 Id = 0; Id < 5; ++Id)
+		{
+			Enqueue(Id);
+		}
+
+		TestEqual(TEXT("Queued"), Server->GetQueueStats().QueueDepth, 5);
+		Tick();
+
+		TestEqual(TEXT("Order"), Ran, TArray<int32>{ 0, 1, 2, 3, 4 });
+
+		const FSimpleHttpServerQueueStats Stats = Server->GetQueueStats();
+		TestEqual(TEXT("Processed"), Stats.ProcessedLastFrame, 5);
+		TestEqual(TEXT("Deferred"), Stats.DeferredLastFrame, 0);
+		TestEqual(TEXT("Depth"), Stats.QueueDepth, 0);
+	});
+
+	It("defers the rest when the budget runs out, but runs one request each tick", [this]()
+	{
+		// Every request takes longer than the whole budget
+		Server->GameThreadBudgetMs = 1.0f;
+		for (int32 Id = 0; Id < 3; ++Id)
+		{
+			Enqueue(Id, 0.005f);
+		}
+
+		Tick();
+		TestEqual(TEXT("First tick ran one"), Ran.Num(), 1);
+		TestEqual(TEXT("First tick deferred"), Server->GetQueueStats().DeferredLastFrame, 2);
+
+		Tick();
+		Tick();
+		TestEqual(TEXT("Order"), Ran, TArray<int32>{ 0, 1, 2 });
+		TestEqual(TEXT("Depth"), Server->GetQueueStats().QueueDepth, 0);
+	});
+
+	It("counts a request waiting several frames as deferred once", [this]()
+	{
+		Server->GameThreadBudgetMs = 1.0f;
+		for (int32 Id = 0; Id < 3; ++Id)
+		{
+			Enqueue(Id, 0.005f);
+		}
+
+		Tick();
+		TestEqual(TEXT("After first tick"), Server->GetQueueStats().TotalDeferred, (int64)2);
+
+		Tick();
+		TestEqual(TEXT("After second tick"), Server->GetQueueStats().TotalDeferred, (int64)2);
+
+		Enqueue(3, 0.005f);
+		Tick();
+		TestEqual(TEXT("New request deferred behind the last one"), Server->GetQueueStats().TotalDeferred, (int64)3);
+
+		Tick();
+		TestEqual(TEXT("Drained"), Ran.Num(), 4);
+	});
+}
+
+#endif
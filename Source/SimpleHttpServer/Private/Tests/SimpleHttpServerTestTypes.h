@@ -0,0 +1,32 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "SimpleHttpServerTestTypes.generated.h"
+
+// Body read by serializer specs, covers containers hashed while reading and structs with their own text form
+USTRUCT()
+struct FSimpleHttpServerTestBody
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Count = 0;
+
+	UPROPERTY()
+	FString Name;
+
+	UPROPERTY()
+	TArray<int32> Values;
+
+	UPROPERTY()
+	TSet<FString> Tags;
+
+	UPROPERTY()
+	TMap<FString, int32> Scores;
+
+	UPROPERTY()
+	FDateTime Time;
+};
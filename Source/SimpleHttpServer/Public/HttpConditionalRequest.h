@@ -0,0 +1,44 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+
+/**
+ * Validators sent by client (If-None-Match, If-Modified-Since) and the 304 logic around them.
+ * Header values are copied, so it can be kept until the response is ready.
+ */
+class SIMPLEHTTPSERVER_API FHttpConditionalRequest
+{
+public:
+	FHttpConditionalRequest() = default;
+	explicit FHttpConditionalRequest(const FHttpServerRequest& Request);
+
+	bool IsConditional() const { return !IfNoneMatch.IsEmpty() || !IfModifiedSince.IsEmpty(); }
+
+	// True if client copy described by response headers is still valid. If-None-Match wins over If-Modified-Since.
+	bool IsNotModified(const TMap<FString, TArray<FString>>& ResponseHeaders) const;
+
+	// 304 response without body, keeping validators and caching headers of the full response
+	static TUniquePtr<FHttpServerResponse> MakeNotModified(const TMap<FString, TArray<FString>>& ResponseHeaders);
+
+	// Strong ETag from content hash
+	static FString ComputeETag(TArrayView<const uint8> Body);
+
+	// Strong ETag from caller supplied version
+	static FString MakeVersionETag(uint64 Version);
+
+	// Add computed ETag if response doesn't have one
+	static void AddETagIfMissing(FHttpServerResponse& Response);
+
+	static const TCHAR* ETagHeader;
+	static const TCHAR* LastModifiedHeader;
+
+private:
+	static FStringView FindHeader(const TMap<FString, TArray<FString>>& Headers, const TCHAR* Name);
+
+	FString IfNoneMatch;
+	FString IfModifiedSince;
+};
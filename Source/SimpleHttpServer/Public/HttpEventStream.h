@@ -0,0 +1,46 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FHttpStreamConnection;
+
+/**
+ * Server-sent events channel. Clients connect with EventSource and stay subscribed until they disconnect.
+ * Every event is formatted once into a shared buffer, and the same buffer is queued to all subscribers.
+ * Publishing is thread-safe.
+ */
+class SIMPLEHTTPSERVER_API FHttpEventStream : public TSharedFromThis<FHttpEventStream>
+{
+public:
+	// Send event to all subscribers. EventName can be empty for default "message" event, line breaks are removed from it.
+	// Multiline Data is split into "data:" lines.
+	void Publish(FStringView EventName, FStringView Data);
+
+	// Send already formatted event, e.g. built once and published to several streams
+	void Publish(const TSharedRef<const TArray<uint8>>& Event);
+
+	// Comment line that keeps proxies from closing idle connections and lets the server notice dead clients
+	void SendKeepAlive();
+
+	// Format event as it is sent on the wire
+	TSharedRef<const TArray<uint8>> FormatEvent(FStringView EventName, FStringView Data);
+
+	int32 GetNumSubscribers() const;
+
+	// Called on the stream server thread for every new client
+	void Subscribe(const TSharedRef<FHttpStreamConnection>& Connection);
+
+	// Subscribers with more bytes waiting than this are disconnected, so one slow client doesn't hold memory for every event.
+	// Browsers reconnect by themselves.
+	int64 MaxQueuedBytes = 4 * 1024 * 1024;
+
+private:
+	void Unsubscribe(uint32 ConnectionId);
+
+	mutable FCriticalSection SubscribersLock;
+	TArray<TSharedRef<FHttpStreamConnection>> Subscribers;
+
+	std::atomic<uint64> NextEventId{ 1 };
+};
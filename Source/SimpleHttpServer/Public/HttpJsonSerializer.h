@@ -0,0 +1,43 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Writes UStruct and UObject values as JSON straight into a UTF-8 buffer, and reads structs back, without FJsonObject trees.
+ * Property list, kinds and escaped field names of a type are collected once into a plan and cached,
+ * so repeated values of the same type only read memory and append bytes.
+ * Field names follow FJsonObjectConverter, so output matches UStructToJsonObjectString.
+ * Thread-safe for structs. Objects should be written on the game thread.
+ */
+class SIMPLEHTTPSERVER_API FHttpJsonSerializer
+{
+public:
+	static void AppendStruct(TArray<uint8>& Out, const UStruct* Struct, const void* Data);
+
+	template<typename T>
+	static void AppendStruct(TArray<uint8>& Out, const T& Value)
+	{
+		AppendStruct(Out, T::StaticStruct(), &Value);
+	}
+
+	// Editable and Blueprint visible properties of object. Null writes null.
+	static void AppendObject(TArray<uint8>& Out, const UObject* Object);
+
+	// Any single property value, e.g. Blueprint wildcard
+	static void AppendProperty(TArray<uint8>& Out, const FProperty* Property, const void* Value);
+
+	// Parse JSON object from UTF-8 into Data, which must be an initialized Struct. Missing members keep their values,
+	// unknown members are ignored and object references are left as they are. Safe from any thread.
+	static bool ReadStruct(TArrayView<const uint8> Json, const UScriptStruct* Struct, void* Data, FString* OutError = nullptr);
+
+	template<typename T>
+	static bool ReadStruct(TArrayView<const uint8> Json, T& OutValue, FString* OutError = nullptr)
+	{
+		return ReadStruct(Json, T::StaticStruct(), &OutValue, OutError);
+	}
+
+	// Quoted and escaped string
+	static void AppendString(TArray<uint8>& Out, FStringView Value);
+};
@@ -0,0 +1,55 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpRouteCompletion.h"
+
+class FNativeHttpServerRequestView;
+
+/**
+ * Versioned state for long-polling clients.
+ * Client asks with "since=<version>". If the state has another version it is answered right away, otherwise the request is parked
+ * without holding any thread until Publish advances the version or the wait times out.
+ * The answer carries the version in "x-poll-version" header, timeouts are answered with 204.
+ * Publishing is thread-safe.
+ */
+class SIMPLEHTTPSERVER_API FHttpLongPollTopic
+{
+public:
+	// Store new state, advance version and answer every parked request
+	void Publish(TArray<uint8>&& Payload, const FString& ContentType = TEXT("application/json"));
+	void Publish(FStringView Text, const FString& ContentType = TEXT("application/json"));
+
+	uint64 GetVersion() const;
+
+	int32 GetNumWaiting() const;
+
+	// Answer request now or park it
+	void HandleRequest(const FNativeHttpServerRequestView& Request, FHttpRouteCompletion Completion);
+
+	// Answer parked requests waiting longer than TimeoutSeconds. Called on server tick.
+	void ExpireWaiters(double Now);
+
+	float TimeoutSeconds = 25.0f;
+
+	static const TCHAR* VersionHeader;
+
+private:
+	struct FWaiter
+	{
+		double Deadline = 0.0;
+		FHttpRouteCompletion Completion;
+	};
+
+	// Caller holds Lock
+	TUniquePtr<FHttpServerResponse> MakeStateResponse() const;
+
+	mutable FCriticalSection Lock;
+
+	uint64 Version = 0;
+	TSharedPtr<const TArray<uint8>> Payload;
+	FString ContentType;
+
+	TArray<FWaiter> Waiters;
+};
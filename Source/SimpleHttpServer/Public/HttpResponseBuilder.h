@@ -0,0 +1,58 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpServerResponse.h"
+
+/**
+ * Builds the response that is handed to HTTPServer module.
+ * Text is converted to UTF-8 straight into the response body, and the response is moved out, never copied.
+ */
+class SIMPLEHTTPSERVER_API FHttpResponseBuilder
+{
+public:
+	explicit FHttpResponseBuilder(EHttpServerResponseCodes Code = EHttpServerResponseCodes::Ok);
+
+	FHttpResponseBuilder& SetCode(EHttpServerResponseCodes Code);
+
+	// Content type with ";charset=utf-8" appended
+	FHttpResponseBuilder& SetTextContentType(FStringView ContentType);
+
+	FHttpResponseBuilder& SetHeader(FString Name, FString Value);
+	FHttpResponseBuilder& AddHeader(FString Name, FString Value);
+
+	// Reserve body memory up front when final size is known
+	FHttpResponseBuilder& Reserve(int32 NumBytes);
+
+	FHttpResponseBuilder& Append(TArrayView<const uint8> Bytes);
+	FHttpResponseBuilder& Append(FUtf8StringView Text);
+
+	// Convert TCHAR text to UTF-8 directly into the body
+	FHttpResponseBuilder& Append(FStringView Text);
+
+	FHttpResponseBuilder& SetBody(TArray<uint8>&& Bytes);
+
+	// ETag lets client revalidate with If-None-Match and get 304 without body
+	FHttpResponseBuilder& SetETag(FString ETag);
+	FHttpResponseBuilder& SetVersionETag(uint64 Version);
+
+	// Hash current body. Call after the body is complete.
+	FHttpResponseBuilder& ComputeETag();
+
+	FHttpResponseBuilder& SetLastModified(const FDateTime& Time);
+
+	// Direct access to the body buffer, for serializers writing in place
+	TArray<uint8>& GetBody() { return Response->Body; }
+
+	FHttpServerResponse& GetResponse() { return *Response; }
+
+	// Give the response away. The builder is empty after this.
+	TUniquePtr<FHttpServerResponse> Build();
+
+	// Append TCHAR text converted to UTF-8 to any byte buffer
+	static void AppendUtf8(TArray<uint8>& Buffer, FStringView Text);
+
+private:
+	TUniquePtr<FHttpServerResponse> Response;
+};
@@ -0,0 +1,96 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+
+#include "HttpResponseCache.generated.h"
+
+// How responses of a route are cached. Only successful GET responses are cached.
+USTRUCT(BlueprintType)
+struct FHttpRouteCachePolicy
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cache")
+	/** How long cached response is served. Zero or less disables caching */
+	float TtlSeconds = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cache")
+	/** Query parameters that make a response different. Others are ignored */
+	TArray<FString> QueryParams;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cache")
+	/** Request headers that make a response different. Others are ignored */
+	TArray<FString> Headers;
+};
+
+// Cached response. Immutable once stored, shared between requests.
+struct SIMPLEHTTPSERVER_API FHttpCachedResponse
+{
+	EHttpServerResponseCodes Code = EHttpServerResponseCodes::Ok;
+	TMap<FString, TArray<FString>> Headers;
+	TArray<uint8> Body;
+
+	// Hash of Body. Encoded bodies are shared between entries with the same content.
+	uint64 ContentVersion = 0;
+
+	// Request path without query, used for invalidation
+	FString RequestPath;
+
+	double ExpireTime = 0.0;
+
+	// Copy of cached response. BodyOverride replaces body, e.g. with encoded one.
+	TUniquePtr<FHttpServerResponse> MakeResponse(const TArray<uint8>* BodyOverride = nullptr) const;
+};
+
+/**
+ * Response cache shared by all routes of a server. Thread-safe.
+ */
+class SIMPLEHTTPSERVER_API FHttpResponseCache
+{
+public:
+	// Entries above this count are not stored until expired ones are purged
+	int32 MaxEntries = 4096;
+
+	// Verb, path, wire format negotiated from Accept and the query params and headers of the policy
+	static FString MakeKey(const FHttpServerRequest& Request, FStringView RequestPath, const FHttpRouteCachePolicy& Policy);
+
+	// Null if there is no entry or it is expired
+	TSharedPtr<const FHttpCachedResponse> Find(const FString& Key);
+
+	// Stored entry, or null if caching is off or cache is full
+	TSharedPtr<const FHttpCachedResponse> Store(const FString& Key, FStringView RequestPath, const FHttpServerResponse& Response, float TtlSeconds);
+
+	// Remove entries of exactly this request path, with any query
+	void Invalidate(FStringView RequestPath);
+
+	// Remove entries of every request path starting with Prefix
+	void InvalidatePrefix(FStringView Prefix);
+
+	void Clear();
+
+	// Encoded (compressed) body by content version and encoding. Empty array means encoding didn't make it smaller.
+	TSharedPtr<const TArray<uint8>> FindEncodedBody(uint64 ContentVersion, FName Encoding) const;
+
+	void StoreEncodedBody(uint64 ContentVersion, FName Encoding, TSharedRef<const TArray<uint8>> EncodedBody);
+
+	// Max number of encoded bodies kept. The oldest are dropped first.
+	int32 MaxEncodedBodies = 256;
+
+	int32 Num() const;
+
+private:
+	void PurgeExpired(double Now);
+
+	mutable FRWLock Lock;
+	TMap<FString, TSharedRef<const FHttpCachedResponse>> Entries;
+
+	// Encoded bodies outlive entries, so content that didn't change since expiry isn't compressed again
+	typedef TPair<uint64, FName> FEncodedBodyKey;
+	TMap<FEncodedBodyKey, TSharedRef<const TArray<uint8>>> EncodedBodies;
+	TArray<FEncodedBodyKey> EncodedBodiesOrder;
+};
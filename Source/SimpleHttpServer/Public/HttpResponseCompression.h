@@ -0,0 +1,42 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "HttpResultCallback.h"
+
+class FHttpResponseCache;
+struct FHttpCachedResponse;
+
+/**
+ * Content-Encoding negotiation and compression of response bodies. Uses engine FCompression (zlib).
+ */
+class SIMPLEHTTPSERVER_API FHttpResponseCompression
+{
+public:
+	// Best encoding accepted by client: NAME_Gzip, NAME_Zlib (HTTP "deflate") or NAME_None
+	static FName NegotiateEncoding(const FHttpServerRequest& Request);
+
+	// Only textual content types that are not encoded yet and are at least MinSize bytes
+	static bool ShouldCompress(const FHttpServerResponse& Response, int32 MinSize);
+	static bool ShouldCompress(const TMap<FString, TArray<FString>>& Headers, int32 BodySize, int32 MinSize);
+
+	// Compress response body in place. Returns false and keeps response as is if compression didn't help.
+	static bool Compress(FHttpServerResponse& Response, FName Encoding);
+
+	// Compress into OutBytes without touching response. Returns false if compression didn't help.
+	static bool CompressBody(TArrayView<const uint8> Body, FName Encoding, TArray<uint8>& OutBytes);
+
+	// Set Content-Encoding and Vary headers for compressed body. Strong ETag is turned into weak one, as the bytes differ from identity encoding.
+	static void SetEncodingHeaders(FHttpServerResponse& Response, FName Encoding);
+
+	// Wrap callback, so that responses worth compressing are compressed on a worker thread before they are sent
+	static FHttpResultCallback MakeCompressingCallback(FName Encoding, int32 MinSize, FHttpResultCallback OnComplete);
+
+	// Answer with cached response in given encoding. Each content version is compressed once per encoding, on a worker thread.
+	static void CompleteFromCache(const TSharedRef<FHttpResponseCache>& Cache, const TSharedRef<const FHttpCachedResponse>& CachedResponse, FName Encoding, const FHttpResultCallback& OnComplete);
+
+	static const TCHAR* GetEncodingHeaderValue(FName Encoding);
+};
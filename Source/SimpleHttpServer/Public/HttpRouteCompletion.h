@@ -0,0 +1,50 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpResultCallback.h"
+#include "HttpServerResponse.h"
+
+struct FNativeHttpServerResponse;
+class FHttpResponseBuilder;
+
+/**
+ * Completion handle passed to native route handlers.
+ * It can be copied, stored and fired later from any thread. Only the first Complete() call is sent to the client.
+ * If every copy is destroyed without completing, the client receives 500 instead of waiting for a timeout.
+ */
+class SIMPLEHTTPSERVER_API FHttpRouteCompletion
+{
+public:
+	FHttpRouteCompletion() = default;
+	explicit FHttpRouteCompletion(const FHttpResultCallback& OnComplete);
+
+	// Send response to client. Safe to call from any thread, the response is always handed to the HTTPServer module on the game thread.
+	void Complete(TUniquePtr<FHttpServerResponse>&& Response) const;
+
+	void Complete(FNativeHttpServerResponse&& Response) const;
+
+	void Complete(FHttpResponseBuilder&& Builder) const;
+
+	// Shortcut to send an empty response with given code
+	void CompleteWithCode(EHttpServerResponseCodes Code) const;
+
+	bool IsCompleted() const;
+
+	bool IsValid() const { return State.IsValid(); }
+
+	// Hand the response to the HTTPServer module, marshalling to the game thread if needed.
+	static void CompleteOnGameThread(const FHttpResultCallback& OnComplete, TUniquePtr<FHttpServerResponse>&& Response);
+
+private:
+	struct FState
+	{
+		~FState();
+
+		FHttpResultCallback OnComplete;
+		std::atomic<bool> bCompleted{ false };
+	};
+
+	TSharedPtr<FState, ESPMode::ThreadSafe> State;
+};
@@ -0,0 +1,112 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpResultCallback.h"
+#include <atomic>
+
+/**
+ * Per-route request counters and latency histograms.
+ * Every thread records into its own storage with plain relaxed stores, so recording never locks or contends.
+ * Storage of all threads is merged only when metrics are exported.
+ */
+class SIMPLEHTTPSERVER_API FHttpServerMetrics
+{
+public:
+	// Routes beyond this are not recorded
+	static constexpr int32 MaxRoutes = 4096;
+
+	FHttpServerMetrics();
+	~FHttpServerMetrics();
+
+	FHttpServerMetrics(const FHttpServerMetrics&) = delete;
+	FHttpServerMetrics& operator=(const FHttpServerMetrics&) = delete;
+
+	// Id of route pattern. The same pattern keeps its id when routes are bound again.
+	int32 RegisterRoute(const FString& RoutePattern);
+
+	// Count response sent to client. Safe from any thread.
+	void RecordResponse(int32 RouteId, int32 StatusCode, int64 BytesIn, int64 BytesOut);
+
+	// Record time spent waiting for a handler thread and running the handler. Safe from any thread.
+	void RecordHandler(int32 RouteId, uint64 QueueWaitCycles, uint64 HandlerCycles);
+
+	// Wrap completion so the response is counted when it is handed to the client
+	static FHttpResultCallback MakeRecordingCallback(const TSharedRef<FHttpServerMetrics>& Metrics, int32 RouteId, int64 BytesIn, FHttpResultCallback&& OnComplete);
+
+	// Body bytes of all routes since start. Cheaper than Export, fine to call every frame.
+	void GetTotalBytes(uint64& OutBytesIn, uint64& OutBytesOut) const;
+
+	// Merge all threads and write Prometheus text exposition format
+	void Export(TArray<uint8>& Out) const;
+
+private:
+	struct FHistogram;
+	struct FRouteCounters;
+	struct FShard;
+
+	// Storage of calling thread, created on first use
+	FShard& GetThreadShard();
+
+	FRouteCounters* FindCounters(int32 RouteId);
+
+	// Unique for the process, so thread caches never mistake a new instance for a destroyed one
+	const uint64 InstanceId;
+
+	mutable FCriticalSection Lock;
+
+	TMap<FString, int32> RouteIds;
+	TArray<FString> RoutePatterns;
+
+	TArray<TUniquePtr<FShard>> Shards;
+};
+
+// Start of a handler run. Copied into handler work, records nothing without metrics.
+struct FHttpHandlerTiming
+{
+	FHttpHandlerTiming() = default;
+
+	explicit FHttpHandlerTiming(uint64 InRequestId)
+		: RequestId(InRequestId)
+	{
+	}
+
+	FHttpHandlerTiming(const TSharedRef<FHttpServerMetrics>& InMetrics, int32 InRouteId, uint64 InRequestId)
+		: Metrics(InMetrics)
+		, RouteId(InRouteId)
+		, EnqueueCycles(FPlatformTime::Cycles64())
+		, RequestId(InRequestId)
+	{
+	}
+
+	TSharedPtr<FHttpServerMetrics> Metrics;
+	int32 RouteId = INDEX_NONE;
+	uint64 EnqueueCycles = 0;
+
+	// Id of request in trace events
+	uint64 RequestId = 0;
+};
+
+// Records queue wait when handler starts and handler time when scope ends
+class FHttpHandlerScope
+{
+public:
+	explicit FHttpHandlerScope(const FHttpHandlerTiming& InTiming)
+		: Timing(InTiming)
+		, StartCycles(InTiming.Metrics.IsValid() ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	~FHttpHandlerScope()
+	{
+		if (Timing.Metrics.IsValid())
+		{
+			Timing.Metrics->RecordHandler(Timing.RouteId, StartCycles - Timing.EnqueueCycles, FPlatformTime::Cycles64() - StartCycles);
+		}
+	}
+
+private:
+	const FHttpHandlerTiming& Timing;
+	const uint64 StartCycles;
+};
@@ -0,0 +1,90 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpRouteCompletion.h"
+#include "HttpStreamWriter.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+
+class FNativeHttpServerRequestView;
+class FHttpResponseCache;
+class FHttpResponseBuilder;
+
+/**
+ * Serves files of a directory through IPlatformFile, so files in pak/IoStore containers work too.
+ * Supports single range requests (206), conditional requests and pre-compressed encodings of textual files.
+ * Responses bigger than StreamThreshold are redirected to a streaming route, which sends them in chunks without buffering the whole file.
+ */
+class SIMPLEHTTPSERVER_API FHttpStaticDirectory : public TSharedFromThis<FHttpStaticDirectory>
+{
+public:
+	FHttpStaticDirectory(FString InRootDirectory, const TSharedRef<FHttpResponseCache>& InCache);
+
+	// Handler for "<UrlPrefix>/*path" routes. Does blocking file IO, don't run it on the game thread.
+	void HandleRequest(const FNativeHttpServerRequestView& Request, FHttpRouteCompletion Completion) const;
+
+	// Handler for the same routes on the stream server. Each download is sent from its own thread.
+	void HandleStreamRequest(const FNativeHttpServerRequestView& Request, FHttpStreamWriter Writer) const;
+
+	// MIME type by file extension, "application/octet-stream" if unknown
+	static FString GetMimeType(const FString& Filename);
+
+	enum class ERangeResult : uint8
+	{
+		// No range, malformed or multiple ranges: full file is sent
+		Ignored,
+		Satisfiable,
+		Unsatisfiable
+	};
+
+	// Parse "bytes=start-end", "bytes=start-" or "bytes=-suffix" for file of FileSize bytes. OutEnd is inclusive.
+	static ERangeResult ParseRange(FStringView RangeHeader, int64 FileSize, int64& OutStart, int64& OutEnd);
+
+	// Cache-Control max-age for served files
+	int32 MaxAgeSeconds = 60;
+
+	// Streamed files of this size and bigger are sent straight from a memory mapping instead of being read in chunks
+	int64 MapThreshold = 4 * 1024 * 1024;
+
+	// Port of the streaming routes serving this directory, zero if there are none.
+	// Without them, responses that don't fit a single HTTPServer body (2 GB) fail with 500.
+	int32 StreamPort = 0;
+
+	// Responses of this size and bigger are redirected to StreamPort when it is set
+	int64 StreamThreshold = 64 * 1024 * 1024;
+
+	// Scheme, host and port redirects point to, e.g. "http://127.0.0.1:8081".
+	// Empty when the stream server listens on all addresses, then the request host is used if it is in StreamAllowedHosts.
+	FString StreamBaseUrl;
+
+	// Host names, without port, that redirects may take from the Host header. Case-insensitive.
+	TArray<FString> StreamAllowedHosts;
+
+	// Compress textual files when client accepts it
+	bool bCompress = true;
+
+	int32 CompressionMinSize = 1024;
+
+private:
+	// Full path of file for request path, empty if it's outside of root directory
+	FString ResolveFilename(FStringView RelativePath) const;
+
+	// Existing file of request, index.html for directories. False if there is none.
+	bool FindFile(const FNativeHttpServerRequestView& Request, FString& OutFilename, FFileStatData& OutStatData) const;
+
+	// Content type, caching headers and validators. Returns file version.
+	uint64 SetFileHeaders(FHttpResponseBuilder& Builder, const FString& Filename, const FFileStatData& StatData) const;
+
+	// Same path and query under StreamBaseUrl, or on StreamPort of an allowed request host. Empty if there is no such place.
+	FString MakeStreamLocation(const FNativeHttpServerRequestView& Request) const;
+
+	static bool ReadFileRange(const FString& Filename, int64 Offset, int64 Size, TArray<uint8>& OutBytes);
+
+	// Write file part to Writer in chunks, waiting while the client is behind. False if file can't be read or client is gone.
+	bool StreamFileRange(const FString& Filename, int64 Offset, int64 Size, FHttpStreamWriter& Writer) const;
+
+	FString RootDirectory;
+
+	TWeakPtr<FHttpResponseCache> Cache;
+};
@@ -0,0 +1,184 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HttpServerRequest.h"
+
+class FHttpStreamSocket;
+class FRunnableThread;
+
+/**
+ * Wakes the stream server thread from other threads. It is a loopback datagram socket,
+ * so the thread waits for it together with client sockets and sleeps until something happens.
+ */
+class SIMPLEHTTPSERVER_API FHttpStreamWakeup
+{
+public:
+	FHttpStreamWakeup();
+	~FHttpStreamWakeup();
+
+	// Safe from any thread. Several triggers before the server thread wakes up send one datagram.
+	void Trigger();
+
+	// Drop received wakeups. Server thread only, called before it looks for work.
+	void Reset();
+
+	// Null if loopback socket couldn't be created, then the server thread polls
+	FHttpStreamSocket* GetSocket() const { return Socket.Get(); }
+
+private:
+	TUniquePtr<FHttpStreamSocket> Socket;
+	std::atomic<bool> bPending{ false };
+};
+
+/**
+ * Connection accepted by FHttpStreamServer.
+ * Buffers are queued as shared references, so the same buffer can be sent to many connections without copies.
+ * Queueing and closing are thread-safe, socket IO happens on the stream server thread only.
+ */
+class SIMPLEHTTPSERVER_API FHttpStreamConnection : public TSharedFromThis<FHttpStreamConnection>
+{
+public:
+	FHttpStreamConnection(TUniquePtr<FHttpStreamSocket>&& InSocket, uint32 InId, const TSharedRef<FHttpStreamWakeup>& InWakeup);
+	~FHttpStreamConnection();
+
+	// Queue bytes to send. Returns false if connection is closed.
+	bool Send(const TSharedRef<const TArray<uint8>>& Buffer);
+	bool Send(TArray<uint8>&& Bytes);
+
+	// Queue several buffers at once, nothing sent from other threads gets in between
+	bool Send(TArrayView<const TSharedRef<const TArray<uint8>>> Buffers);
+
+	// Close after everything queued is sent
+	void Close();
+
+	// Close right away, dropping queued data
+	void Abort();
+
+	bool IsOpen() const { return !bCloseRequested && !bClosed; }
+
+	// Bytes queued, but not yet sent. Use it to detect slow consumers.
+	int64 GetQueuedBytes() const { return QueuedBytes; }
+
+	uint32 GetId() const { return Id; }
+
+	// Called on the stream server thread with bytes received after the request was dispatched (e.g. WebSocket frames).
+	// Set it from the request handler of the stream server, before it returns.
+	TFunction<void(TArrayView<const uint8>)> OnData;
+
+	// Called on the stream server thread when connection is closed
+	TFunction<void()> OnClosed;
+
+private:
+	friend class FHttpStreamServer;
+
+	// Read available bytes. Returns false if connection was closed by peer.
+	bool Receive();
+
+	// Send as much as socket accepts. Returns true if something was sent.
+	bool Flush();
+
+	// Close socket and notify OnClosed
+	void Shutdown();
+
+	bool HasPendingSend() const;
+
+	TUniquePtr<FHttpStreamSocket> Socket;
+	uint32 Id = 0;
+
+	// Shared with the server, so late senders can still poke it
+	TSharedRef<FHttpStreamWakeup> Wakeup;
+
+	struct FPendingBuffer
+	{
+		TSharedRef<const TArray<uint8>> Buffer;
+		int32 Offset = 0;
+	};
+
+	mutable FCriticalSection SendLock;
+	TArray<FPendingBuffer> SendQueue;
+	std::atomic<int64> QueuedBytes{ 0 };
+
+	std::atomic<bool> bCloseRequested{ false };
+	std::atomic<bool> bClosed{ false };
+
+	// Set once request was parsed and handed to OnRequest
+	bool bRequestDispatched = false;
+
+	// Set when send failed, connection is closed by the server thread
+	bool bSendFailed = false;
+
+	TArray<uint8> ReceiveBuffer;
+
+	double LastActivityTime = 0.0;
+};
+
+typedef TFunction<bool(const TSharedRef<FHttpStreamConnection>& Connection, const FHttpServerRequest& Request)> FHttpStreamRequestHandler;
+
+/**
+ * Minimal HTTP/1.1 listener for responses that can't be sent by HTTPServer module in one piece: chunked streams, server-sent events, WebSockets.
+ * HTTPServer module writes every response as a whole, so streaming endpoints live on their own port.
+ * Requests are parsed on the stream server thread and handed to OnRequest on that thread.
+ */
+class SIMPLEHTTPSERVER_API FHttpStreamServer : public FRunnable
+{
+public:
+	FHttpStreamServer(FHttpStreamRequestHandler InOnRequest);
+	virtual ~FHttpStreamServer();
+
+	bool Start(const FString& BindAddress, int32 Port);
+	void Stop();
+
+	bool IsRunning() const { return Thread != nullptr; }
+
+	int32 GetPort() const { return Port; }
+
+	int32 GetNumConnections() const { return NumConnections; }
+
+	// Wake the server thread, e.g. after queueing data
+	void Wakeup();
+
+	// Max size of request line, headers and body
+	int32 MaxRequestSize = 1024 * 1024;
+
+	// Connections without a complete request after this time are closed
+	double RequestTimeoutSeconds = 10.0;
+
+	// FRunnable
+	virtual uint32 Run() override;
+
+	// Build FHttpServerRequest from received bytes. Returns 0 if request is not complete yet, -1 if it is malformed, or number of bytes consumed.
+	static int32 ParseRequest(TArrayView<const uint8> Data, int32 MaxRequestSize, FHttpServerRequest& OutRequest);
+
+	// Status line and headers of a response
+	static TArray<uint8> MakeResponseHead(int32 Code, const TMap<FString, TArray<FString>>& Headers);
+
+private:
+	// Take every pending connection of the listener. Returns true if there were any.
+	bool AcceptConnections();
+
+	void ProcessConnection(const TSharedRef<FHttpStreamConnection>& Connection, bool& bOutDidWork);
+
+	void SendErrorAndClose(const TSharedRef<FHttpStreamConnection>& Connection, int32 Code);
+
+	// Sleep until a client connects, a client socket is readable, a blocked send can continue, or Wakeup is called
+	void WaitForSockets();
+
+	FHttpStreamRequestHandler OnRequest;
+
+	// Accepted on the server thread, which waits for it together with connections
+	TUniquePtr<FHttpStreamSocket> Listener;
+	FRunnableThread* Thread = nullptr;
+	TSharedRef<FHttpStreamWakeup> WakeupSocket;
+
+	std::atomic<bool> bStopping{ false };
+
+	// Owned by the server thread
+	TArray<TSharedRef<FHttpStreamConnection>> Connections;
+	std::atomic<int32> NumConnections{ 0 };
+	uint32 NextConnectionId = 1;
+
+	int32 Port = 0;
+};
@@ -0,0 +1,71 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpServerResponse.h"
+
+class FHttpStreamConnection;
+
+/**
+ * Writer passed to streaming route handlers. Sends the response with chunked transfer encoding piece by piece,
+ * so large payloads never have to be built in memory as a whole.
+ * It can be copied, stored and used from any thread. Writes from different threads are sent in call order.
+ * If every copy is destroyed, the response is finished. If nothing was written, the client receives 500.
+ */
+class SIMPLEHTTPSERVER_API FHttpStreamWriter
+{
+public:
+	FHttpStreamWriter() = default;
+	explicit FHttpStreamWriter(const TSharedRef<FHttpStreamConnection>& Connection);
+
+	// Send status and headers. Called with 200 and "application/octet-stream" by the first Write if not called before.
+	bool BeginResponse(EHttpServerResponseCodes Code, const FString& ContentType, TMap<FString, TArray<FString>> Headers = TMap<FString, TArray<FString>>());
+
+	// Send one chunk. Returns false if client is gone or response is finished.
+	bool Write(TArrayView<const uint8> Bytes);
+	bool Write(FUtf8StringView Text);
+
+	// Converts TCHAR text to UTF-8
+	bool Write(FStringView Text);
+
+	// Send shared buffer without copying it, e.g. the same payload to many clients
+	bool Write(const TSharedRef<const TArray<uint8>>& Buffer);
+
+	// Send the last chunk and close connection after everything is sent
+	void Finish();
+
+	// Drop connection without finishing the response
+	void Abort();
+
+	// False after Finish, Abort or when client disconnected. Long running producers should stop when it turns false.
+	bool IsOpen() const;
+
+	// Bytes waiting to be sent. Producers can wait while it is high, so a slow client doesn't make the queue grow.
+	int64 GetQueuedBytes() const;
+
+	bool IsValid() const { return State.IsValid(); }
+
+private:
+	struct FState
+	{
+		~FState();
+
+		TWeakPtr<FHttpStreamConnection> Connection;
+
+		// Guards response state, so head and chunks from different threads are queued in order
+		FCriticalSection Lock;
+		bool bResponseStarted = false;
+
+		// Set under Lock, read without it by IsOpen
+		std::atomic<bool> bFinished{ false };
+	};
+
+	// Caller holds InState.Lock
+	static bool BeginResponseLocked(FState& InState, const TSharedRef<FHttpStreamConnection>& Connection, EHttpServerResponseCodes Code, const FString& ContentType, TMap<FString, TArray<FString>>&& Headers);
+
+	// Queue framed chunk pieces, starting the response if needed
+	bool SendChunk(TArrayView<const TSharedRef<const TArray<uint8>>> Buffers) const;
+
+	TSharedPtr<FState, ESPMode::ThreadSafe> State;
+};
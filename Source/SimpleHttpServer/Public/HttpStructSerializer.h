@@ -0,0 +1,45 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpServerRequest.h"
+
+// Encoding of struct bodies
+enum class EHttpWireFormat : uint8
+{
+	Json,
+	MessagePack,
+	Cbor
+};
+
+/**
+ * Struct bodies in JSON, MessagePack or CBOR, all driven by the same cached per-type plans as FHttpJsonSerializer.
+ * Structs are maps keyed by the same field names in every format, so clients switch formats without schema changes.
+ * Byte arrays are sent as binary strings by MessagePack and CBOR.
+ */
+class SIMPLEHTTPSERVER_API FHttpStructSerializer
+{
+public:
+	// Response format preferred by Accept header. JSON when client accepts anything or none of the binary formats.
+	static EHttpWireFormat NegotiateFormat(const FHttpServerRequest& Request);
+
+	// Format of request body by Content-Type. JSON when not set.
+	static EHttpWireFormat GetBodyFormat(const FHttpServerRequest& Request);
+
+	static const TCHAR* GetContentType(EHttpWireFormat Format);
+
+	static void AppendStruct(TArray<uint8>& Out, EHttpWireFormat Format, const UStruct* Struct, const void* Data);
+
+	// Any single property value, e.g. Blueprint wildcard
+	static void AppendProperty(TArray<uint8>& Out, EHttpWireFormat Format, const FProperty* Property, const void* Value);
+
+	// Same rules as FHttpJsonSerializer::ReadStruct in every format. Safe from any thread.
+	static bool ReadStruct(TArrayView<const uint8> Bytes, EHttpWireFormat Format, const UScriptStruct* Struct, void* Data, FString* OutError = nullptr);
+
+	template<typename T>
+	static bool ReadStruct(TArrayView<const uint8> Bytes, EHttpWireFormat Format, T& OutValue, FString* OutError = nullptr)
+	{
+		return ReadStruct(Bytes, Format, T::StaticStruct(), &OutValue, OutError);
+	}
+};
@@ -0,0 +1,76 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpServerRequest.h"
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+#include <atomic>
+
+// Request as stored in a traffic recording
+struct SIMPLEHTTPSERVER_API FHttpRecordedRequest
+{
+	// Time since the previous request of the recording
+	uint64 DelayMicroseconds = 0;
+
+	EHttpServerRequestVerbs Verb = EHttpServerRequestVerbs::VERB_GET;
+
+	// Path with URL-encoded query
+	FString Target;
+
+	TArray<TPair<FString, FString>> Headers;
+
+	TArray<uint8> Body;
+
+	// HTTP/1.1 request ready to be sent. Connection and length headers are replaced for a keep-alive client.
+	TArray<uint8> MakeRequestBytes(const FString& Host) const;
+};
+
+/**
+ * Writes incoming requests with their inter-arrival times to a compact binary file.
+ * Lengths and times are variable-length integers, strings are UTF-8.
+ * Record is called on the game thread and only encodes the request, the file is written by a writer thread.
+ */
+class SIMPLEHTTPSERVER_API FHttpTrafficRecorder : public FRunnable
+{
+public:
+	// Null if file can't be created. Values of RedactedHeaders are not written, names are case-insensitive.
+	static TUniquePtr<FHttpTrafficRecorder> Create(const FString& Filename, const TArray<FString>& RedactedHeaders);
+
+	// Writes queued records before closing the file
+	virtual ~FHttpTrafficRecorder();
+
+	void Record(const FHttpServerRequest& Request);
+
+	int64 GetNumRecords() const { return NumRecords; }
+
+	// Load whole recording. False and error message if file is missing or damaged.
+	static bool Load(const FString& Filename, TArray<FHttpRecordedRequest>& OutRequests, FString& OutError);
+
+	// Written in place of redacted header values
+	static const TCHAR* RedactedValue;
+
+	// FRunnable
+	virtual uint32 Run() override;
+
+private:
+	FHttpTrafficRecorder(TUniquePtr<FArchive>&& InWriter, const TArray<FString>& InRedactedHeaders);
+
+	bool IsRedacted(const FString& Header) const;
+
+	// Used by the writer thread only
+	TUniquePtr<FArchive> Writer;
+
+	TSet<FString> RedactedHeaders;
+
+	// Encoded records waiting for the writer thread
+	TQueue<TArray<uint8>, EQueueMode::Spsc> PendingRecords;
+
+	FEvent* WakeEvent = nullptr;
+	std::atomic<bool> bStopping{ false };
+	FRunnableThread* Thread = nullptr;
+
+	double LastRecordTime = 0.0;
+	int64 NumRecords = 0;
+};
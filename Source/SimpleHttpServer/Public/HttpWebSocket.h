@@ -0,0 +1,139 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpServerRequest.h"
+
+#include "HttpWebSocket.generated.h"
+
+class FHttpStreamConnection;
+
+// What happens to a WebSocket client that doesn't read fast enough
+UENUM(BlueprintType)
+enum class EHttpWebSocketDropPolicy : uint8
+{
+	// Skip messages while client is behind. Fits state streams where the next message replaces the previous one.
+	DropMessages,
+	// Disconnect client. Fits streams where every message matters.
+	Disconnect
+};
+
+// Message received from a WebSocket client
+struct SIMPLEHTTPSERVER_API FHttpWebSocketMessage
+{
+	uint32 ClientId = 0;
+	bool bBinary = false;
+	TArray<uint8> Data;
+
+	FUtf8StringView GetUtf8() const { return FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Data.GetData()), Data.Num()); }
+
+	// Converts text message to TCHAR
+	FString GetText() const;
+};
+
+/**
+ * WebSocket endpoint. Clients are accepted on the stream server thread, received messages are handed to OnMessage on that thread.
+ * Broadcast encodes the frame once and queues the same buffer to every client. Each client has its own send queue,
+ * clients that fall more than MaxQueuedBytes behind are handled by DropPolicy.
+ * Sending is thread-safe.
+ */
+class SIMPLEHTTPSERVER_API FHttpWebSocketChannel : public TSharedFromThis<FHttpWebSocketChannel>
+{
+public:
+	// Send message to every client. Returns number of clients it was queued to.
+	int32 Broadcast(TArrayView<const uint8> Data, bool bBinary);
+	int32 Broadcast(FStringView Text);
+
+	// Send already encoded frame, e.g. one made by EncodeFrame and broadcast to several channels
+	int32 BroadcastFrame(const TSharedRef<const TArray<uint8>>& Frame);
+
+	// Send message to one client. Returns false if there is no such client or message was dropped.
+	bool Send(uint32 ClientId, TArrayView<const uint8> Data, bool bBinary);
+	bool Send(uint32 ClientId, FStringView Text);
+
+	// Close client with normal closure code
+	void Disconnect(uint32 ClientId);
+
+	int32 GetNumClients() const;
+
+	// Messages skipped for slow clients since start
+	int64 GetNumDroppedMessages() const { return NumDroppedMessages; }
+
+	// Validate upgrade request and take over the connection. Called on the stream server thread.
+	void Accept(const TSharedRef<FHttpStreamConnection>& Connection, const FHttpServerRequest& Request);
+
+	// Unmasked server frame
+	static TSharedRef<const TArray<uint8>> EncodeFrame(uint8 Opcode, TArrayView<const uint8> Payload);
+
+	struct FFrameHeader
+	{
+		bool bFinal = false;
+		uint8 Opcode = 0;
+		bool bMasked = false;
+		uint64 PayloadSize = 0;
+
+		// Bytes before the payload, mask key included
+		int32 HeaderSize = 0;
+
+		uint8 Mask[4] = {};
+	};
+
+	// Parse head of a received frame. False if Data doesn't hold the whole header yet.
+	static bool ParseFrameHeader(TArrayView<const uint8> Data, FFrameHeader& OutHeader);
+
+	// Called on the stream server thread
+	TFunction<void(FHttpWebSocketMessage&& Message)> OnMessage;
+	TFunction<void(uint32 ClientId)> OnConnected;
+	TFunction<void(uint32 ClientId)> OnDisconnected;
+
+	int64 MaxQueuedBytes = 1024 * 1024;
+
+	EHttpWebSocketDropPolicy DropPolicy = EHttpWebSocketDropPolicy::DropMessages;
+
+	// Larger incoming messages close the connection
+	int32 MaxMessageSize = 1024 * 1024;
+
+	enum EOpcode : uint8
+	{
+		OpContinuation = 0x0,
+		OpText = 0x1,
+		OpBinary = 0x2,
+		OpClose = 0x8,
+		OpPing = 0x9,
+		OpPong = 0xA
+	};
+
+private:
+	struct FClient
+	{
+		explicit FClient(const TSharedRef<FHttpStreamConnection>& InConnection)
+			: Connection(InConnection)
+		{
+		}
+
+		TSharedRef<FHttpStreamConnection> Connection;
+
+		// Bytes of incomplete frame
+		TArray<uint8> Pending;
+
+		// Fragmented message being assembled
+		TArray<uint8> Message;
+		uint8 MessageOpcode = 0;
+	};
+
+	// Queue frame to client applying drop policy
+	bool SendFrame(FClient& Client, const TSharedRef<const TArray<uint8>>& Frame);
+
+	// Parse received frames. Returns close code if client must be disconnected, zero otherwise.
+	uint16 ProcessData(FClient& Client, TArrayView<const uint8> Data);
+
+	void CloseClient(FClient& Client, uint16 Code);
+
+	void RemoveClient(uint32 ClientId);
+
+	mutable FCriticalSection ClientsLock;
+	TMap<uint32, TSharedRef<FClient>> Clients;
+
+	std::atomic<int64> NumDroppedMessages{ 0 };
+};
@@ -0,0 +1,176 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Class.h"
+
+#include "HttpWorldSnapshot.generated.h"
+
+USTRUCT(BlueprintType)
+struct FHttpSnapshotActorTransform
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "Snapshot")
+	FString Name;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Snapshot")
+	FTransform Transform;
+};
+
+// Value captured by RegisterSnapshotActorTransforms
+USTRUCT(BlueprintType)
+struct FHttpSnapshotActorTransforms
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "Snapshot")
+	TArray<FHttpSnapshotActorTransform> Actors;
+};
+
+// Copy of a struct taken on the game thread
+struct SIMPLEHTTPSERVER_API FHttpSnapshotValue
+{
+	FHttpSnapshotValue(FName InName, const UScriptStruct* InStruct);
+	~FHttpSnapshotValue();
+
+	FHttpSnapshotValue(const FHttpSnapshotValue&) = delete;
+	FHttpSnapshotValue& operator=(const FHttpSnapshotValue&) = delete;
+
+	FName Name;
+	const UScriptStruct* Struct = nullptr;
+	void* Memory = nullptr;
+};
+
+/**
+ * Immutable state of registered data at one tick.
+ * Never changes while anyone holds it, so it can be read from any thread without locks.
+ */
+class SIMPLEHTTPSERVER_API FHttpWorldSnapshot
+{
+public:
+	// Increases with every publish
+	uint64 GetVersion() const { return Version; }
+
+	// World time of the tick it was taken on
+	double GetTime() const { return Time; }
+
+	// Null if there is no such value or it has another type
+	template<typename T>
+	const T* Get(FName Name) const
+	{
+		const FHttpSnapshotValue* Value = Find(Name);
+		return Value && Value->Struct == T::StaticStruct() ? static_cast<const T*>(Value->Memory) : nullptr;
+	}
+
+	const FHttpSnapshotValue* Find(FName Name) const;
+
+	const TArray<TUniquePtr<FHttpSnapshotValue>>& GetValues() const { return Values; }
+
+private:
+	friend class FHttpSnapshotPublisher;
+	friend class FHttpSnapshotRef;
+
+	uint64 Version = 0;
+	double Time = 0.0;
+
+	TArray<TUniquePtr<FHttpSnapshotValue>> Values;
+
+	// Held by readers and by the publisher. Last one out deletes the snapshot.
+	mutable std::atomic<int32> RefCount{ 1 };
+};
+
+// Reader's hold on a snapshot. Cheap to copy, the snapshot stays alive and unchanged while any copy exists.
+class SIMPLEHTTPSERVER_API FHttpSnapshotRef
+{
+public:
+	FHttpSnapshotRef() = default;
+	FHttpSnapshotRef(const FHttpSnapshotRef& Other);
+	FHttpSnapshotRef(FHttpSnapshotRef&& Other);
+	FHttpSnapshotRef& operator=(const FHttpSnapshotRef& Other);
+	FHttpSnapshotRef& operator=(FHttpSnapshotRef&& Other);
+	~FHttpSnapshotRef();
+
+	bool IsValid() const { return Snapshot != nullptr; }
+
+	const FHttpWorldSnapshot* Get() const { return Snapshot; }
+	const FHttpWorldSnapshot* operator->() const { return Snapshot; }
+	const FHttpWorldSnapshot& operator*() const { return *Snapshot; }
+
+private:
+	friend class FHttpSnapshotPublisher;
+
+	// Takes over a reference already added by the caller
+	explicit FHttpSnapshotRef(const FHttpWorldSnapshot* InSnapshot) : Snapshot(InSnapshot) {}
+
+	void Release();
+
+	const FHttpWorldSnapshot* Snapshot = nullptr;
+};
+
+/**
+ * Publishes a new snapshot of registered sources once per tick on the game thread.
+ * Acquire is lock-free and never waits for the publisher, the publisher never waits for readers.
+ * Replaced snapshots are reused for the next publish once nobody reads them, so in steady state two snapshots
+ * take turns and their struct memory is reused.
+ */
+class SIMPLEHTTPSERVER_API FHttpSnapshotPublisher
+{
+public:
+	FHttpSnapshotPublisher() = default;
+	~FHttpSnapshotPublisher();
+
+	FHttpSnapshotPublisher(const FHttpSnapshotPublisher&) = delete;
+	FHttpSnapshotPublisher& operator=(const FHttpSnapshotPublisher&) = delete;
+
+	// Capture fills value of Struct type. Value memory is reused between publishes and holds an older capture,
+	// so capture must overwrite it completely (e.g. Reset arrays before filling them).
+	void RegisterStruct(FName Name, const UScriptStruct* Struct, TFunction<void(void* OutValue)> Capture);
+
+	template<typename T>
+	void Register(FName Name, TFunction<void(T& OutValue)> Capture)
+	{
+		RegisterStruct(Name, T::StaticStruct(), [Capture = MoveTemp(Capture)](void* OutValue)
+		{
+			Capture(*static_cast<T*>(OutValue));
+		});
+	}
+
+	void Unregister(FName Name);
+
+	bool HasSources() const { return Sources.Num() > 0; }
+
+	// Capture all sources and make the result visible to readers. Game thread only.
+	void Publish(double Time);
+
+	// Latest published snapshot. Safe from any thread. Invalid until the first publish.
+	FHttpSnapshotRef Acquire() const;
+
+private:
+	struct FSource
+	{
+		FName Name;
+		const UScriptStruct* Struct = nullptr;
+		TFunction<void(void* OutValue)> Capture;
+	};
+
+	// Replaced snapshot nobody reads anymore, if any
+	FHttpWorldSnapshot* ReclaimSnapshot();
+
+	static void ReleaseSnapshot(const FHttpWorldSnapshot* Snapshot);
+
+	TArray<FSource> Sources;
+
+	std::atomic<FHttpWorldSnapshot*> Current{ nullptr };
+
+	// Readers between loading Current and taking a reference
+	mutable std::atomic<int32> NumAcquiring{ 0 };
+
+	// Replaced snapshots still referenced by the publisher. Game thread only.
+	TArray<FHttpWorldSnapshot*> Retired;
+
+	uint64 NextVersion = 1;
+};
@@ -0,0 +1,76 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpServerRequest.h"
+#include "HttpStructSerializer.h"
+#include "UObject/StructOnScope.h"
+
+struct FHttpRouteMatch;
+struct FSimpleHttpRoute;
+
+/**
+ * Read-only view over the request received by HTTPServer module. Used by C++ route handlers.
+ * Nothing is converted up front: headers and params are looked up on demand and the body is exposed as raw UTF-8 bytes.
+ * Cheap to copy, all copies share the same request.
+ */
+class SIMPLEHTTPSERVER_API FNativeHttpServerRequestView
+{
+public:
+	// Takes the single copy of the request needed to outlive the HTTPServer callback
+	FNativeHttpServerRequestView(const FHttpServerRequest& SourceRequest, const FHttpRouteMatch& Match, const TSharedRef<const FSimpleHttpRoute>& InRoute);
+
+	EHttpServerRequestVerbs GetVerb() const { return Request->Verb; }
+
+	FStringView GetRelativePath() const { return Request->RelativePath.GetPath(); }
+
+	// Case-insensitive. Returns the first value or empty view if there is no such header.
+	FStringView GetHeader(FStringView Name) const;
+
+	// All values of header. Null if there is no such header.
+	const TArray<FString>* FindHeaderValues(FStringView Name) const;
+
+	FStringView GetQueryParam(FStringView Name) const;
+
+	// Value of ":name" or "*name" segment of the route
+	FStringView GetPathParam(FStringView Name) const;
+
+	int32 GetNumPathParams() const { return PathParamValues.Num(); }
+
+	// Raw body bytes as received
+	TArrayView<const uint8> GetBody() const { return Request->Body; }
+
+	FUtf8StringView GetBodyUtf8() const;
+
+	// Converts body to TCHAR. Allocates on every call, prefer GetBody/GetBodyUtf8 when possible.
+	FString GetBodyAsString() const;
+
+	// Body parsed into the struct set with SetRouteBodyStruct. Null if route has no body struct or it is of another type.
+	template<typename T>
+	const T* GetBodyStruct() const
+	{
+		return ParsedBody.IsValid() && ParsedBody->GetStruct() == T::StaticStruct() ? reinterpret_cast<const T*>(ParsedBody->GetStructMemory()) : nullptr;
+	}
+
+	const FStructOnScope* GetParsedBody() const { return ParsedBody.Get(); }
+
+	// Format the client asked for with Accept header
+	EHttpWireFormat GetResponseFormat() const { return FHttpStructSerializer::NegotiateFormat(*Request); }
+
+	const FHttpServerRequest& GetRequest() const { return *Request; }
+
+	const FSimpleHttpRoute& GetRoute() const { return *Route; }
+
+private:
+	friend class USimpleHttpServer;
+
+	TSharedRef<const FHttpServerRequest> Request;
+	TSharedRef<const FSimpleHttpRoute> Route;
+
+	// Point into Request->RelativePath, names are in Route->ParamNames
+	TArray<FStringView, TInlineAllocator<4>> PathParamValues;
+
+	// Set by the server before the handler runs
+	TSharedPtr<const FStructOnScope> ParsedBody;
+};
@@ -0,0 +1,73 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Result of a route lookup
+struct FHttpRouteMatch
+{
+	// Index of the route bound for the request verb. INDEX_NONE if nothing matched.
+	int32 RouteIndex = INDEX_NONE;
+
+	// Path parameters. Names point into the trie, values point into the request path. Valid while the request is handled.
+	TArray<TPair<FStringView, FStringView>, TInlineAllocator<4>> Params;
+
+	FStringView FindParam(FStringView Name) const;
+};
+
+/**
+ * Radix trie of route patterns.
+ * Static text is stored as compressed prefixes and matched case-insensitively.
+ * Segments starting with ':' match a single path segment ("/users/:id"), a segment starting with '*' matches the rest of the path ("/files/*path").
+ * Static text wins over parameters, parameters win over wildcards.
+ */
+class SIMPLEHTTPSERVER_API FSimpleHttpRouteTrie
+{
+public:
+	// Number of verbs with a dispatch slot on every node. Verb masks use ENativeHttpServerRequestVerbs bits.
+	static constexpr int32 NumVerbs = 6;
+
+	FSimpleHttpRouteTrie();
+	~FSimpleHttpRouteTrie();
+
+	// Bind RouteIndex for every verb in VerbMask. Existing routes for these verbs are replaced.
+	bool Insert(FStringView Pattern, uint8 VerbMask, int32 RouteIndex);
+
+	// Walk the trie once. Path must not contain the query string.
+	bool Find(FStringView Path, uint8 Verb, FHttpRouteMatch& OutMatch) const;
+
+	void Reset();
+
+	bool IsEmpty() const;
+
+private:
+	struct FNode
+	{
+		FNode();
+
+		// Lowercase static text. Empty for the root, parameter and wildcard nodes.
+		FString Prefix;
+
+		// First character of every static child, to pick a child without comparing prefixes
+		TArray<TCHAR, TInlineAllocator<4>> Indices;
+		TArray<TUniquePtr<FNode>, TInlineAllocator<4>> Children;
+
+		TUniquePtr<FNode> ParamChild;
+		TUniquePtr<FNode> WildcardChild;
+
+		// Parameter name for parameter and wildcard nodes
+		FString ParamName;
+
+		int32 Routes[NumVerbs];
+	};
+
+	FNode* InsertStatic(FNode* Node, FStringView Text);
+	FNode* InsertParam(FNode* Node, TUniquePtr<FNode>& Child, FStringView Name, FStringView Pattern);
+
+	bool FindRecursive(const FNode& Node, FStringView Path, int32 VerbIndex, FHttpRouteMatch& OutMatch) const;
+
+	static int32 GetVerbIndex(uint8 Verb);
+
+	TUniquePtr<FNode> Root;
+};
@@ -5,12 +5,30 @@
 #include "CoreMinimal.h"
 #include "HttpServerRequest.h"
 #include "HttpResultCallback.h"
-#include "HttpRouteHandle.h"
+#include "HttpRouteCompletion.h"
+#include "SimpleHttpRouteTrie.h"
+#include "NativeHttpServerRequestView.h"
+#include "HttpResponseCache.h"
+#include "HttpStreamServer.h"
+#include "HttpStreamWriter.h"
+#include "HttpEventStream.h"
+#include "HttpWebSocket.h"
+#include "HttpLongPoll.h"
+#include "HttpWorldSnapshot.h"
+#include "HttpJsonSerializer.h"
+#include "HttpStructSerializer.h"
+#include "HttpServerMetrics.h"
+#include "HttpTrafficRecording.h"
+#include "Templates/SubclassOf.h"
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
 
 #include "SimpleHttpServer.generated.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogSimpleHttpServer, Log, All);
 
+class AActor;
+
 UENUM(BlueprintType)
 enum class ENativeHttpServerRequestVerbs : uint8
 {
@@ -23,6 +41,18 @@ enum class ENativeHttpServerRequestVerbs : uint8
 	OPTIONS = 1 << 5
 };
 
+// Where route handler is executed
+UENUM(BlueprintType)
+enum class EHttpRouteExecution : uint8
+{
+	// Run on the game thread. Required for handlers touching UObjects.
+	GameThread,
+	// Run on a task graph background worker
+	TaskGraph,
+	// Run on the server's own thread pool, so slow handlers don't occupy task graph workers
+	ThreadPool
+};
+
 //Contains only FHttpServerResponse. Just to be used from blueprints
 USTRUCT(BlueprintType)
 struct FNativeHttpServerResponse
@@ -33,8 +63,33 @@ public:
 	FHttpServerResponse HttpServerResponse;
 };
 
+// Request body shared by all copies of FNativeHttpServerRequest. Decoded forms are made on first access and cached.
+struct SIMPLEHTTPSERVER_API FNativeHttpServerRequestBody
+{
+	explicit FNativeHttpServerRequestBody(TArray<uint8> InBytes)
+		: Bytes(MoveTemp(InBytes))
+	{
+	}
+
+	// Raw UTF-8 bytes as received
+	const TArray<uint8> Bytes;
+
+	const FString& GetString();
+
+	// Null if body isn't a JSON object. BodyString is the decoded body, so it isn't decoded again.
+	TSharedPtr<class FJsonObject> GetJsonObject(const FString& BodyString);
+
+private:
+	FCriticalSection Lock;
+
+	TOptional<FString> String;
+
+	TSharedPtr<class FJsonObject> JsonObject;
+	bool bJsonParsed = false;
+};
+
 USTRUCT(BlueprintType)
-struct FNativeHttpServerRequest
+struct SIMPLEHTTPSERVER_API FNativeHttpServerRequest
 {
 	GENERATED_BODY()
 
@@ -59,14 +114,105 @@ public:
 	TMap<FString, FString> PathParams;
 
 	UPROPERTY(BlueprintReadOnly, Category = "NativeHttpServerRequest")
-	/** The raw body contents */
+	/** The raw body contents. Empty if server has bDecodeBodyEagerly off or route has a body struct, use Get Request Body functions then. */
 	FString Body;
+
+	// Raw body bytes. Empty array if request has no body.
+	TArrayView<const uint8> GetBodyBytes() const;
+
+	// Body decoded from UTF-8. Decoded once per request, returns Body when it was decoded eagerly.
+	const FString& GetBodyString() const;
+
+	// Body parsed as JSON object. Parsed once per request, null if body isn't a JSON object.
+	TSharedPtr<class FJsonObject> GetBodyJson() const;
+
+	TSharedPtr<FNativeHttpServerRequestBody> RawBody;
+
+	// Body holds the decoded body, RawBody keeps only the bytes
+	bool bBodyDecoded = false;
+
+	// Body parsed into the struct set with SetRouteBodyStruct
+	TSharedPtr<const FStructOnScope> ParsedBody;
+
+	// Format asked for with Accept header, used by Make Struct Response
+	EHttpWireFormat ResponseFormat = EHttpWireFormat::Json;
 };
 
-typedef TFunction<void(FNativeHttpServerRequest Response)> FHttpRouteHandler;
+// Game thread request queue counters. Use them to tune GameThreadBudgetMs.
+USTRUCT(BlueprintType)
+struct FSimpleHttpServerQueueStats
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "Stats")
+	/** Requests waiting for the game thread right now */
+	int32 QueueDepth = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Stats")
+	/** Requests processed during the last tick */
+	int32 ProcessedLastFrame = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Stats")
+	/** Requests left for later frames because the last tick ran out of budget */
+	int32 DeferredLastFrame = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Stats")
+	/** Requests that missed a frame budget since server start. Each request is counted once, however many frames it waits. */
+	int64 TotalDeferred = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Stats")
+	/** Game thread time spent in handlers during the last tick */
+	float TimeSpentLastFrameMs = 0.0f;
+};
+
+// Native route handler. Respond through Completion, now or later from any thread.
+typedef TFunction<void(const FNativeHttpServerRequestView& Request, FHttpRouteCompletion Completion)> FHttpRouteHandler;
+
+// Streaming route handler. Write the response through Writer, now or later from any thread.
+typedef TFunction<void(const FNativeHttpServerRequestView& Request, FHttpStreamWriter Writer)> FHttpStreamHandler;
+
+// WebSocket message handler. Reply through Channel, it is safe to keep and use from any thread.
+typedef TFunction<void(const TSharedRef<FHttpWebSocketChannel>& Channel, const FHttpWebSocketMessage& Message)> FHttpWebSocketHandler;
+
+struct FNativeRouteBinding
+{
+	FHttpRouteHandler Handler;
+	EHttpRouteExecution Execution = EHttpRouteExecution::GameThread;
+};
 
 DECLARE_DYNAMIC_DELEGATE_RetVal_OneParam(FNativeHttpServerResponse, FHttpServerRequestDelegate, FNativeHttpServerRequest, HttpServerRequest);
 
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FHttpWebSocketMessageDelegate, int32, ClientId, const FString&, Message);
+
+// Route bound to blueprint event or C++ function
+struct FSimpleHttpRoute
+{
+	// Normalized route pattern
+	FString Path;
+
+	// Names of ":name" and "*name" segments in order. Point into Path.
+	TArray<FStringView> ParamNames;
+
+	// Usualy used for blueprints
+	FHttpServerRequestDelegate Delegate;
+
+	// Usualy used for c++
+	FNativeRouteBinding Native;
+
+	// Streaming routes, served on StreamPort. Executed as set in Native.Execution.
+	FHttpStreamHandler Stream;
+
+	// Server-sent events route. Clients are subscribed right on the stream server thread.
+	TSharedPtr<FHttpEventStream> EventStream;
+
+	// WebSocket route. Upgrade is handled right on the stream server thread.
+	TSharedPtr<FHttpWebSocketChannel> WebSocket;
+
+	// Id in server metrics, INDEX_NONE if route isn't recorded
+	int32 MetricsId = INDEX_NONE;
+};
+
 /**
  * HttpServer service.
  */
@@ -75,6 +221,9 @@ class SIMPLEHTTPSERVER_API USimpleHttpServer : public UObject
 {
 	GENERATED_BODY()
 
+	// Drives the game thread queue without a running server
+	friend class FSimpleHttpServerQueueSpec;
+
 public:
 	virtual void BeginDestroy() override;
 
@@ -87,31 +236,261 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server")
 	void StopServer();
 
-	// Bind Blueprint event to route
+	// Bind Blueprint event to route.
+	// Path can contain parameters: ":name" matches one segment, "*name" matches the rest of the path. Values are in PathParams.
 	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server")
 	void BindRoute(FString HttpPath, ENativeHttpServerRequestVerbs Verbs, FHttpServerRequestDelegate OnHttpServerRequest);
 
-	// Bind C++ function to route
-	void BindRouteNative(FString HttpPath, ENativeHttpServerRequestVerbs Verbs, FHttpRouteHandler Handler);
+	// Bind C++ function to route.
+	// Handlers that don't touch UObjects can run off the game thread with TaskGraph or ThreadPool execution.
+	void BindRouteNative(FString HttpPath, ENativeHttpServerRequestVerbs Verbs, FHttpRouteHandler Handler, EHttpRouteExecution Execution = EHttpRouteExecution::GameThread);
+
+	// Bind C++ function streaming its response with chunked transfer encoding, for payloads too large to build in memory.
+	// HTTPServer module can't send a response in parts, so streaming routes are served on StreamPort.
+	void BindStreamRoute(FString HttpPath, ENativeHttpServerRequestVerbs Verbs, FHttpStreamHandler Handler, EHttpRouteExecution Execution = EHttpRouteExecution::GameThread);
 
-	// Handle request and pass this to blueprint event
-	bool HandleRequest(FString HttpPath, const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
+	// Bind server-sent events channel to route. Clients stay connected and receive every published event.
+	// Served on StreamPort like other streaming routes.
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|Events")
+	void BindEventStream(FString HttpPath);
 
-	// Handle request and pass this to c++ function
-	bool HandleRequestNative(FString HttpPath, const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
+	// Send event to every subscriber of stream bound to HttpPath. Data is sent as is, use JSON for structured payloads.
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|Events")
+	void PublishEvent(FString HttpPath, FString EventName, FString Data);
+
+	UFUNCTION(BlueprintPure, Category = "Simple HTTP Server|Events")
+	int32 GetEventStreamSubscribers(FString HttpPath) const;
+
+	// Stream bound to HttpPath. Keep it to publish from any thread without the lookup.
+	TSharedPtr<FHttpEventStream> FindEventStream(FString HttpPath) const;
+
+	// Accept WebSocket clients on route. Text messages are passed to OnMessage on the game thread.
+	// HTTPServer module can't hand over its connections, so WebSockets are served on StreamPort.
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|WebSocket")
+	void BindWebSocket(FString HttpPath, FHttpWebSocketMessageDelegate OnMessage);
+
+	// Accept WebSocket clients on route. Handler gets text and binary messages.
+	void BindWebSocketNative(FString HttpPath, FHttpWebSocketHandler Handler, EHttpRouteExecution Execution = EHttpRouteExecution::GameThread);
+
+	// Send text to every client of WebSocket bound to HttpPath. Returns number of clients it was queued to.
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|WebSocket")
+	int32 BroadcastWebSocketMessage(FString HttpPath, FString Message);
+
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|WebSocket")
+	bool SendWebSocketMessage(FString HttpPath, int32 ClientId, FString Message);
+
+	UFUNCTION(BlueprintPure, Category = "Simple HTTP Server|WebSocket")
+	int32 GetWebSocketClients(FString HttpPath) const;
+
+	// Channel bound to HttpPath. Keep it to broadcast from any thread without the lookup.
+	TSharedPtr<FHttpWebSocketChannel> FindWebSocket(FString HttpPath) const;
+
+	// Bind long-polling GET route. Clients ask with "since=<version>" and get the state once it is newer,
+	// or 204 after LongPollTimeoutSeconds. Parked requests don't hold any thread.
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|Long Poll")
+	void BindLongPoll(FString HttpPath);
+
+	// Set new state of long-poll route and answer every waiting client
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|Long Poll")
+	void PublishLongPoll(FString HttpPath, FString Text, FString ContentType = "application/json");
+
+	// Topic bound to HttpPath. Keep it to publish from any thread without the lookup.
+	TSharedPtr<FHttpLongPollTopic> FindLongPoll(FString HttpPath) const;
+
+	// Capture struct on the game thread every tick into a snapshot that handlers on any thread read with AcquireSnapshot.
+	template<typename T>
+	void RegisterSnapshot(FName Name, TFunction<void(T& OutValue)> Capture)
+	{
+		SnapshotPublisher.Register<T>(Name, MoveTemp(Capture));
+	}
+
+	// Capture names and transforms of all actors of ActorClass every tick as FHttpSnapshotActorTransforms
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|Snapshot")
+	void RegisterSnapshotActorTransforms(FName Name, TSubclassOf<AActor> ActorClass);
+
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|Snapshot")
+	void UnregisterSnapshot(FName Name);
+
+	// Latest snapshot of registered data. Lock-free and safe from any thread, so read-only routes don't need the game thread.
+	FHttpSnapshotRef AcquireSnapshot() const { return SnapshotPublisher.Acquire(); }
+
+	// Port of streaming routes. Valid while server is started and has streaming routes.
+	UFUNCTION(BlueprintPure, Category = "Simple HTTP Server")
+	int32 GetStreamServerPort() const;
+
+	// Serve files from DiskPath under UrlPrefix. Works with files packed to pak/IoStore as well.
+	// Files are read on the server thread pool. Supports Range requests and revalidation.
+	// With bStreamLargeFiles, responses of 64 MB and more are redirected to StreamPort and sent in chunks from a memory mapping.
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server")
+	void ServeDirectory(FString UrlPrefix, FString DiskPath, int32 MaxAgeSeconds = 60, bool bStreamLargeFiles = false);
+
+	// Find route for request and handle it. Returns false if no route matched.
+	bool DispatchRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
+
+	// Handle request and pass this to blueprint event. Body is parsed into BodyStruct first if it is set.
+	bool HandleRequest(const TSharedRef<const FSimpleHttpRoute>& Route, const FHttpServerRequest& Request, const FHttpRouteMatch& Match, const UScriptStruct* BodyStruct, uint64 RequestId, const FHttpResultCallback& OnComplete);
+
+	// Handle request and pass this to c++ function. Body is parsed into BodyStruct first if it is set.
+	bool HandleRequestNative(const TSharedRef<const FSimpleHttpRoute>& Route, const FHttpServerRequest& Request, const FHttpRouteMatch& Match, const UScriptStruct* BodyStruct, uint64 RequestId, const FHttpResultCallback& OnComplete);
+
+	// Find streaming route for request and start handling it. Called on the stream server thread.
+	bool DispatchStreamRequest(const TSharedRef<FHttpStreamConnection>& Connection, const FHttpServerRequest& Request);
 
 	// Fill FNativeHttpServerRequest to use it from bluerpints
-	void FillNativeRequst(const FHttpServerRequest& Request, FNativeHttpServerRequest& NativeRequest);
+	void FillNativeRequst(const FHttpServerRequest& Request, const FHttpRouteMatch& Match, FNativeHttpServerRequest& NativeRequest);
+
+	// Same from path params copied out of the match and body bytes taken over. Safe to call from any thread.
+	static void FillNativeRequst(const FHttpServerRequest& Request, TMap<FString, FString>&& PathParams, TArray<uint8>&& BodyBytes, bool bDecodeBody, FNativeHttpServerRequest& NativeRequest);
+
+	UFUNCTION(BlueprintPure, Category = "Simple HTTP Server")
+	FSimpleHttpServerQueueStats GetQueueStats() const;
+
+	// Cache successful GET responses of route. HttpPath must be the same as used for binding.
+	// Cache hits are answered without running the route handler.
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|Cache")
+	void SetRouteCachePolicy(FString HttpPath, FHttpRouteCachePolicy Policy);
+
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|Cache")
+	void RemoveRouteCachePolicy(FString HttpPath);
+
+	// Opt route out of response compression, e.g. for already compressed payloads. HttpPath must be the same as used for binding.
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server")
+	void SetRouteCompressionEnabled(FString HttpPath, bool bEnabled);
+
+	// Parse JSON body of route into BodyStruct on a worker thread before the handler is scheduled. Invalid body is answered with 400
+	// right from the worker. Handlers read the value with Get Request Body Struct or GetBodyStruct. HttpPath must be the same as used for binding.
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server")
+	void SetRouteBodyStruct(FString HttpPath, UScriptStruct* BodyStruct);
+
+	// Serve metrics of all routes in Prometheus text format. Call it from BindRoutes like other routes.
+	// Export runs on a worker thread and doesn't stop recording.
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|Metrics")
+	void BindMetricsRoute(FString HttpPath = "/metrics");
+
+	// Request counters and latency histograms of routes. Kept between server restarts.
+	const TSharedRef<FHttpServerMetrics>& GetMetrics() const { return Metrics; }
+
+	// Write every incoming request with its arrival time to Filename, relative paths are under Saved/.
+	// Replay the file with the SimpleHttpServerReplay commandlet. Replaces a recording in progress.
+	// Servers started with -SimpleHttpRecord=<Filename> start recording on their own.
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|Recording")
+	bool StartTrafficRecording(FString Filename);
+
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|Recording")
+	void StopTrafficRecording();
+
+	UFUNCTION(BlueprintPure, Category = "Simple HTTP Server|Recording")
+	bool IsRecordingTraffic() const { return TrafficRecorder.IsValid(); }
+
+	// Drop cached responses of request path, with any query
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|Cache")
+	void InvalidateCache(FString RequestPath);
+
+	// Drop cached responses of every request path starting with Prefix
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|Cache")
+	void InvalidateCachePrefix(FString Prefix);
+
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server|Cache")
+	void ClearCache();
 
 	// Make response to send this to client
 	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server")
 	FNativeHttpServerResponse MakeResponse(FString Text, FString ContentType = "application/json", int32 Code = 200);
 
+	// Make JSON response from any value. Blueprint structs, arrays and maps are written the same way as in C++.
+	UFUNCTION(BlueprintCallable, CustomThunk, Category = "Simple HTTP Server", meta = (CustomStructureParam = "Value", DisplayName = "Make Json Response"))
+	FNativeHttpServerResponse MakeJsonResponseFromValue(const int32& Value, int32 Code = 200);
+
+	DECLARE_FUNCTION(execMakeJsonResponseFromValue)
+	{
+		Stack.MostRecentProperty = nullptr;
+		Stack.MostRecentPropertyAddress = nullptr;
+		Stack.StepCompiledIn<FProperty>(nullptr);
+		const FProperty* ValueProperty = Stack.MostRecentProperty;
+		const void* ValueAddress = Stack.MostRecentPropertyAddress;
+
+		P_GET_PROPERTY(FIntProperty, Code);
+		P_FINISH;
+
+		P_NATIVE_BEGIN;
+		*(FNativeHttpServerResponse*)RESULT_PARAM = MakeStructResponseFromProperty(EHttpWireFormat::Json, ValueProperty, ValueAddress, Code);
+		P_NATIVE_END;
+	}
+
+	// Make response from any value in the format the client asked for with Accept header: JSON, MessagePack or CBOR
+	UFUNCTION(BlueprintCallable, CustomThunk, Category = "Simple HTTP Server", meta = (CustomStructureParam = "Value", DisplayName = "Make Struct Response"))
+	FNativeHttpServerResponse MakeStructResponseFromValue(const FNativeHttpServerRequest& Request, const int32& Value, int32 Code = 200);
+
+	DECLARE_FUNCTION(execMakeStructResponseFromValue)
+	{
+		P_GET_STRUCT_REF(FNativeHttpServerRequest, Request);
+
+		Stack.MostRecentProperty = nullptr;
+		Stack.MostRecentPropertyAddress = nullptr;
+		Stack.StepCompiledIn<FProperty>(nullptr);
+		const FProperty* ValueProperty = Stack.MostRecentProperty;
+		const void* ValueAddress = Stack.MostRecentPropertyAddress;
+
+		P_GET_PROPERTY(FIntProperty, Code);
+		P_FINISH;
+
+		P_NATIVE_BEGIN;
+		*(FNativeHttpServerResponse*)RESULT_PARAM = MakeNegotiatedResponse(MakeStructResponseFromProperty(Request.ResponseFormat, ValueProperty, ValueAddress, Code));
+		P_NATIVE_END;
+	}
+
+	// Struct written as JSON straight into the response body. Serialization plan of the type is cached on first use.
+	static FNativeHttpServerResponse MakeJsonResponse(const UStruct* Struct, const void* Data, int32 Code = 200)
+	{
+		return MakeStructResponse(EHttpWireFormat::Json, Struct, Data, Code);
+	}
+
+	template<typename T>
+	static FNativeHttpServerResponse MakeJsonResponse(const T& Value, int32 Code = 200)
+	{
+		return MakeStructResponse(EHttpWireFormat::Json, T::StaticStruct(), &Value, Code);
+	}
+
+	// Struct encoded in Format, using the same cached plans for every format
+	static FNativeHttpServerResponse MakeStructResponse(EHttpWireFormat Format, const UStruct* Struct, const void* Data, int32 Code = 200);
+
+	// Struct encoded in the format negotiated from Accept header of Request
+	template<typename T>
+	static FNativeHttpServerResponse MakeStructResponse(const FNativeHttpServerRequestView& Request, const T& Value, int32 Code = 200)
+	{
+		return MakeNegotiatedResponse(MakeStructResponse(Request.GetResponseFormat(), T::StaticStruct(), &Value, Code));
+	}
+
+	static FNativeHttpServerResponse MakeStructResponseFromProperty(EHttpWireFormat Format, const FProperty* Property, const void* Value, int32 Code = 200);
+
+	// Mark response as depending on Accept header, so caches keep one copy per format
+	static FNativeHttpServerResponse MakeNegotiatedResponse(FNativeHttpServerResponse&& Response);
+
 	virtual class UWorld* GetWorld() const override;
 
 protected:
 	void BindRoutes();
 
+	void AddRoute(FString HttpPath, ENativeHttpServerRequestVerbs Verbs, FSimpleHttpRoute&& Route);
+
+	// Queue work that must run on the game thread. It will be executed on tick within GameThreadBudgetMs.
+	void EnqueueGameThreadRequest(TUniqueFunction<void()>&& Work);
+
+	// Queue wait of route handler is measured from here. Does nothing if metrics are off.
+	FHttpHandlerTiming StartHandlerTiming(const FSimpleHttpRoute& Route, uint64 RequestId) const;
+
+	// Run route handler where route asks for. Safe to call from any thread.
+	void ExecuteRoute(EHttpRouteExecution Execution, TUniqueFunction<void()>&& Work);
+
+	void AddStreamRoute(FString HttpPath, ENativeHttpServerRequestVerbs Verbs, FSimpleHttpRoute&& Route);
+
+	void StartStreamServer();
+
+	bool Tick(float DeltaTime);
+
+	// Report frame counters to STAT SimpleHttpServer and CSV profiler
+	void PublishFrameStats(double Now, double HandlersSeconds);
+
 	UFUNCTION(BlueprintImplementableEvent, Meta=(DisplayName="BindRoutes"))
 	void ReceiveBindRoutes();
 
@@ -121,23 +500,155 @@ public:
 	UPROPERTY(BlueprintReadOnly, Category = "Http")
 	int32 CurrentServerPort = 8080;
 
+	// Max game thread time per frame spent in request handlers. The rest of requests is deferred to the next frames.
+	// At least one request is processed each frame. Zero or less means no limit.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	float GameThreadBudgetMs = 0.0f;
+
+	// Decode request body to FNativeHttpServerRequest::Body before calling blueprint event.
+	// Turn off if graphs use Get Request Body functions only, then body is decoded on first access.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	bool bDecodeBodyEagerly = true;
+
+	// Add content hash ETag to successful GET responses that don't set one, so clients can revalidate and get 304 without body.
+	// Bodies over 16 KB and compressed ones are hashed on a worker thread.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	bool bGenerateETags = true;
+
+	// Compress textual responses with gzip or deflate when client accepts it. Compression runs on a worker thread.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	bool bEnableCompression = true;
+
+	// Smaller responses are sent as is
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	int32 CompressionMinSize = 1024;
+
+	// Number of threads in the pool used by routes with ThreadPool execution. Pool is created on first use.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	int32 ThreadPoolSize = 2;
+
+	// Port for streaming routes. Zero means the port next to the server port.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	int32 StreamPort = 0;
+
+	// Event streams send a comment line this often, so proxies keep idle connections and dead clients are noticed
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	float EventStreamKeepAliveSeconds = 15.0f;
+
+	// WebSocket clients with more bytes waiting are handled by WebSocketDropPolicy
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	int32 WebSocketMaxQueuedBytes = 1024 * 1024;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	EHttpWebSocketDropPolicy WebSocketDropPolicy = EHttpWebSocketDropPolicy::DropMessages;
+
+	// Long-poll requests are answered with 204 after this time if state didn't change
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	float LongPollTimeoutSeconds = 25.0f;
+
+	// Count requests, status codes, bytes and handler latency of every route. See BindMetricsRoute.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	bool bRecordMetrics = true;
+
+	// Address the stream server listens on. Use 0.0.0.0 to accept connections from other machines.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	FString StreamBindAddress = TEXT("127.0.0.1");
+
+	// Scheme, host and port clients reach the stream server on, e.g. "https://example.com:8081". Redirects of ServeDirectory point there.
+	// Empty means StreamBindAddress and the stream port, or the request host when the stream server listens on 0.0.0.0.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	FString StreamPublicUrl;
+
+	// Request hosts, without port, that redirects may point to when the stream server listens on 0.0.0.0 and StreamPublicUrl is empty.
+	// Requests with any other host get the file without streaming.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	TArray<FString> StreamAllowedHosts = { TEXT("localhost"), TEXT("127.0.0.1") };
+
+	// Values of these request headers are written as "<redacted>" to traffic recordings. Read when recording starts.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Http")
+	TArray<FString> RecordingRedactedHeaders = { TEXT("authorization"), TEXT("proxy-authorization"), TEXT("cookie") };
+
 protected:
-	// Usualy used for blueprints
-	TMap<FString, FHttpServerRequestDelegate> RouteDelegates;
+	// Bound routes. Trie nodes keep indices into this array.
+	// Shared with handlers in flight, so they don't depend on routes being rebound.
+	TArray<TSharedRef<const FSimpleHttpRoute>> Routes;
 
-	// Usualy used for c++
-	TMap<FString, FHttpRouteHandler> RouteHandlers;
+	FSimpleHttpRouteTrie RouteTrie;
+
+	// Keyed by normalized route pattern. Kept between server restarts.
+	TMap<FString, FHttpRouteCachePolicy> CachePolicies;
 
-	// Keep track of verbs for paths that are handled without route binding (e.g. "/").
-	TMap<FString, ENativeHttpServerRequestVerbs> RouteVerbs;
+	// Routes opted out of compression, by normalized route pattern
+	TSet<FString> CompressionDisabledRoutes;
 
-	// Cached Route Handlers. We should unbing them from route on self destroy
-	TArray<FHttpRouteHandle> CreatedRouteHandlers;
+	// Declared body types by normalized route pattern. Kept between server restarts.
+	UPROPERTY()
+	TMap<FString, TObjectPtr<UScriptStruct>> RouteBodyStructs;
+
+	// Shared with completion callbacks, which can outlive the server
+	TSharedRef<FHttpResponseCache> ResponseCache = MakeShared<FHttpResponseCache>();
+
+	// Shared with completion callbacks and handlers in flight
+	TSharedRef<FHttpServerMetrics> Metrics = MakeShared<FHttpServerMetrics>();
 
 	TSharedPtr<class IHttpRouter> HttpRouter;
 
-	FDelegateHandle RootRequestPreprocessorHandle;
-	bool bRootPreprocessorRegistered = false;
+	// Requests are routed by the plugin from a single HttpRouter preprocessor
+	FDelegateHandle RequestPreprocessorHandle;
+	bool bRequestPreprocessorRegistered = false;
+
+	// Requests waiting to be handled on the game thread. Filled from any thread.
+	TQueue<TUniqueFunction<void()>, EQueueMode::Mpsc> GameThreadQueue;
+	std::atomic<int32> GameThreadQueueDepth{ 0 };
+
+	// Queue positions, so a request waiting several frames is counted as deferred once. Game thread only.
+	uint64 GameThreadDequeued = 0;
+	uint64 GameThreadDeferredUpTo = 0;
+
+	FSimpleHttpServerQueueStats QueueStats;
+
+	FTSTicker::FDelegateHandle TickHandle;
+
+	// Id of the last dispatched request, used by trace events. Dispatch runs on the game thread.
+	uint64 LastRequestId = 0;
+
+	// Set while traffic is recorded. Kept between server restarts.
+	TUniquePtr<FHttpTrafficRecorder> TrafficRecorder;
+
+	// Routed requests since the last tick, for frame stats
+	int32 RequestsThisFrame = 0;
+
+	// Byte rates of frame stats are averaged over about a second, so totals are summed once per window
+	double BytesRateWindowStart = 0.0;
+	uint64 BytesInAtWindowStart = 0;
+	uint64 BytesOutAtWindowStart = 0;
+	float BytesInPerSecond = 0.0f;
+	float BytesOutPerSecond = 0.0f;
+
+	// Streaming routes. Looked up on the stream server thread, so guarded by StreamRoutesLock.
+	TArray<TSharedRef<const FSimpleHttpRoute>> StreamRoutes;
+	FSimpleHttpRouteTrie StreamRouteTrie;
+	FRWLock StreamRoutesLock;
+
+	// Event streams by normalized route pattern
+	TMap<FString, TSharedRef<FHttpEventStream>> EventStreams;
+	double LastKeepAliveTime = 0.0;
+
+	// Long-poll topics by normalized route pattern
+	TMap<FString, TSharedRef<FHttpLongPollTopic>> LongPollTopics;
+
+	// WebSocket channels by normalized route pattern
+	TMap<FString, TSharedRef<FHttpWebSocketChannel>> WebSockets;
+
+	// Published on tick when something is registered. Registrations are kept between server restarts.
+	FHttpSnapshotPublisher SnapshotPublisher;
+
+	// Started with the server when there are streaming routes
+	TUniquePtr<FHttpStreamServer> StreamServer;
+
+	// Pool for routes with ThreadPool execution. Created on first use from any thread.
+	class FQueuedThreadPool* RouteThreadPool = nullptr;
+	FCriticalSection RouteThreadPoolLock;
 
 	bool bServerStarted = false;
 };
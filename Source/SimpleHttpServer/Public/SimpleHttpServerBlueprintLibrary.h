@@ -0,0 +1,59 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "JsonObjectWrapper.h"
+#include "SimpleHttpServer.h"
+
+#include "SimpleHttpServerBlueprintLibrary.generated.h"
+
+UCLASS()
+class SIMPLEHTTPSERVER_API USimpleHttpServerBlueprintLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	// Request body decoded from UTF-8. Decoded on first call and cached for the request.
+	UFUNCTION(BlueprintPure, Category = "Simple HTTP Server")
+	static FString GetRequestBody(const FNativeHttpServerRequest& Request);
+
+	// Raw request body bytes
+	UFUNCTION(BlueprintPure, Category = "Simple HTTP Server")
+	static TArray<uint8> GetRequestBodyBytes(const FNativeHttpServerRequest& Request);
+
+	// Request body parsed as JSON object. Parsed on first call and cached for the request.
+	UFUNCTION(BlueprintPure, Category = "Simple HTTP Server")
+	static bool GetRequestBodyJson(const FNativeHttpServerRequest& Request, FJsonObjectWrapper& OutJson);
+
+	// Copy body parsed for route with Set Route Body Struct. False if route has no body struct or Value is of another type.
+	UFUNCTION(BlueprintCallable, CustomThunk, Category = "Simple HTTP Server", meta = (CustomStructureParam = "Value"))
+	static bool GetRequestBodyStruct(const FNativeHttpServerRequest& Request, int32& Value);
+
+	DECLARE_FUNCTION(execGetRequestBodyStruct)
+	{
+		P_GET_STRUCT_REF(FNativeHttpServerRequest, Request);
+
+		Stack.MostRecentProperty = nullptr;
+		Stack.MostRecentPropertyAddress = nullptr;
+		Stack.StepCompiledIn<FStructProperty>(nullptr);
+		const FStructProperty* ValueProperty = CastField<FStructProperty>(Stack.MostRecentProperty);
+		void* ValueAddress = Stack.MostRecentPropertyAddress;
+
+		P_FINISH;
+
+		P_NATIVE_BEGIN;
+		*(bool*)RESULT_PARAM = CopyRequestBodyStruct(Request, ValueProperty, ValueAddress);
+		P_NATIVE_END;
+	}
+
+	static bool CopyRequestBodyStruct(const FNativeHttpServerRequest& Request, const FStructProperty* ValueProperty, void* ValueAddress);
+
+	// Set ETag of response. Empty ETag is computed from response body.
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server")
+	static void SetResponseETag(UPARAM(ref) FNativeHttpServerResponse& Response, const FString& ETag);
+
+	UFUNCTION(BlueprintCallable, Category = "Simple HTTP Server")
+	static void SetResponseLastModified(UPARAM(ref) FNativeHttpServerResponse& Response, FDateTime LastModified);
+};
@@ -26,6 +26,8 @@ public class SimpleHttpServer : ModuleRules
             new string[]
             {
                 "Core",
+                "Json",
+                "JsonUtilities",
             }
             );
 
@@ -38,7 +40,9 @@ public class SimpleHttpServer : ModuleRules
                 "Slate",
                 "SlateCore",
                 "HTTP",
-                "HTTPServer"
+                "HTTPServer",
+                "Sockets",
+                "Networking"
             }
             );
 
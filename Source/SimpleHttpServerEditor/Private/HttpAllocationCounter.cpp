@@ -0,0 +1,110 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpAllocationCounter.h"
+#include "HAL/MemoryBase.h"
+
+namespace
+{
+	// Per thread, so counting needs no atomics and other threads never show up in the result
+	thread_local bool bCountThread = false;
+	thread_local uint64 ThreadAllocations = 0;
+
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* InInner)
+			: Inner(InInner)
+		{
+		}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->TryMalloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation();
+			return Inner->TryRealloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override
+		{
+			Inner->Free(Original);
+		}
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void InitializeStatsMetadata() override { Inner->InitializeStatsMetadata(); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+		virtual void UpdateStats() override { Inner->UpdateStats(); }
+		virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+	private:
+		static void CountAllocation()
+		{
+			if (bCountThread)
+			{
+				++ThreadAllocations;
+			}
+		}
+
+		FMalloc* Inner;
+	};
+
+	FCountingMalloc* CountingMalloc = nullptr;
+}
+
+void FHttpAllocationCounter::Install()
+{
+	check(IsInGameThread());
+
+	if (CountingMalloc)
+	{
+		return;
+	}
+
+	// Never removed or deleted, blocks allocated through it are freed long after the benchmark
+	CountingMalloc = new FCountingMalloc(GMalloc);
+	GMalloc = CountingMalloc;
+}
+
+bool FHttpAllocationCounter::IsInstalled()
+{
+	return CountingMalloc != nullptr;
+}
+
+FHttpAllocationCounter::FScope::FScope()
+{
+	ThreadAllocations = 0;
+	bCountThread = true;
+}
+
+FHttpAllocationCounter::FScope::~FScope()
+{
+	bCountThread = false;
+}
+
+uint64 FHttpAllocationCounter::FScope::GetCount() const
+{
+	return ThreadAllocations;
+}
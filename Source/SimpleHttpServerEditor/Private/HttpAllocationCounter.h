@@ -0,0 +1,33 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Counts allocations made by one thread, used by the benchmark commandlet for server allocations per request.
+ * The counting allocator wraps GMalloc once when the editor module starts, before the benchmark starts any thread, and is never removed.
+ * Only threads inside FScope count, so engine workers and benchmark clients don't add to the result.
+ */
+class FHttpAllocationCounter
+{
+public:
+	// Wrap GMalloc. Does nothing if already installed.
+	static void Install();
+
+	static bool IsInstalled();
+
+	// Allocations of the calling thread are counted while it is alive, starting from zero
+	class FScope
+	{
+	public:
+		FScope();
+		~FScope();
+
+		FScope(const FScope&) = delete;
+		FScope& operator=(const FScope&) = delete;
+
+		// Allocations of this thread since the scope started
+		uint64 GetCount() const;
+	};
+};
@@ -0,0 +1,171 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "HttpLoopbackClient.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "String/Find.h"
+
+FHttpLoopbackConnection::FHttpLoopbackConnection(const TSharedRef<FInternetAddr>& InAddress)
+	: Address(InAddress)
+{
+	Buffer.Reserve(64 * 1024);
+}
+
+FHttpLoopbackConnection::~FHttpLoopbackConnection()
+{
+	Close();
+}
+
+TSharedPtr<FInternetAddr> FHttpLoopbackConnection::MakeAddress(const FString& Host, int32 Port)
+{
+	TSharedRef<FInternetAddr> Result = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+
+	bool bValidIp = false;
+	Result->SetIp(*Host, bValidIp);
+	if (!bValidIp)
+	{
+		return nullptr;
+	}
+
+	Result->SetPort(Port);
+	return Result;
+}
+
+int32 FHttpLoopbackConnection::RoundTrip(TArrayView<const uint8> RequestBytes)
+{
+	// Server may close idle keep-alive connections, so one retry on a fresh connection
+	for (int32 Attempt = 0; Attempt < 2; ++Attempt)
+	{
+		if (!Socket && !Connect())
+		{
+			return 0;
+		}
+
+		bool bClose = false;
+		int32 Code = 0;
+		if (SendAll(RequestBytes) && ReadResponse(Code, bClose))
+		{
+			if (bClose)
+			{
+				Close();
+			}
+
+			return Code;
+		}
+
+		Close();
+	}
+
+	return 0;
+}
+
+bool FHttpLoopbackConnection::Connect()
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	Socket = SocketSubsystem->CreateSocket(NAME_Stream, TEXT("SimpleHttpServerLoopbackClient"), false);
+	if (!Socket)
+	{
+		return false;
+	}
+
+	Socket->SetNoDelay(true);
+	if (!Socket->Connect(*Address))
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void FHttpLoopbackConnection::Close()
+{
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+
+	Buffer.Reset();
+}
+
+bool FHttpLoopbackConnection::SendAll(TArrayView<const uint8> Bytes)
+{
+	int32 Offset = 0;
+	while (Offset < Bytes.Num())
+	{
+		int32 BytesSent = 0;
+		if (!Socket->Send(Bytes.GetData() + Offset, Bytes.Num() - Offset, BytesSent))
+		{
+			return false;
+		}
+
+		Offset += BytesSent;
+	}
+
+	return true;
+}
+
+bool FHttpLoopbackConnection::Receive()
+{
+	if (!Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromSeconds(10.0)))
+	{
+		return false;
+	}
+
+	uint8 Chunk[16 * 1024];
+	int32 BytesRead = 0;
+	if (!Socket->Recv(Chunk, sizeof(Chunk), BytesRead) || BytesRead <= 0)
+	{
+		return false;
+	}
+
+	Buffer.Append(Chunk, BytesRead);
+	return true;
+}
+
+bool FHttpLoopbackConnection::ReadResponse(int32& OutCode, bool& bOutClose)
+{
+	int32 HeadEnd = INDEX_NONE;
+	while (HeadEnd == INDEX_NONE)
+	{
+		const FAnsiStringView Received(reinterpret_cast<const ANSICHAR*>(Buffer.GetData()), Buffer.Num());
+		HeadEnd = UE::String::FindFirst(Received, "\r\n\r\n");
+		if (HeadEnd == INDEX_NONE && !Receive())
+		{
+			return false;
+		}
+	}
+
+	const FAnsiStringView Head(reinterpret_cast<const ANSICHAR*>(Buffer.GetData()), HeadEnd + 2);
+
+	// "HTTP/1.1 200 OK"
+	if (Head.Len() < 12)
+	{
+		return false;
+	}
+	OutCode = FCStringAnsi::Atoi(Head.GetData() + 9);
+
+	int64 ContentLength = 0;
+	const int32 LengthPos = UE::String::FindFirst(Head, "\r\ncontent-length:", ESearchCase::IgnoreCase);
+	if (LengthPos != INDEX_NONE)
+	{
+		ContentLength = FCStringAnsi::Atoi64(Head.GetData() + LengthPos + 17);
+	}
+
+	bOutClose = UE::String::FindFirst(Head, "\r\nconnection: close", ESearchCase::IgnoreCase) != INDEX_NONE;
+
+	const int64 ResponseSize = HeadEnd + 4 + ContentLength;
+	while (Buffer.Num() < ResponseSize)
+	{
+		if (!Receive())
+		{
+			return false;
+		}
+	}
+
+	// Closed loop client, nothing should follow the response
+	Buffer.RemoveAt(0, (int32)ResponseSize, false);
+	return true;
+}
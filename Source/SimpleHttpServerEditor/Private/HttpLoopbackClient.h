@@ -0,0 +1,51 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IPAddress.h"
+
+class FSocket;
+
+/**
+ * Blocking keep-alive HTTP/1.1 client connection used by the benchmark and replay commandlets.
+ * Sends prebuilt requests and reads responses with content-length. Reconnects when the server closes it.
+ */
+class FHttpLoopbackConnection
+{
+public:
+	explicit FHttpLoopbackConnection(const TSharedRef<FInternetAddr>& InAddress);
+	~FHttpLoopbackConnection();
+
+	FHttpLoopbackConnection(const FHttpLoopbackConnection&) = delete;
+	FHttpLoopbackConnection& operator=(const FHttpLoopbackConnection&) = delete;
+
+	// Send request and read whole response. Status code, or zero if the server couldn't be reached.
+	int32 RoundTrip(TArrayView<const uint8> RequestBytes);
+
+	// Null if Host isn't a valid IP address
+	static TSharedPtr<FInternetAddr> MakeAddress(const FString& Host, int32 Port);
+
+private:
+	bool Connect();
+	void Close();
+	bool SendAll(TArrayView<const uint8> Bytes);
+	bool Receive();
+	bool ReadResponse(int32& OutCode, bool& bOutClose);
+
+	TSharedRef<FInternetAddr> Address;
+	FSocket* Socket = nullptr;
+	TArray<uint8> Buffer;
+};
+
+// Latency at Fraction of sorted cycle counts, in milliseconds
+inline double GetLatencyPercentileMs(const TArray<uint64>& SortedCycles, double Fraction)
+{
+	if (SortedCycles.Num() == 0)
+	{
+		return 0.0;
+	}
+
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * SortedCycles.Num()) - 1, 0, SortedCycles.Num() - 1);
+	return FPlatformTime::ToMilliseconds64(SortedCycles[Index]);
+}
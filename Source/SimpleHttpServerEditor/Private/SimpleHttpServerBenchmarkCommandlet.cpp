@@ -0,0 +1,279 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "SimpleHttpServerBenchmarkCommandlet.h"
+#include "HttpLoopbackClient.h"
+#include "HttpAllocationCounter.h"
+#include "HttpResponseBuilder.h"
+#include "Async/Async.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Ticker.h"
+#include "Misc/Parse.h"
+#include "ProfilingDebugging/MiscTrace.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSimpleHttpServerBenchmark, Log, All);
+
+namespace
+{
+	struct FBenchmarkScenario
+	{
+		FString Name;
+
+		// Whole request with headers, sent as is on every round trip
+		TArray<uint8> RequestBytes;
+
+		int32 ExpectedCode = 200;
+	};
+
+	FBenchmarkScenario MakeScenario(const TCHAR* Name, const TCHAR* Verb, const TCHAR* Path, int32 ExpectedCode, FStringView Body = FStringView())
+	{
+		TArray<uint8> BodyBytes;
+		FHttpResponseBuilder::AppendUtf8(BodyBytes, Body);
+
+		FBenchmarkScenario Scenario;
+		Scenario.Name = Name;
+		Scenario.ExpectedCode = ExpectedCode;
+
+		const FString Head = FString::Printf(TEXT("%s %s HTTP/1.1\r\nhost: 127.0.0.1\r\ncontent-type: application/json\r\ncontent-length: %d\r\n\r\n"), Verb, Path, BodyBytes.Num());
+		FHttpResponseBuilder::AppendUtf8(Scenario.RequestBytes, Head);
+		Scenario.RequestBytes.Append(BodyBytes);
+		return Scenario;
+	}
+
+	struct FClientResult
+	{
+		TArray<uint64> LatencyCycles;
+		int32 Errors = 0;
+	};
+
+	// Clients warm up, then wait until all of them are ready so measurement starts at once
+	struct FClientSync
+	{
+		std::atomic<int32> Remaining{ 0 };
+		std::atomic<int32> Ready{ 0 };
+		std::atomic<bool> bStart{ false };
+	};
+
+	// One connection sending requests back to back until the shared budget is spent
+	FClientResult RunClient(const TSharedRef<FInternetAddr>& Address, const FBenchmarkScenario& Scenario, int32 Warmup, FClientSync& Sync)
+	{
+		FHttpLoopbackConnection Connection(Address);
+		FClientResult Result;
+
+		for (int32 Index = 0; Index < Warmup; ++Index)
+		{
+			Connection.RoundTrip(Scenario.RequestBytes);
+		}
+
+		++Sync.Ready;
+		while (!Sync.bStart.load())
+		{
+			FPlatformProcess::Sleep(0.0f);
+		}
+
+		while (Sync.Remaining.fetch_sub(1, std::memory_order_relaxed) > 0)
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			const int32 Code = Connection.RoundTrip(Scenario.RequestBytes);
+			Result.LatencyCycles.Add(FPlatformTime::Cycles64() - StartCycles);
+
+			if (Code != Scenario.ExpectedCode)
+			{
+				++Result.Errors;
+			}
+		}
+
+		return Result;
+	}
+}
+
+USimpleHttpServerBenchmarkCommandlet::USimpleHttpServerBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+FNativeHttpServerResponse USimpleHttpServerBenchmarkCommandlet::HandleTiny(FNativeHttpServerRequest Request)
+{
+	return Server->MakeResponse(TEXT("ok"), TEXT("text/plain"));
+}
+
+FNativeHttpServerResponse USimpleHttpServerBenchmarkCommandlet::HandleEcho(FNativeHttpServerRequest Request)
+{
+	return Server->MakeResponse(Request.GetBodyString());
+}
+
+FNativeHttpServerResponse USimpleHttpServerBenchmarkCommandlet::HandleLarge(FNativeHttpServerRequest Request)
+{
+	return Server->MakeResponse(LargeText, TEXT("text/plain"));
+}
+
+FNativeHttpServerResponse USimpleHttpServerBenchmarkCommandlet::HandleItem(FNativeHttpServerRequest Request)
+{
+	return Server->MakeResponse(FString::Printf(TEXT("{\"id\":\"%s\",\"tag\":\"%s\"}"), *Request.PathParams.FindRef(TEXT("id")), *Request.PathParams.FindRef(TEXT("tag"))));
+}
+
+void USimpleHttpServerBenchmarkCommandlet::BindRoutes()
+{
+	auto BindHandler = [this](const TCHAR* Path, ENativeHttpServerRequestVerbs Verbs, FName FunctionName)
+	{
+		FHttpServerRequestDelegate Delegate;
+		Delegate.BindUFunction(this, FunctionName);
+		Server->BindRoute(Path, Verbs, Delegate);
+	};
+
+	BindHandler(TEXT("/bench/tiny"), ENativeHttpServerRequestVerbs::GET, GET_FUNCTION_NAME_CHECKED(USimpleHttpServerBenchmarkCommandlet, HandleTiny));
+	BindHandler(TEXT("/bench/echo"), ENativeHttpServerRequestVerbs::POST, GET_FUNCTION_NAME_CHECKED(USimpleHttpServerBenchmarkCommandlet, HandleEcho));
+	BindHandler(TEXT("/bench/large"), ENativeHttpServerRequestVerbs::GET, GET_FUNCTION_NAME_CHECKED(USimpleHttpServerBenchmarkCommandlet, HandleLarge));
+	BindHandler(TEXT("/bench/items/:id/tags/:tag"), ENativeHttpServerRequestVerbs::GET, GET_FUNCTION_NAME_CHECKED(USimpleHttpServerBenchmarkCommandlet, HandleItem));
+
+	// Same tiny response without FillNativeRequst, to tell Blueprint route overhead from the transport
+	Server->BindRouteNative(TEXT("/bench/native"), ENativeHttpServerRequestVerbs::GET, [](const FNativeHttpServerRequestView& Request, FHttpRouteCompletion Completion)
+	{
+		Completion.Complete(FHttpResponseBuilder().SetTextContentType(TEXT("text/plain")).Append(FStringView(TEXT("ok"))).Build());
+	});
+}
+
+void USimpleHttpServerBenchmarkCommandlet::PumpGameThread()
+{
+	const double Now = FPlatformTime::Seconds();
+
+	FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+	FTSTicker::GetCoreTicker().Tick((float)(Now - LastPumpTime));
+
+	LastPumpTime = Now;
+}
+
+int32 USimpleHttpServerBenchmarkCommandlet::Main(const FString& Params)
+{
+	int32 Port = 9180;
+	int32 Connections = 8;
+	int32 Requests = 20000;
+	int32 Warmup = 200;
+	float FrameMs = 0.0f;
+	FString ScenarioFilter;
+	FParse::Value(*Params, TEXT("Port="), Port);
+	FParse::Value(*Params, TEXT("Connections="), Connections);
+	FParse::Value(*Params, TEXT("Requests="), Requests);
+	FParse::Value(*Params, TEXT("Warmup="), Warmup);
+	FParse::Value(*Params, TEXT("FrameMs="), FrameMs);
+	FParse::Value(*Params, TEXT("Scenario="), ScenarioFilter);
+
+	Connections = FMath::Max(Connections, 1);
+
+	// Installed by the editor module at startup unless -NoAllocs is set
+	const bool bCountAllocations = FHttpAllocationCounter::IsInstalled();
+	if (!bCountAllocations && !FParse::Param(*Params, TEXT("NoAllocs")))
+	{
+		UE_LOG(LogSimpleHttpServerBenchmark, Warning, TEXT("Allocation counter isn't installed, allocs/req is not reported."));
+	}
+
+	LargeText = FString::ChrN(1024 * 1024, TEXT('x'));
+
+	Server = NewObject<USimpleHttpServer>(this);
+	BindRoutes();
+	Server->StartServer(Port);
+
+	if (!Server->IsServerStarted())
+	{
+		UE_LOG(LogSimpleHttpServerBenchmark, Error, TEXT("Benchmark server could not start on port %d"), Port);
+		return 1;
+	}
+
+	const FString EchoBody = TEXT("{\"name\":\"benchmark\",\"position\":{\"x\":1.5,\"y\":-20.25,\"z\":300},\"tags\":[\"alpha\",\"beta\",\"gamma\"],\"health\":100,\"active\":true}");
+
+	TArray<FBenchmarkScenario> Scenarios;
+	Scenarios.Add(MakeScenario(TEXT("tiny_get"), TEXT("GET"), TEXT("/bench/tiny"), 200));
+	Scenarios.Add(MakeScenario(TEXT("tiny_native"), TEXT("GET"), TEXT("/bench/native"), 200));
+	Scenarios.Add(MakeScenario(TEXT("json_echo"), TEXT("POST"), TEXT("/bench/echo"), 200, EchoBody));
+	Scenarios.Add(MakeScenario(TEXT("large_1mb"), TEXT("GET"), TEXT("/bench/large"), 200));
+	Scenarios.Add(MakeScenario(TEXT("path_params"), TEXT("GET"), TEXT("/bench/items/42/tags/red"), 200));
+	Scenarios.Add(MakeScenario(TEXT("not_found"), TEXT("GET"), TEXT("/bench/missing"), 404));
+
+	const TSharedRef<FInternetAddr> Address = FHttpLoopbackConnection::MakeAddress(TEXT("127.0.0.1"), Port).ToSharedRef();
+
+	LastPumpTime = FPlatformTime::Seconds();
+
+	int32 TotalErrors = 0;
+	for (const FBenchmarkScenario& Scenario : Scenarios)
+	{
+		if (!ScenarioFilter.IsEmpty() && !Scenario.Name.Contains(ScenarioFilter))
+		{
+			continue;
+		}
+
+		FClientSync Sync;
+		Sync.Remaining = Requests;
+
+		TArray<TFuture<FClientResult>> Clients;
+		for (int32 Index = 0; Index < Connections; ++Index)
+		{
+			Clients.Add(Async(EAsyncExecution::Thread, [&Address, &Scenario, Warmup, &Sync]()
+			{
+				return RunClient(Address, Scenario, Warmup, Sync);
+			}));
+		}
+
+		auto PumpUntil = [this, FrameMs](TFunctionRef<bool()> IsDone)
+		{
+			while (!IsDone())
+			{
+				PumpGameThread();
+
+				if (FrameMs > 0.0f)
+				{
+					FPlatformProcess::Sleep(FrameMs / 1000.0f);
+				}
+			}
+		};
+
+		PumpUntil([&Sync, Connections]() { return Sync.Ready.load() == Connections; });
+
+		// Responses of warmup requests may still be finishing on the server, let them through before counting
+		PumpGameThread();
+
+		// Callstacks of these allocations are in memory trace between the bookmarks, e.g. with -trace=default,memalloc
+		TRACE_BOOKMARK(TEXT("SimpleHttpServerBenchmark %s begin"), *Scenario.Name);
+
+		double Seconds = 0.0;
+		uint64 Allocations = 0;
+		{
+			// Server work runs on this thread while it pumps, clients and engine workers aren't counted
+			FHttpAllocationCounter::FScope AllocationScope;
+
+			const double StartTime = FPlatformTime::Seconds();
+			Sync.bStart = true;
+
+			PumpUntil([&Clients]() { return !Clients.ContainsByPredicate([](const TFuture<FClientResult>& Client) { return !Client.IsReady(); }); });
+
+			Seconds = FPlatformTime::Seconds() - StartTime;
+			Allocations = AllocationScope.GetCount();
+		}
+
+		TRACE_BOOKMARK(TEXT("SimpleHttpServerBenchmark %s end"), *Scenario.Name);
+
+		TArray<uint64> Latencies;
+		Latencies.Reserve(Requests);
+		int32 Errors = 0;
+		for (TFuture<FClientResult>& Client : Clients)
+		{
+			FClientResult Result = Client.Get();
+			Latencies.Append(Result.LatencyCycles);
+			Errors += Result.Errors;
+		}
+
+		Latencies.Sort();
+		TotalErrors += Errors;
+
+		const FString AllocationsPerRequest = bCountAllocations && Latencies.Num() > 0 ? FString::Printf(TEXT("%7.1f"), (double)Allocations / Latencies.Num()) : FString(TEXT("    n/a"));
+
+		UE_LOG(LogSimpleHttpServerBenchmark, Display, TEXT("%-12s %7d requests  %9.0f req/s  p50 %7.3f ms  p99 %7.3f ms  max %8.3f ms  allocs/req %s  errors %d"),
+			*Scenario.Name, Latencies.Num(), Latencies.Num() / Seconds, GetLatencyPercentileMs(Latencies, 0.5), GetLatencyPercentileMs(Latencies, 0.99), GetLatencyPercentileMs(Latencies, 1.0),
+			*AllocationsPerRequest, Errors);
+	}
+
+	Server->StopServer();
+
+	return TotalErrors > 0 ? 1 : 0;
+}
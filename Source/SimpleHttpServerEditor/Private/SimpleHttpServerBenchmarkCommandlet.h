@@ -0,0 +1,56 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SimpleHttpServer.h"
+
+#include "SimpleHttpServerBenchmarkCommandlet.generated.h"
+
+/**
+ * Starts a server on loopback with a fixed set of routes and drives it with concurrent keep-alive clients.
+ * Reports p50/p99 latency, throughput and game thread allocations per request for every scenario.
+ * Measured part of each scenario is marked with trace bookmarks, so allocation callstacks can be read from memory trace between them.
+ *
+ * UnrealEditor-Cmd Project -run=SimpleHttpServerBenchmark [-Port=9180] [-Connections=8] [-Requests=20000] [-Warmup=200]
+ *     [-FrameMs=0] [-Scenario=name] [-NoAllocs]
+ *
+ * FrameMs sleeps between game thread ticks to model a frame rate, zero ticks as fast as possible.
+ */
+UCLASS()
+class USimpleHttpServerBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USimpleHttpServerBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	UFUNCTION()
+	FNativeHttpServerResponse HandleTiny(FNativeHttpServerRequest Request);
+
+	UFUNCTION()
+	FNativeHttpServerResponse HandleEcho(FNativeHttpServerRequest Request);
+
+	UFUNCTION()
+	FNativeHttpServerResponse HandleLarge(FNativeHttpServerRequest Request);
+
+	UFUNCTION()
+	FNativeHttpServerResponse HandleItem(FNativeHttpServerRequest Request);
+
+	void BindRoutes();
+
+	// Run HTTPServer listeners, server tick and game thread tasks once
+	void PumpGameThread();
+
+	UPROPERTY()
+	TObjectPtr<USimpleHttpServer> Server;
+
+	// Body of the large response route
+	FString LargeText;
+
+	double LastPumpTime = 0.0;
+};
@@ -0,0 +1,24 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "Modules/ModuleManager.h"
+#include "HttpAllocationCounter.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+
+class FSimpleHttpServerEditorModule : public IModuleInterface
+{
+public:
+	virtual void StartupModule() override
+	{
+		// Benchmark counts server allocations, the counter goes in before the commandlet starts any thread
+		FString Commandlet;
+		if (FParse::Value(FCommandLine::Get(), TEXT("-run="), Commandlet)
+			&& Commandlet.StartsWith(TEXT("SimpleHttpServerBenchmark"))
+			&& !FParse::Param(FCommandLine::Get(), TEXT("NoAllocs")))
+		{
+			FHttpAllocationCounter::Install();
+		}
+	}
+};
+
+IMPLEMENT_MODULE(FSimpleHttpServerEditorModule, SimpleHttpServerEditor)
@@ -0,0 +1,173 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#include "SimpleHttpServerReplayCommandlet.h"
+#include "SimpleHttpServer.h"
+#include "HttpLoopbackClient.h"
+#include "HttpTrafficRecording.h"
+#include "Async/Async.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSimpleHttpServerReplay, Log, All);
+
+namespace
+{
+	struct FReplayRequest
+	{
+		TArray<uint8> RequestBytes;
+
+		// Since replay start, already scaled by speed
+		double DueSeconds = 0.0;
+	};
+
+	struct FReplayResult
+	{
+		TArray<uint64> LatencyCycles;
+		int32 Errors = 0;
+
+		// Worst delay between due time and send, shows when the server or client can't keep up
+		double MaxLateSeconds = 0.0;
+	};
+
+	// Connections take requests in recorded order, so a single connection replays deterministically
+	FReplayResult RunReplayClient(const TSharedRef<FInternetAddr>& Address, const TArray<FReplayRequest>& Requests, std::atomic<int32>& NextIndex, double StartTime, bool bMaxSpeed)
+	{
+		FHttpLoopbackConnection Connection(Address);
+		FReplayResult Result;
+
+		for (int32 Index = NextIndex++; Index < Requests.Num(); Index = NextIndex++)
+		{
+			const FReplayRequest& Request = Requests[Index];
+
+			if (!bMaxSpeed)
+			{
+				const double Wait = StartTime + Request.DueSeconds - FPlatformTime::Seconds();
+				if (Wait > 0.0)
+				{
+					FPlatformProcess::Sleep((float)Wait);
+				}
+
+				Result.MaxLateSeconds = FMath::Max(Result.MaxLateSeconds, FPlatformTime::Seconds() - StartTime - Request.DueSeconds);
+			}
+
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			const int32 Code = Connection.RoundTrip(Request.RequestBytes);
+			Result.LatencyCycles.Add(FPlatformTime::Cycles64() - StartCycles);
+
+			// Recorded 4xx are part of the traffic, only unreachable server and server errors count
+			if (Code == 0 || Code >= 500)
+			{
+				++Result.Errors;
+			}
+		}
+
+		return Result;
+	}
+}
+
+USimpleHttpServerReplayCommandlet::USimpleHttpServerReplayCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 USimpleHttpServerReplayCommandlet::Main(const FString& Params)
+{
+	FString Filename;
+	FString Host = TEXT("127.0.0.1");
+	int32 Port = 9080;
+	int32 Connections = 8;
+	float Speed = 1.0f;
+	FParse::Value(*Params, TEXT("File="), Filename);
+	FParse::Value(*Params, TEXT("Host="), Host);
+	FParse::Value(*Params, TEXT("Port="), Port);
+	FParse::Value(*Params, TEXT("Connections="), Connections);
+	FParse::Value(*Params, TEXT("Speed="), Speed);
+	const bool bMaxSpeed = FParse::Param(*Params, TEXT("Max")) || Speed <= 0.0f;
+
+	Connections = FMath::Max(Connections, 1);
+
+	if (Filename.IsEmpty())
+	{
+		UE_LOG(LogSimpleHttpServerReplay, Error, TEXT("Replay needs -File=<recording>"));
+		return 1;
+	}
+
+	if (FPaths::IsRelative(Filename))
+	{
+		Filename = FPaths::Combine(FPaths::ProjectSavedDir(), Filename);
+	}
+
+	TArray<FHttpRecordedRequest> Recorded;
+	FString LoadError;
+	if (!FHttpTrafficRecorder::Load(Filename, Recorded, LoadError))
+	{
+		UE_LOG(LogSimpleHttpServerReplay, Error, TEXT("%s"), *LoadError);
+		return 1;
+	}
+
+	if (!LoadError.IsEmpty())
+	{
+		UE_LOG(LogSimpleHttpServerReplay, Warning, TEXT("%s, replaying %d complete requests"), *LoadError, Recorded.Num());
+	}
+
+	const TSharedPtr<FInternetAddr> Address = FHttpLoopbackConnection::MakeAddress(Host, Port);
+	if (!Address.IsValid())
+	{
+		UE_LOG(LogSimpleHttpServerReplay, Error, TEXT("'%s' isn't a valid IP address"), *Host);
+		return 1;
+	}
+
+	// Build every request up front so replay timing isn't skewed by formatting
+	const FString HostHeader = FString::Printf(TEXT("%s:%d"), *Host, Port);
+	TArray<FReplayRequest> Requests;
+	Requests.Reserve(Recorded.Num());
+
+	uint64 DueMicroseconds = 0;
+	for (const FHttpRecordedRequest& Request : Recorded)
+	{
+		DueMicroseconds += Request.DelayMicroseconds;
+
+		FReplayRequest& Replay = Requests.AddDefaulted_GetRef();
+		Replay.RequestBytes = Request.MakeRequestBytes(HostHeader);
+		Replay.DueSeconds = DueMicroseconds / 1000000.0 / Speed;
+	}
+
+	UE_LOG(LogSimpleHttpServerReplay, Display, TEXT("Replaying %d requests from '%s' to %s with %d connections at %s"),
+		Requests.Num(), *Filename, *HostHeader, Connections, bMaxSpeed ? TEXT("max speed") : *FString::Printf(TEXT("%gx"), Speed));
+
+	std::atomic<int32> NextIndex{ 0 };
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<TFuture<FReplayResult>> Clients;
+	for (int32 Index = 0; Index < Connections; ++Index)
+	{
+		Clients.Add(Async(EAsyncExecution::Thread, [&Address, &Requests, &NextIndex, StartTime, bMaxSpeed]()
+		{
+			return RunReplayClient(Address.ToSharedRef(), Requests, NextIndex, StartTime, bMaxSpeed);
+		}));
+	}
+
+	TArray<uint64> Latencies;
+	Latencies.Reserve(Requests.Num());
+	int32 Errors = 0;
+	double MaxLateSeconds = 0.0;
+	for (TFuture<FReplayResult>& Client : Clients)
+	{
+		FReplayResult Result = Client.Get();
+		Latencies.Append(Result.LatencyCycles);
+		Errors += Result.Errors;
+		MaxLateSeconds = FMath::Max(MaxLateSeconds, Result.MaxLateSeconds);
+	}
+
+	const double Seconds = FPlatformTime::Seconds() - StartTime;
+	Latencies.Sort();
+
+	UE_LOG(LogSimpleHttpServerReplay, Display, TEXT("%d requests in %.2f s  %9.0f req/s  p50 %7.3f ms  p99 %7.3f ms  max %8.3f ms  max late %8.3f ms  errors %d"),
+		Latencies.Num(), Seconds, Seconds > 0.0 ? Latencies.Num() / Seconds : 0.0, GetLatencyPercentileMs(Latencies, 0.5), GetLatencyPercentileMs(Latencies, 0.99),
+		GetLatencyPercentileMs(Latencies, 1.0), MaxLateSeconds * 1000.0, Errors);
+
+	return Errors > 0 ? 1 : 0;
+}
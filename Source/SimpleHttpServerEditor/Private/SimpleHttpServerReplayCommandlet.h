@@ -0,0 +1,28 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "SimpleHttpServerReplayCommandlet.generated.h"
+
+/**
+ * Plays a traffic recording back against a running server with keep-alive clients.
+ * Requests are sent in recorded order, at recorded inter-arrival times scaled by Speed or as fast as possible with -Max.
+ *
+ * UnrealEditor-Cmd Project -run=SimpleHttpServerReplay -File=Recording.shtr [-Host=127.0.0.1] [-Port=9080] [-Connections=8]
+ *     [-Speed=1] [-Max]
+ *
+ * Relative file paths are under Saved/, same as USimpleHttpServer::StartTrafficRecording.
+ */
+UCLASS()
+class USimpleHttpServerReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USimpleHttpServerReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,25 @@
+// Copyright (C) 2024 Mikhail Davydov (kaboms) - All Rights Reserved
+
+using UnrealBuildTool;
+
+// Benchmark and replay commandlets, kept out of packaged games
+public class SimpleHttpServerEditor : ModuleRules
+{
+    public SimpleHttpServerEditor(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        PrivateDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "Core",
+                "CoreUObject",
+                "Engine",
+                "HTTPServer",
+                "Sockets",
+                "Networking",
+                "SimpleHttpServer"
+            }
+            );
+    }
+}